@@ -0,0 +1,391 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Benchmark of media_src_storage and frame boundary search on generated MJPEG files.
+ *
+ * Files are read the same way as the player does: read one buffer, find SOI and EOI, seek to the next frame.
+ * Calls of read() and lseek() from storage are counted by linker wrapping (-Wl,--wrap).
+ * Files are generated to the temporary directory, so they are mostly in page cache and the benchmark measures
+ * the CPU and system call cost of the path, not the card speed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "media_src_storage.h"
+#include "mjpeg_parser.h"
+
+#define BENCH_BUFF_SIZE     (540 * 960)     /* Same as video buffer in the example */
+#define BENCH_FRAMES        (60)
+#define BENCH_ITERATIONS    (3)
+#define BENCH_SEED          (0x12345678)
+
+typedef struct {
+    const char  *name;
+    uint32_t    width;
+    uint32_t    height;
+} bench_resolution_t;
+
+typedef struct {
+    const char  *name;
+    float       bytes_per_pixel;    /* Average compressed size */
+} bench_quality_t;
+
+typedef struct {
+    uint64_t    read_calls;
+    uint64_t    read_bytes;
+    uint64_t    seek_calls;
+} bench_counters_t;
+
+typedef struct {
+    uint32_t    frames;
+    uint64_t    frame_bytes;    /* Sum of found frames */
+    uint64_t    copied_bytes;   /* Returned by media_src_storage_read */
+    double      seconds;
+    bench_counters_t io;
+} bench_result_t;
+
+static const bench_resolution_t resolutions[] = {
+    {"320x240", 320, 240},
+    {"800x450", 800, 450},
+    {"1280x720", 1280, 720},
+    {"1920x1080", 1920, 1080},
+};
+
+static const bench_quality_t qualities[] = {
+    {"high", 0.20f},
+    {"mid", 0.10f},
+    {"low", 0.05f},
+};
+
+static bench_counters_t counters;
+static uint32_t rand_state = BENCH_SEED;
+
+/* File system calls of storage */
+ssize_t __real_read(int fd, void *buf, size_t count);
+off_t __real_lseek(int fd, off_t offset, int whence);
+
+ssize_t __wrap_read(int fd, void *buf, size_t count)
+{
+    ssize_t n = __real_read(fd, buf, count);
+    counters.read_calls++;
+    if (n > 0) {
+        counters.read_bytes += n;
+    }
+    return n;
+}
+
+off_t __wrap_lseek(int fd, off_t offset, int whence)
+{
+    counters.seek_calls++;
+    return __real_lseek(fd, offset, whence);
+}
+
+/* xorshift32, fixtures are the same in every run */
+static uint32_t bench_rand(void)
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static double bench_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* One frame: SOI, APP0 header, entropy coded data with byte stuffing (no markers inside), EOI */
+static size_t bench_make_frame(uint8_t *buf, size_t size)
+{
+    static const uint8_t header[] = {0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                     0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+    size_t len = sizeof(header);
+    memcpy(buf, header, len);
+    while (len < size - 2) {
+        uint8_t byte = bench_rand();
+        buf[len++] = byte;
+        if (byte == 0xff && len < size - 2) {
+            buf[len++] = 0x00;
+        }
+    }
+    buf[len++] = 0xff;
+    buf[len++] = 0xd9;
+    return len;
+}
+
+static int bench_make_file(const char *path, const bench_resolution_t *res, const bench_quality_t *quality, uint32_t frames, size_t max_frame)
+{
+    const size_t avg = res->width * res->height * quality->bytes_per_pixel;
+    uint8_t *frame = malloc(max_frame);
+    FILE *f = fopen(path, "wb");
+    if (frame == NULL || f == NULL) {
+        free(frame);
+        if (f) {
+            fclose(f);
+        }
+        return -1;
+    }
+    for (uint32_t i = 0; i < frames; i++) {
+        /* Frame size varies +-20 % around average */
+        size_t size = avg * 8 / 10 + bench_rand() % (avg * 4 / 10 + 1);
+        if (size > max_frame) {
+            size = max_frame;
+        }
+        size = bench_make_frame(frame, size);
+        fwrite(frame, 1, size, f);
+    }
+    fclose(f);
+    free(frame);
+    return 0;
+}
+
+/* Read file frame by frame like the player */
+static int bench_storage(const char *path, size_t buff_size, bench_result_t *result)
+{
+    media_src_t src = {0};
+    uint64_t position = 0;
+    uint8_t *buff = malloc(buff_size);
+
+    memset(result, 0, sizeof(bench_result_t));
+    if (buff == NULL || media_src_storage_open(&src) != 0) {
+        free(buff);
+        return -1;
+    }
+    if (media_src_storage_connect(&src, (char *)path) != 0) {
+        media_src_storage_close(&src);
+        free(buff);
+        return -1;
+    }
+
+    memset(&counters, 0, sizeof(counters));
+    double start = bench_time();
+    while (true) {
+        int size = media_src_storage_read(&src, buff, buff_size);
+        if (size <= 0) {
+            break;
+        }
+        result->copied_bytes += size;
+        int soi = mjpeg_find_frame_start(buff, size);
+        if (soi < 0) {
+            break;
+        }
+        if (soi > 0) {
+            position += soi;
+            media_src_storage_seek(&src, position);
+            size = media_src_storage_read(&src, buff, buff_size);
+            if (size <= 0) {
+                break;
+            }
+            result->copied_bytes += size;
+        }
+        int frame_size = mjpeg_find_frame_end(buff, size);
+        if (frame_size <= 0) {
+            break;
+        }
+        result->frames++;
+        result->frame_bytes += frame_size;
+        position += frame_size;
+        media_src_storage_seek(&src, position);
+    }
+    result->seconds = bench_time() - start;
+    result->io = counters;
+
+    media_src_storage_disconnect(&src);
+    media_src_storage_close(&src);
+    free(buff);
+    return 0;
+}
+
+/* Frame boundary search only, whole file is in memory */
+static int bench_parse(const char *path, size_t buff_size, bench_result_t *result)
+{
+    memset(result, 0, sizeof(bench_result_t));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    size_t file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(file_size);
+    if (data == NULL || fread(data, 1, file_size, f) != file_size) {
+        free(data);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    size_t position = 0;
+    double start = bench_time();
+    while (position < file_size) {
+        size_t window = file_size - position;
+        if (window > buff_size) {
+            window = buff_size;
+        }
+        int soi = mjpeg_find_frame_start(data + position, window);
+        if (soi < 0) {
+            break;
+        }
+        position += soi;
+        int frame_size = mjpeg_find_frame_end(data + position, window - soi);
+        if (frame_size <= 0) {
+            break;
+        }
+        result->frames++;
+        result->frame_bytes += frame_size;
+        position += frame_size;
+    }
+    result->seconds = bench_time() - start;
+    free(data);
+    return 0;
+}
+
+static void bench_print(const char *bench, const char *fixture, const bench_result_t *r, bool json)
+{
+    const double seconds = (r->seconds > 0 ? r->seconds : 1e-9);
+    const double mb_s = r->frame_bytes / seconds / (1024 * 1024);
+    const double fps = r->frames / seconds;
+    const double syscalls = (r->frames ? (double)(r->io.read_calls + r->io.seek_calls) / r->frames : 0);
+    const double read_amp = (r->frame_bytes ? (double)r->io.read_bytes / r->frame_bytes : 0);
+    const double copy_amp = (r->frame_bytes ? (double)r->copied_bytes / r->frame_bytes : 0);
+
+    if (json) {
+        printf("{\"bench\":\"%s\",\"fixture\":\"%s\",\"frames\":%u,\"bytes\":%llu,\"seconds\":%.6f,"
+               "\"mb_s\":%.2f,\"fps\":%.1f,\"read_calls\":%llu,\"seek_calls\":%llu,\"syscalls_per_frame\":%.3f,"
+               "\"read_amplification\":%.3f,\"copy_amplification\":%.3f}\n",
+               bench, fixture, r->frames, (unsigned long long)r->frame_bytes, r->seconds, mb_s, fps,
+               (unsigned long long)r->io.read_calls, (unsigned long long)r->io.seek_calls, syscalls, read_amp, copy_amp);
+    } else {
+        printf("%-8s %-16s %6u %10.1f %10.1f %9.2f %9.3f %9.3f\n",
+               bench, fixture, r->frames, mb_s, fps, syscalls, read_amp, copy_amp);
+    }
+}
+
+/* Best of iterations (the least disturbed run) */
+static int bench_best(int (*fn)(const char *, size_t, bench_result_t *), const char *path, size_t buff_size,
+                      uint32_t iterations, bench_result_t *best)
+{
+    bench_result_t result;
+    for (uint32_t i = 0; i < iterations; i++) {
+        if (fn(path, buff_size, &result) != 0) {
+            return -1;
+        }
+        if (i == 0 || result.seconds < best->seconds) {
+            *best = result;
+        }
+    }
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options]\n"
+           "  -d, --dir DIR         directory for generated files (default /tmp)\n"
+           "  -b, --buff SIZE       size of the frame buffer (default %d)\n"
+           "  -f, --frames N        frames in every file (default %d)\n"
+           "  -i, --iterations N    runs of every benchmark, the best one is reported (default %d)\n"
+           "  -j, --json            print one JSON object per line\n"
+           "  -k, --keep            keep generated files\n", name, BENCH_BUFF_SIZE, BENCH_FRAMES, BENCH_ITERATIONS);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = "/tmp";
+    size_t buff_size = BENCH_BUFF_SIZE;
+    uint32_t frames = BENCH_FRAMES;
+    uint32_t iterations = BENCH_ITERATIONS;
+    bool json = false;
+    bool keep = false;
+    int ret = 0;
+
+    static const struct option options[] = {
+        {"dir", required_argument, NULL, 'd'},
+        {"buff", required_argument, NULL, 'b'},
+        {"frames", required_argument, NULL, 'f'},
+        {"iterations", required_argument, NULL, 'i'},
+        {"json", no_argument, NULL, 'j'},
+        {"keep", no_argument, NULL, 'k'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "d:b:f:i:jkh", options, NULL)) != -1) {
+        switch (opt) {
+        case 'd':
+            dir = optarg;
+            break;
+        case 'b':
+            buff_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            frames = strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            iterations = strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            json = true;
+            break;
+        case 'k':
+            keep = true;
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h' ? 0 : 1);
+        }
+    }
+    if (buff_size < 1024 || frames == 0 || iterations == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!json) {
+        printf("%-8s %-16s %6s %10s %10s %9s %9s %9s\n", "bench", "fixture", "frames", "MB/s", "frames/s", "sys/frame", "read amp", "copy amp");
+    }
+
+    for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++) {
+        for (size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++) {
+            char fixture[64];
+            char path[512];
+            bench_result_t result;
+
+            snprintf(fixture, sizeof(fixture), "%s_%s", resolutions[r].name, qualities[q].name);
+            snprintf(path, sizeof(path), "%s/bench_%s.mjpeg", dir, fixture);
+            /* Frame must fit into buffer */
+            if (bench_make_file(path, &resolutions[r], &qualities[q], frames, buff_size - 1) != 0) {
+                fprintf(stderr, "Cannot create %s\n", path);
+                return 1;
+            }
+
+            if (bench_best(bench_storage, path, buff_size, iterations, &result) == 0) {
+                bench_print("storage", fixture, &result, json);
+            } else {
+                fprintf(stderr, "Storage benchmark of %s failed\n", path);
+                ret = 1;
+            }
+            if (bench_best(bench_parse, path, buff_size, iterations, &result) == 0) {
+                bench_print("parse", fixture, &result, json);
+            } else {
+                fprintf(stderr, "Parse benchmark of %s failed\n", path);
+                ret = 1;
+            }
+
+            if (!keep) {
+                unlink(path);
+            }
+        }
+    }
+    return ret;
+}
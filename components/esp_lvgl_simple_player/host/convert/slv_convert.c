@@ -0,0 +1,326 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Converter of raw M-JPEG and M-JPEG AVI files to SLV files (see slv_format.h).
+ *
+ * Frames of the input are found by the same code as in the player (frame boundary search or AVI index).
+ * Video size and chroma subsampling are taken from SOF marker of the frames, all frames must have the same size.
+ * Repeated frames of AVI (empty chunks) are stored once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include "media_src_storage.h"
+#include "mjpeg_parser.h"
+#include "frame_index.h"
+#include "avi_demux.h"
+#include "slv_format.h"
+
+#define CONVERT_BUFF_SIZE       (64 * 1024)         /* Work buffer for AVI headers */
+#define CONVERT_SCAN_SIZE       (512 * 1024)        /* First size of frame search, doubled for bigger frames */
+#define CONVERT_MAX_FRAME_SIZE  (16 * 1024 * 1024)
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+
+typedef struct {
+    uint32_t        width;
+    uint32_t        height;
+    slv_sampling_t  sampling;
+    bool            baseline;
+} convert_jpeg_info_t;
+
+static uint16_t convert_u16be(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/* Parse SOF marker of the JPEG picture */
+static bool convert_jpeg_info(const uint8_t *data, uint32_t len, convert_jpeg_info_t *info)
+{
+    uint32_t pos = 2;
+    while (pos + 4 <= len) {
+        if (data[pos] != 0xff) {
+            return false;
+        }
+        const uint8_t marker = data[pos + 1];
+        if (marker == 0xff) {
+            /* Fill byte */
+            pos++;
+            continue;
+        }
+        const uint16_t seg_len = convert_u16be(data + pos + 2);
+        const bool sof = (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc);
+        if (sof) {
+            const uint8_t *body = data + pos + 4;
+            if (pos + 4 + 6 > len || pos + 4 + 6 + 3 * body[5] > len) {
+                return false;
+            }
+            info->height = convert_u16be(body + 1);
+            info->width = convert_u16be(body + 3);
+            info->baseline = (marker == 0xc0 || marker == 0xc1);
+            info->sampling = SLV_SAMPLING_UNKNOWN;
+            if (body[5] == 1) {
+                info->sampling = SLV_SAMPLING_GRAY;
+            } else if (body[5] == 3 && body[10] == 0x11 && body[13] == 0x11) {
+                /* Sampling factors of luma, chroma are not subsampled */
+                switch (body[7]) {
+                case 0x11:
+                    info->sampling = SLV_SAMPLING_444;
+                    break;
+                case 0x21:
+                    info->sampling = SLV_SAMPLING_422;
+                    break;
+                case 0x22:
+                    info->sampling = SLV_SAMPLING_420;
+                    break;
+                }
+            }
+            return true;
+        }
+        pos += 2 + seg_len;
+    }
+    return false;
+}
+
+/* Find frames of raw M-JPEG file by SOI and EOI markers */
+static int convert_index_raw(media_src_t *src, uint8_t *buff, uint32_t buff_size, frame_index_t *index)
+{
+    uint64_t pos = 0;
+    uint32_t scan_size = CONVERT_SCAN_SIZE;
+    while (true) {
+        if (media_src_storage_seek(src, pos) != 0) {
+            return -1;
+        }
+        int size = media_src_storage_read(src, buff, scan_size);
+        if (size <= 0) {
+            break;
+        }
+        int start = mjpeg_find_frame_start(buff, size);
+        if (start < 0) {
+            break;
+        }
+        int end = mjpeg_find_frame_end(buff + start, size - start);
+        if (end < 0) {
+            if (size == (int)scan_size && scan_size < buff_size) {
+                scan_size = (scan_size * 2 < buff_size ? scan_size * 2 : buff_size);
+                continue;
+            }
+            if (size == (int)scan_size) {
+                fprintf(stderr, "Frame at %llu is bigger than %u bytes\n", (unsigned long long)pos, buff_size);
+                return -1;
+            }
+            /* Truncated last frame */
+            break;
+        }
+        if (pos + start + end > UINT32_MAX) {
+            fprintf(stderr, "Files bigger than 4 GB are not supported\n");
+            return -1;
+        }
+        if (frame_index_add(index, index->count, (uint32_t)(pos + start), end) != ESP_OK) {
+            return -1;
+        }
+        pos += start + end;
+    }
+    return 0;
+}
+
+static bool convert_write_padded(FILE *out, const uint8_t *data, uint32_t size, uint32_t align)
+{
+    static const uint8_t zeros[4096] = {0};
+    if (size && fwrite(data, 1, size, out) != size) {
+        return false;
+    }
+    for (uint32_t pad = ALIGN_UP(size, align) - size; pad > 0; ) {
+        uint32_t n = (pad < sizeof(zeros) ? pad : sizeof(zeros));
+        if (fwrite(zeros, 1, n, out) != n) {
+            return false;
+        }
+        pad -= n;
+    }
+    return true;
+}
+
+static int convert(const char *in_path, const char *out_path, uint32_t align, double fps)
+{
+    int ret = -1;
+    media_src_t src = {0};
+    frame_index_t index = {0};
+    slv_header_t header = {0};
+    slv_frame_t *table = NULL;
+    FILE *out = NULL;
+    uint8_t *buff = malloc(CONVERT_MAX_FRAME_SIZE);
+
+    if (buff == NULL || media_src_storage_open(&src) != 0) {
+        fprintf(stderr, "Not enough memory\n");
+        goto end;
+    }
+    if (media_src_storage_connect(&src, (char *)in_path) != 0) {
+        fprintf(stderr, "Cannot open %s\n", in_path);
+        goto end;
+    }
+
+    /* Frames of the input */
+    int size = media_src_storage_read(&src, buff, CONVERT_BUFF_SIZE);
+    if (size > 0 && avi_demux_probe(buff, size)) {
+        avi_demux_info_t avi;
+        if (avi_demux_open(&src, buff, CONVERT_BUFF_SIZE, &avi, &index) != ESP_OK) {
+            fprintf(stderr, "AVI file %s cannot be parsed\n", in_path);
+            goto end;
+        }
+        /* Exact rate of the stream, e.g. 30000/1001 */
+        header.fps_num = avi.fps_num;
+        header.fps_den = avi.fps_den;
+    } else if (convert_index_raw(&src, buff, CONVERT_MAX_FRAME_SIZE, &index) != 0) {
+        goto end;
+    }
+    if (index.count == 0) {
+        fprintf(stderr, "No frame in %s\n", in_path);
+        goto end;
+    }
+    if (fps > 0) {
+        header.fps_num = (uint32_t)(fps * 1000 + 0.5);
+        header.fps_den = 1000;
+    }
+
+    out = fopen(out_path, "wb");
+    table = calloc(index.count, sizeof(slv_frame_t));
+    if (out == NULL || table == NULL) {
+        fprintf(stderr, "Cannot create %s\n", out_path);
+        goto end;
+    }
+
+    /* Header and table are written at the end, frames start behind them */
+    const uint32_t table_size = index.count * sizeof(slv_frame_t);
+    uint64_t out_pos = ALIGN_UP(sizeof(slv_header_t) + (uint64_t)table_size, align);
+    if (fseek(out, out_pos, SEEK_SET) != 0) {
+        goto end;
+    }
+
+    uint32_t unique = 0;
+    convert_jpeg_info_t first = {0};
+    for (uint32_t i = 0; i < index.count; i++) {
+        const frame_index_entry_t *entry = &index.entries[i];
+        if (i > 0 && entry->offset == index.entries[i - 1].offset) {
+            /* Repeated frame */
+            table[i] = table[i - 1];
+            continue;
+        }
+        if (entry->size > CONVERT_MAX_FRAME_SIZE ||
+                media_src_storage_read_at(&src, entry->offset, buff, entry->size) != (int)entry->size) {
+            fprintf(stderr, "Read of frame %u failed\n", i);
+            goto end;
+        }
+        convert_jpeg_info_t info;
+        if (!convert_jpeg_info(buff, entry->size, &info)) {
+            fprintf(stderr, "Frame %u is not JPEG picture\n", i);
+            goto end;
+        }
+        if (unique == 0) {
+            first = info;
+            if (!first.baseline) {
+                fprintf(stderr, "Warning: frames are not baseline JPEG, hardware decoder cannot decode them\n");
+            }
+        } else if (info.width != first.width || info.height != first.height) {
+            fprintf(stderr, "Frame %u has different size %ux%u (%ux%u)\n", i, info.width, info.height, first.width, first.height);
+            goto end;
+        } else if (info.sampling != first.sampling) {
+            first.sampling = SLV_SAMPLING_UNKNOWN;
+        }
+        if (out_pos + entry->size > UINT32_MAX) {
+            fprintf(stderr, "Output bigger than 4 GB is not supported\n");
+            goto end;
+        }
+        if (!convert_write_padded(out, buff, entry->size, align)) {
+            fprintf(stderr, "Write of %s failed\n", out_path);
+            goto end;
+        }
+        table[i].offset = (uint32_t)out_pos;
+        table[i].size = entry->size;
+        header.max_frame_size = (entry->size > header.max_frame_size ? entry->size : header.max_frame_size);
+        out_pos += ALIGN_UP(entry->size, align);
+        unique++;
+    }
+
+    memcpy(header.magic, SLV_MAGIC, sizeof(header.magic));
+    header.version = SLV_VERSION;
+    header.header_size = sizeof(slv_header_t);
+    header.width = first.width;
+    header.height = first.height;
+    header.frame_count = index.count;
+    header.align = align;
+    header.table_offset = sizeof(slv_header_t);
+    header.sampling = first.sampling;
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1 ||
+            fwrite(table, sizeof(slv_frame_t), index.count, out) != index.count) {
+        fprintf(stderr, "Write of %s failed\n", out_path);
+        goto end;
+    }
+
+    printf("%s: %ux%u, %.3f fps, %u frames (%u stored), max frame %u bytes, aligned to %u\n", out_path, header.width,
+           header.height, (header.fps_den ? (double)header.fps_num / header.fps_den : 0.0), header.frame_count, unique,
+           header.max_frame_size, align);
+    ret = 0;
+
+end:
+    if (out && fclose(out) != 0) {
+        ret = -1;
+    }
+    if (out && ret != 0) {
+        remove(out_path);
+    }
+    free(table);
+    free(buff);
+    frame_index_free(&index);
+    if (src.sub_src) {
+        media_src_storage_disconnect(&src);
+        media_src_storage_close(&src);
+    }
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options] INPUT OUTPUT\n"
+           "Converts raw M-JPEG or M-JPEG AVI file to SLV file.\n"
+           "  -a, --align N         alignment of frames, power of two (default %d)\n"
+           "  -r, --fps FPS         frame rate (default from AVI, unknown for raw M-JPEG)\n", name, SLV_DEFAULT_ALIGN);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t align = SLV_DEFAULT_ALIGN;
+    double fps = 0;
+
+    static const struct option options[] = {
+        {"align", required_argument, NULL, 'a'},
+        {"fps", required_argument, NULL, 'r'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "a:r:h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            align = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            fps = strtod(optarg, NULL);
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h' ? 0 : 1);
+        }
+    }
+    if (optind != argc - 2 || align == 0 || (align & (align - 1)) != 0 || fps < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    return (convert(argv[optind], argv[optind + 1], align, fps) == 0 ? 0 : 1);
+}
@@ -0,0 +1,30 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* LVGL configuration of the host build, close to sdkconfig.defaults of the example (not listed options are default) */
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH              16
+#define LV_DEF_REFR_PERIOD          10
+
+/* LVGL is locked by esp_lvgl_port shim */
+#define LV_USE_OS                   LV_OS_NONE
+
+#define LV_USE_STDLIB_MALLOC        LV_STDLIB_CLIB
+#define LV_USE_STDLIB_STRING        LV_STDLIB_CLIB
+#define LV_USE_STDLIB_SPRINTF       LV_STDLIB_CLIB
+
+#define LV_FONT_MONTSERRAT_16       1
+#define LV_FONT_MONTSERRAT_48       1
+
+#define LV_USE_LOG                  0
+#define LV_USE_SYSMON               0
+#define LV_USE_OBSERVER             1
+#define LV_BUILD_EXAMPLES           0
+
+#endif /* LV_CONF_H */
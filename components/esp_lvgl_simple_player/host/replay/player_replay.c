@@ -0,0 +1,509 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Headless replay of a video file by the real player.
+ *
+ * The player runs with LVGL on a display rendered into memory, JPEG frames are decoded by libjpeg and player
+ * tasks are POSIX threads. The file is played once as fast as possible (or with given frame rate) and decode,
+ * display and render rates with per-stage statistics of the last frames are reported.
+ * With --frames, the file is played in loop until the number of frames is shown (e.g. with --cache for short loops).
+ * With --viewport, only part of the video is shown (pan and zoom), compare decode time with the whole video.
+ * With --adaptive and --fps above the decoding rate, frames are skipped to keep the speed of the video.
+ * With --repeated, frames identical to the shown one are not decoded and drawn (slides, hold frames).
+ * With --arena, all player buffers are reserved on create and playing is checked not to use heap.
+ * With --subtitles, captions of SRT file are rasterized ahead and blended onto frames (needs frame rate).
+ * With --snapshot, the first shown frame is saved as original JPEG and RGB565 (PREFIX.jpg, PREFIX.rgb).
+ * With --compare, results are checked against stored baseline and the exit code is non-zero on regression.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_lvgl_port.h"
+#include "esp_lvgl_simple_player.h"
+
+#define REPLAY_BUFF_SIZE        (540 * 960)     /* Same as video buffer in the example */
+#define REPLAY_HRES             (800)
+#define REPLAY_VRES             (1280)
+#define REPLAY_TOLERANCE        (10)            /* Percent */
+#define REPLAY_START_TIMEOUT_MS (5000)
+#define REPLAY_RESULT_LEN       (2048)
+#define REPLAY_OVERLAY_WIDTH    (800)           /* Size of the news ticker banner in the example */
+#define REPLAY_OVERLAY_HEIGHT   (132)
+
+typedef struct {
+    uint32_t    frames_decoded;
+    uint32_t    frames_displayed;
+    uint32_t    frames_dropped;
+    uint32_t    frames_cached;
+    uint32_t    frames_skipped;
+    uint32_t    frames_repeated;
+    uint32_t    renders;
+    uint32_t    first_frame_us;
+    double      seconds;
+    esp_lvgl_simple_player_stats_t stats;
+} replay_result_t;
+
+/* Metrics checked against the baseline, higher is better for rates, lower is better for times */
+typedef struct {
+    const char  *key;
+    bool        higher_better;
+} replay_metric_t;
+
+static const replay_metric_t metrics[] = {
+    {"decode_fps", true},
+    {"display_fps", true},
+    {"render_fps", true},
+    {"decode_p95", false},
+    {"present_p95", false},
+    {"first_frame_us", false},
+};
+
+static const char *stage_names[PLAYER_STAT_MAX] = {
+    "read", "parse", "decode", "wait", "handoff", "present", "frame_size",
+};
+
+static volatile uint32_t render_count;
+static uint8_t overlay_data[REPLAY_OVERLAY_WIDTH * REPLAY_OVERLAY_HEIGHT * 3];
+static lv_image_dsc_t overlay_image;
+
+static void replay_render_cb(lv_event_t *e)
+{
+    render_count++;
+}
+
+static void replay_format(const char *file, const replay_result_t *r, char *out, size_t size)
+{
+    const double seconds = (r->seconds > 0 ? r->seconds : 1e-9);
+    int len = snprintf(out, size, "{\"file\":\"%s\",\"seconds\":%.3f,\"frames_decoded\":%u,\"frames_displayed\":%u,"
+                       "\"frames_dropped\":%u,\"frames_cached\":%u,\"frames_skipped\":%u,\"frames_repeated\":%u,\"renders\":%u,\"decode_fps\":%.1f,\"display_fps\":%.1f,\"render_fps\":%.1f,"
+                       "\"first_frame_us\":%u,\"samples\":%u",
+                       file, r->seconds, r->frames_decoded, r->frames_displayed, r->frames_dropped, r->frames_cached, r->frames_skipped, r->frames_repeated, r->renders,
+                       r->frames_decoded / seconds, r->frames_displayed / seconds, r->renders / seconds,
+                       r->first_frame_us, r->stats.samples);
+    for (int i = 0; i < PLAYER_STAT_MAX && len < size; i++) {
+        const player_stat_value_t *v = &r->stats.stage[i];
+        len += snprintf(out + len, size - len, ",\"%s_min\":%u,\"%s_avg\":%u,\"%s_p95\":%u,\"%s_max\":%u",
+                        stage_names[i], v->min, stage_names[i], v->avg, stage_names[i], v->p95, stage_names[i], v->max);
+    }
+    if (len < size) {
+        snprintf(out + len, size - len, "}");
+    }
+}
+
+static void replay_print(const char *file, const replay_result_t *r)
+{
+    const double seconds = (r->seconds > 0 ? r->seconds : 1e-9);
+    printf("File:           %s\n", file);
+    printf("Time:           %.3f s\n", r->seconds);
+    printf("Decoded:        %u frames (%.1f fps)\n", r->frames_decoded, r->frames_decoded / seconds);
+    printf("Displayed:      %u frames (%.1f fps)\n", r->frames_displayed, r->frames_displayed / seconds);
+    printf("Dropped:        %u frames\n", r->frames_dropped);
+    printf("Cached:         %u frames\n", r->frames_cached);
+    printf("Skipped:        %u frames (decode step %u, %u changes)\n", r->frames_skipped, r->stats.decode_step, r->stats.skip_changes);
+    printf("Repeated:       %u frames\n", r->frames_repeated);
+    printf("Rendered:       %u times (%.1f fps)\n", r->renders, r->renders / seconds);
+    printf("First frame:    %u us\n", r->first_frame_us);
+    printf("Last %u frames:\n", r->stats.samples);
+    printf("  %-12s %9s %9s %9s %9s\n", "stage", "min", "avg", "p95", "max");
+    for (int i = 0; i < PLAYER_STAT_MAX; i++) {
+        const player_stat_value_t *v = &r->stats.stage[i];
+        printf("  %-12s %9u %9u %9u %9u\n", stage_names[i], v->min, v->avg, v->p95, v->max);
+    }
+}
+
+/* Value of the key from the flat JSON object, returns false when not found */
+static bool replay_json_value(const char *json, const char *key, double *value)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(json, pattern);
+    if (p == NULL) {
+        return false;
+    }
+    *value = strtod(p + strlen(pattern), NULL);
+    return true;
+}
+
+/* Returns number of regressed metrics, -1 when baseline cannot be read */
+static int replay_compare(const char *baseline_path, const char *result, double tolerance)
+{
+    char baseline[REPLAY_RESULT_LEN] = {0};
+    FILE *f = fopen(baseline_path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open baseline %s\n", baseline_path);
+        return -1;
+    }
+    size_t len = fread(baseline, 1, sizeof(baseline) - 1, f);
+    fclose(f);
+    baseline[len] = '\0';
+
+    int regressions = 0;
+    fprintf(stderr, "%-16s %12s %12s %8s\n", "metric", "baseline", "current", "change");
+    for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+        double base, current;
+        if (!replay_json_value(baseline, metrics[i].key, &base) || !replay_json_value(result, metrics[i].key, &current)) {
+            continue;
+        }
+        const double change = (base != 0 ? (current - base) * 100.0 / base : 0);
+        const bool regressed = (metrics[i].higher_better ? (change < -tolerance) : (change > tolerance));
+        fprintf(stderr, "%-16s %12.1f %12.1f %7.1f%%%s\n", metrics[i].key, base, current, change, (regressed ? "  REGRESSION" : ""));
+        if (regressed) {
+            regressions++;
+        }
+    }
+    return regressions;
+}
+
+/* RGB565A8 banner like the news ticker: gradient edge, opaque bar and transparent corner */
+static const lv_image_dsc_t *replay_overlay_image(void)
+{
+    const uint32_t w = REPLAY_OVERLAY_WIDTH;
+    const uint32_t h = REPLAY_OVERLAY_HEIGHT;
+    uint16_t *color = (uint16_t *)overlay_data;
+    uint8_t *alpha = overlay_data + w * h * 2;
+
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            color[y * w + x] = (uint16_t)(0xf800 | ((x * 63 / w) << 5));
+            if (y < 32) {
+                alpha[y * w + x] = (x < 160 ? 0 : y * 8);
+            } else {
+                alpha[y * w + x] = (x < 120 ? 0xc0 : 0xff);
+            }
+        }
+    }
+    overlay_image.header.cf = LV_COLOR_FORMAT_RGB565A8;
+    overlay_image.header.w = w;
+    overlay_image.header.h = h;
+    overlay_image.header.stride = w * 2;
+    overlay_image.data_size = sizeof(overlay_data);
+    overlay_image.data = overlay_data;
+    return &overlay_image;
+}
+
+/* Files are written from buffers of the replay, so the arena player does not need heap */
+static int replay_snapshot(const char *prefix, uint32_t buff_size, uint32_t hres, uint32_t vres)
+{
+    char jpeg_file[256];
+    char raw_file[256];
+    snprintf(jpeg_file, sizeof(jpeg_file), "%s.jpg", prefix);
+    snprintf(raw_file, sizeof(raw_file), "%s.rgb", prefix);
+    const esp_lvgl_simple_player_snapshot_cfg_t cfg = {
+        .jpeg_file = jpeg_file,
+        .jpeg_buff = malloc(buff_size),
+        .jpeg_buff_size = buff_size,
+        .raw_file = raw_file,
+        .raw_buff = malloc(hres * vres * 2),
+        .raw_buff_size = hres * vres * 2,
+    };
+    esp_lvgl_simple_player_snapshot_t snapshot;
+    esp_err_t err = ESP_ERR_NO_MEM;
+    if (cfg.jpeg_buff && cfg.raw_buff) {
+        err = esp_lvgl_simple_player_snapshot(&cfg, &snapshot);
+    }
+    free(cfg.jpeg_buff);
+    free(cfg.raw_buff);
+    if (err != ESP_OK) {
+        return -1;
+    }
+    printf("Snapshot:       frame %u, %s (%u bytes), %s (%u x %u RGB565)\n", snapshot.frame, jpeg_file, snapshot.jpeg_size,
+           raw_file, snapshot.width, snapshot.height);
+    return 0;
+}
+
+static int replay_run(const char *file, uint32_t hres, uint32_t vres, uint32_t buff_size, uint32_t fps, bool overlay,
+                      bool adaptive, bool repeated, uint32_t cache_size, uint32_t frames, const uint32_t *viewport, const uint32_t *arena,
+                      const char *subtitles, const char *snapshot, replay_result_t *result)
+{
+    const lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    if (lvgl_port_init(&lvgl_cfg) != ESP_OK) {
+        fprintf(stderr, "LVGL port initialization failed\n");
+        return -1;
+    }
+    lv_display_t *disp = lvgl_port_host_add_display(hres, vres);
+    if (disp == NULL) {
+        fprintf(stderr, "Display creation failed\n");
+        return -1;
+    }
+
+    esp_lvgl_simple_player_cfg_t player_cfg = {
+        .file = (char *)file,
+        .buff_size = buff_size,
+        .screen_width = hres,
+        .screen_height = vres,
+        .fps = fps,
+        .frame_cache_size = cache_size,
+        .arena = {
+            .max_width = arena[0],
+            .max_height = arena[1],
+            .max_frames = arena[2],
+            .caption_font = (subtitles ? LV_FONT_DEFAULT : NULL),
+        },
+        .flags = {
+            .hide_controls = true,
+            .hide_status = true,
+            .adaptive_skip = adaptive,
+            .skip_repeated = repeated,
+        },
+    };
+    lvgl_port_lock(0);
+    player_cfg.screen = lv_screen_active();
+    lv_obj_t *player = esp_lvgl_simple_player_create(&player_cfg);
+    if (player) {
+        lv_obj_center(player);
+        lv_display_add_event_cb(disp, replay_render_cb, LV_EVENT_RENDER_START, NULL);
+    }
+    lvgl_port_unlock();
+    if (player == NULL) {
+        fprintf(stderr, "Player creation failed\n");
+        return -1;
+    }
+    if (overlay) {
+        const esp_lvgl_simple_player_overlay_cfg_t overlay_cfg = {
+            .image = replay_overlay_image(),
+            .align = LV_ALIGN_BOTTOM_MID,
+        };
+        if (esp_lvgl_simple_player_overlay_add(&overlay_cfg, NULL) != ESP_OK) {
+            fprintf(stderr, "Overlay creation failed\n");
+            return -1;
+        }
+    }
+    if (subtitles) {
+        const esp_lvgl_simple_player_subtitles_cfg_t subtitles_cfg = {
+            .file = subtitles,
+            .color = lv_color_white(),
+            .bg_color = lv_color_black(),
+            .bg_opa = LV_OPA_50,
+            .y_ofs = -8,
+        };
+        if (esp_lvgl_simple_player_subtitles_load(&subtitles_cfg) != ESP_OK) {
+            fprintf(stderr, "Loading subtitles failed\n");
+            return -1;
+        }
+    }
+
+    if (viewport[2] > 0 && esp_lvgl_simple_player_set_viewport(viewport[0], viewport[1], viewport[2], viewport[3]) != ESP_OK) {
+        fprintf(stderr, "Invalid viewport\n");
+        return -1;
+    }
+
+    render_count = 0;
+    esp_lvgl_simple_player_repeat(frames > 0);
+    esp_lvgl_simple_player_reset_stats();
+    const int64_t start = esp_timer_get_time();
+    esp_lvgl_simple_player_play();
+
+    /* Wait for the first shown frame, short file can be played whole (stopped again after the last frame) before
+     * the playing state is seen, its last frame is dropped on stop, so one frame file has no shown frame */
+    while (true) {
+        esp_lvgl_simple_player_get_stats(&result->stats);
+        if (result->stats.frames_displayed > 0) {
+            break;
+        }
+        if (esp_lvgl_simple_player_get_state() == PLAYER_STATE_STOPPED && result->stats.frames_decoded + result->stats.frames_cached > 0) {
+            break;
+        }
+        if (esp_timer_get_time() - start > REPLAY_START_TIMEOUT_MS * 1000LL) {
+            fprintf(stderr, "Player did not start, check the file %s\n", file);
+            return -1;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    while (esp_lvgl_simple_player_get_state() != PLAYER_STATE_STOPPED) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+        if (snapshot) {
+            esp_lvgl_simple_player_get_stats(&result->stats);
+            if (result->stats.frames_displayed > 0 && replay_snapshot(snapshot, buff_size, hres, vres) == 0) {
+                snapshot = NULL;
+            }
+        }
+        if (frames > 0) {
+            esp_lvgl_simple_player_get_stats(&result->stats);
+            if (result->stats.frames_decoded + result->stats.frames_cached >= frames) {
+                esp_lvgl_simple_player_stop();
+            }
+        }
+    }
+
+    result->seconds = (esp_timer_get_time() - start) / 1000000.0;
+    result->renders = render_count;
+    result->first_frame_us = esp_lvgl_simple_player_get_first_frame_time();
+    esp_lvgl_simple_player_get_stats(&result->stats);
+    result->frames_decoded = result->stats.frames_decoded;
+    result->frames_displayed = result->stats.frames_displayed;
+    result->frames_dropped = result->stats.frames_dropped;
+    result->frames_cached = result->stats.frames_cached;
+    result->frames_skipped = result->stats.frames_skipped;
+    result->frames_repeated = result->stats.frames_repeated;
+    return (result->frames_decoded > 0 ? 0 : -1);
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options] FILE\n"
+           "  -W, --width N         display width (default %d)\n"
+           "  -H, --height N        display height (default %d)\n"
+           "  -b, --buff SIZE       size of the frame buffer (default %d)\n"
+           "  -f, --fps N           presentation frame rate, 0 = rate from AVI or as fast as possible (default 0)\n"
+           "  -o, --overlay         blend news ticker banner over the video\n"
+           "  -a, --adaptive        skip decoding of frames when decoding is slower than frame rate\n"
+           "  -r, --repeated        do not decode and draw frames identical to the shown one\n"
+           "  -n, --frames N        play in loop until N frames are shown (default 0 = play once)\n"
+           "  -C, --cache SIZE      memory for cache of decoded frames in bytes (default 0 = disabled)\n"
+           "  -V, --viewport X,Y,W,H show only part of the video (default whole video)\n"
+           "  -A, --arena W,H[,N]   reserve player memory for videos up to W x H with N frames on create\n"
+           "  -s, --subtitles FILE  show captions of SRT file\n"
+           "  -S, --snapshot PREFIX save the first shown frame to PREFIX.jpg (original) and PREFIX.rgb (RGB565)\n"
+           "  -j, --json            print result as one JSON object\n"
+           "  -c, --compare FILE    compare with baseline (JSON result of previous run), exit code 2 on regression\n"
+           "  -t, --tolerance PCT   allowed change against baseline in percent (default %d)\n"
+           "  -q, --quiet           no player logs\n", name, REPLAY_HRES, REPLAY_VRES, REPLAY_BUFF_SIZE, REPLAY_TOLERANCE);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t hres = REPLAY_HRES;
+    uint32_t vres = REPLAY_VRES;
+    uint32_t buff_size = REPLAY_BUFF_SIZE;
+    uint32_t fps = 0;
+    double tolerance = REPLAY_TOLERANCE;
+    const char *baseline = NULL;
+    bool json = false;
+    bool overlay = false;
+    bool adaptive = false;
+    bool repeated = false;
+    uint32_t cache_size = 0;
+    uint32_t frames = 0;
+    uint32_t viewport[4] = {0};
+    uint32_t arena[3] = {0};
+    const char *subtitles = NULL;
+    const char *snapshot = NULL;
+
+    static const struct option options[] = {
+        {"width", required_argument, NULL, 'W'},
+        {"height", required_argument, NULL, 'H'},
+        {"buff", required_argument, NULL, 'b'},
+        {"fps", required_argument, NULL, 'f'},
+        {"overlay", no_argument, NULL, 'o'},
+        {"adaptive", no_argument, NULL, 'a'},
+        {"repeated", no_argument, NULL, 'r'},
+        {"frames", required_argument, NULL, 'n'},
+        {"cache", required_argument, NULL, 'C'},
+        {"viewport", required_argument, NULL, 'V'},
+        {"arena", required_argument, NULL, 'A'},
+        {"subtitles", required_argument, NULL, 's'},
+        {"snapshot", required_argument, NULL, 'S'},
+        {"json", no_argument, NULL, 'j'},
+        {"compare", required_argument, NULL, 'c'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"quiet", no_argument, NULL, 'q'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "W:H:b:f:oarn:C:V:A:s:S:jc:t:qh", options, NULL)) != -1) {
+        switch (opt) {
+        case 'W':
+            hres = strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            vres = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            buff_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            fps = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            overlay = true;
+            break;
+        case 'a':
+            adaptive = true;
+            break;
+        case 'r':
+            repeated = true;
+            break;
+        case 'n':
+            frames = strtoul(optarg, NULL, 0);
+            break;
+        case 'C':
+            cache_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'V':
+            if (sscanf(optarg, "%u,%u,%u,%u", &viewport[0], &viewport[1], &viewport[2], &viewport[3]) != 4) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'A':
+            if (sscanf(optarg, "%u,%u,%u", &arena[0], &arena[1], &arena[2]) < 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 's':
+            subtitles = optarg;
+            break;
+        case 'S':
+            snapshot = optarg;
+            break;
+        case 'j':
+            json = true;
+            break;
+        case 'c':
+            baseline = optarg;
+            break;
+        case 't':
+            tolerance = strtod(optarg, NULL);
+            break;
+        case 'q':
+            esp_log_level_set("*", ESP_LOG_WARN);
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h' ? 0 : 1);
+        }
+    }
+    if (optind != argc - 1 || hres == 0 || vres == 0 || buff_size < 1024) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *file = argv[optind];
+
+    replay_result_t result = {0};
+    if (replay_run(file, hres, vres, buff_size, fps, overlay, adaptive, repeated, cache_size, frames, viewport, arena, subtitles, snapshot, &result) != 0) {
+        return 1;
+    }
+
+    char line[REPLAY_RESULT_LEN];
+    replay_format(file, &result, line, sizeof(line));
+    if (json) {
+        printf("%s\n", line);
+    } else {
+        replay_print(file, &result);
+    }
+
+    if (baseline) {
+        int regressions = replay_compare(baseline, line, tolerance);
+        if (regressions < 0) {
+            return 1;
+        }
+        if (regressions > 0) {
+            return 2;
+        }
+    }
+    return 0;
+}
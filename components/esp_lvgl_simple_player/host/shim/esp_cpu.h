@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host shim of ESP-IDF CPU functions */
+
+#pragma once
+
+int esp_cpu_get_core_id(void);
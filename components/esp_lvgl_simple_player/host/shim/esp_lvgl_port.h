@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host shim of esp_lvgl_port, LVGL runs in its own thread and renders into memory (no panel) */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+typedef struct {
+    int         task_priority;
+    int         task_stack;
+    int         task_affinity;
+    int         task_max_sleep_ms;
+    int         timer_period_ms;
+} lvgl_port_cfg_t;
+
+#define ESP_LVGL_PORT_INIT_CONFIG() \
+    {                               \
+        .task_priority = 4,         \
+        .task_stack = 7168,         \
+        .task_affinity = -1,        \
+        .task_max_sleep_ms = 500,   \
+        .timer_period_ms = 5,       \
+    }
+
+esp_err_t lvgl_port_init(const lvgl_port_cfg_t *cfg);
+esp_err_t lvgl_port_deinit(void);
+bool lvgl_port_lock(uint32_t timeout_ms);
+void lvgl_port_unlock(void);
+
+/**
+ * @brief Add display rendered into memory (host only)
+ *
+ * @param hres  Horizontal resolution
+ * @param vres  Vertical resolution
+ * @return Display or NULL when allocation failed
+ */
+lv_display_t *lvgl_port_host_add_display(uint32_t hres, uint32_t vres);
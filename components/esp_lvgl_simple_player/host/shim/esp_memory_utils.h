@@ -0,0 +1,17 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host shim of ESP-IDF memory utilities, all memory of the host is internal */
+
+#pragma once
+
+#include <stdbool.h>
+
+static inline bool esp_ptr_external_ram(const void *p)
+{
+    (void)p;
+    return false;
+}
@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host implementation of ESP-IDF system functions used by the player */
+
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+
+esp_log_level_t esp_log_host_level = ESP_LOG_INFO;
+
+static int64_t host_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    static int64_t start;
+    if (start == 0) {
+        start = host_time_us();
+    }
+    return host_time_us() - start;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    esp_log_host_level = level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+uint32_t esp_random(void)
+{
+    return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+int esp_cpu_get_core_id(void)
+{
+    int cpu = sched_getcpu();
+    return (cpu < 0 ? 0 : cpu);
+}
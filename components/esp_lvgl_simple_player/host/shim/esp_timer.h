@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host shim of ESP-IDF high resolution timer */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Microseconds since start of the program */
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,30 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host shim of FreeRTOS on POSIX threads (only API used by the player), one tick is one millisecond */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE             (0)
+#define pdTRUE              (1)
+#define pdPASS              (pdTRUE)
+#define pdFAIL              (pdFALSE)
+#define portMAX_DELAY       ((TickType_t)UINT32_MAX)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+/* Critical sections are mutexes on host */
+typedef pthread_mutex_t portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    PTHREAD_MUTEX_INITIALIZER
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(mux)
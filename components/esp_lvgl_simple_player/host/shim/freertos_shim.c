@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host implementation of FreeRTOS tasks, notifications and semaphores on POSIX threads (priorities are ignored) */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define HOST_TASK_NAME_LEN  (16)
+
+struct host_task_s {
+    pthread_t       thread;
+    char            name[HOST_TASK_NAME_LEN];
+    TaskFunction_t  fn;
+    void            *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        notify;
+};
+
+static __thread TaskHandle_t current_task;
+
+/* Absolute time for pthread_cond_timedwait */
+static void host_deadline(TickType_t ticks, struct timespec *ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static TaskHandle_t host_task_new(const char *name)
+{
+    TaskHandle_t task = calloc(1, sizeof(struct host_task_s));
+    if (task == NULL) {
+        return NULL;
+    }
+    strncpy(task->name, name, HOST_TASK_NAME_LEN - 1);
+    pthread_mutex_init(&task->lock, NULL);
+    host_cond_init(&task->cond);
+    return task;
+}
+
+static void *host_task_entry(void *arg)
+{
+    current_task = arg;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *ret_task)
+{
+    (void)stack_depth;
+    (void)priority;
+    TaskHandle_t task = host_task_new(name);
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    if (ret_task) {
+        *ret_task = task;
+    }
+    if (pthread_create(&task->thread, NULL, host_task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    /* Only deleting of the calling task is used */
+    if (task == NULL || task == current_task) {
+        task = current_task;
+        current_task = NULL;
+        pthread_mutex_destroy(&task->lock);
+        pthread_cond_destroy(&task->cond);
+        free(task);
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = {
+        .tv_sec = ticks / 1000,
+        .tv_nsec = (long)(ticks % 1000) * 1000000,
+    };
+    nanosleep(&ts, NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    /* Threads not created by xTaskCreate (main) get handle on first use */
+    if (current_task == NULL) {
+        current_task = host_task_new("main");
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->name;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    struct timespec ts;
+    host_deadline(ticks, &ts);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && ticks > 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&task->cond, &task->lock);
+        } else if (pthread_cond_timedwait(&task->cond, &task->lock, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = task->notify;
+    if (value) {
+        task->notify = (clear ? 0 : value - 1);
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+static SemaphoreHandle_t host_semaphore_init(StaticSemaphore_t *sem, uint32_t count, uint32_t max)
+{
+    pthread_mutex_init(&sem->lock, NULL);
+    host_cond_init(&sem->cond);
+    sem->count = count;
+    sem->max = max;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    StaticSemaphore_t *sem = calloc(1, sizeof(StaticSemaphore_t));
+    if (sem == NULL) {
+        return NULL;
+    }
+    sem->dynamic = true;
+    return host_semaphore_init(sem, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+    if (sem) {
+        sem->count = 1;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    buffer->dynamic = false;
+    return host_semaphore_init(buffer, 1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec ts;
+    host_deadline(ticks, &ts);
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ticks > 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        } else if (pthread_cond_timedwait(&sem->cond, &sem->lock, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    BaseType_t ret = pdFALSE;
+    if (sem->count > 0) {
+        sem->count--;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(&sem->lock);
+    pthread_cond_destroy(&sem->cond);
+    if (sem->dynamic) {
+        free(sem);
+    }
+}
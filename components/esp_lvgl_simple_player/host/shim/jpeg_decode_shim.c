@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host implementation of ESP-IDF JPEG decoder driver on libjpeg(-turbo).
+ * Output layout is the same as from the hardware engine: lines are padded to 16 pixels.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include "driver/jpeg_decode.h"
+
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+#define JPEG_SHIM_BUFF_ALIGN    (64)
+
+struct jpeg_decoder_s {
+    struct jpeg_decompress_struct   cinfo;
+    struct jpeg_error_mgr           jerr;
+    jmp_buf                         jmp;
+};
+
+static void jpeg_shim_error_exit(j_common_ptr cinfo)
+{
+    struct jpeg_decoder_s *dec = (struct jpeg_decoder_s *)cinfo;
+    longjmp(dec->jmp, 1);
+}
+
+/* Corrupted data warnings are not printed for each frame */
+static void jpeg_shim_output_message(j_common_ptr cinfo)
+{
+    (void)cinfo;
+}
+
+esp_err_t jpeg_new_decoder_engine(const jpeg_decode_engine_cfg_t *dec_eng_cfg, jpeg_decoder_handle_t *ret_decoder)
+{
+    (void)dec_eng_cfg;
+    struct jpeg_decoder_s *dec = calloc(1, sizeof(struct jpeg_decoder_s));
+    if (dec == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    dec->cinfo.err = jpeg_std_error(&dec->jerr);
+    dec->jerr.error_exit = jpeg_shim_error_exit;
+    dec->jerr.output_message = jpeg_shim_output_message;
+    jpeg_create_decompress(&dec->cinfo);
+    *ret_decoder = dec;
+    return ESP_OK;
+}
+
+esp_err_t jpeg_del_decoder_engine(jpeg_decoder_handle_t decoder_engine)
+{
+    if (decoder_engine) {
+        jpeg_destroy_decompress(&decoder_engine->cinfo);
+        free(decoder_engine);
+    }
+    return ESP_OK;
+}
+
+esp_err_t jpeg_decoder_get_info(const uint8_t *in_buf, uint32_t inbuf_len, jpeg_decode_picture_info_t *picture_info)
+{
+    /* Temporary decoder, the function is used without engine */
+    struct jpeg_decoder_s dec;
+    esp_err_t ret = ESP_OK;
+
+    dec.cinfo.err = jpeg_std_error(&dec.jerr);
+    dec.jerr.error_exit = jpeg_shim_error_exit;
+    dec.jerr.output_message = jpeg_shim_output_message;
+    jpeg_create_decompress(&dec.cinfo);
+    if (setjmp(dec.jmp)) {
+        ret = ESP_ERR_INVALID_ARG;
+        goto end;
+    }
+    jpeg_mem_src(&dec.cinfo, in_buf, inbuf_len);
+    jpeg_read_header(&dec.cinfo, TRUE);
+    picture_info->width = dec.cinfo.image_width;
+    picture_info->height = dec.cinfo.image_height;
+
+end:
+    jpeg_destroy_decompress(&dec.cinfo);
+    return ret;
+}
+
+/* RGB order of RGB565 is byte swapped, the same as from the hardware engine */
+static void jpeg_shim_swap565(uint8_t *line, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++, line += 2) {
+        uint8_t tmp = line[0];
+        line[0] = line[1];
+        line[1] = tmp;
+    }
+}
+
+static void jpeg_shim_swap888(uint8_t *line, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++, line += 3) {
+        uint8_t tmp = line[0];
+        line[0] = line[2];
+        line[2] = tmp;
+    }
+}
+
+esp_err_t jpeg_decoder_process(jpeg_decoder_handle_t decoder_engine, const jpeg_decode_cfg_t *decode_cfg, const uint8_t *bit_stream,
+                               uint32_t stream_size, uint8_t *decode_outbuf, uint32_t outbuf_size, uint32_t *out_size)
+{
+    struct jpeg_decompress_struct *cinfo = &decoder_engine->cinfo;
+    uint32_t bpp;
+
+    if (setjmp(decoder_engine->jmp)) {
+        jpeg_abort_decompress(cinfo);
+        return ESP_FAIL;
+    }
+    jpeg_mem_src(cinfo, bit_stream, stream_size);
+    jpeg_read_header(cinfo, TRUE);
+
+    switch (decode_cfg->output_format) {
+    case JPEG_DECODE_OUT_FORMAT_RGB565:
+        cinfo->out_color_space = JCS_RGB565;
+        cinfo->dither_mode = JDITHER_NONE;
+        bpp = 2;
+        break;
+    case JPEG_DECODE_OUT_FORMAT_GRAY:
+        cinfo->out_color_space = JCS_GRAYSCALE;
+        bpp = 1;
+        break;
+    default:
+        cinfo->out_color_space = JCS_EXT_BGR;
+        bpp = 3;
+        break;
+    }
+    cinfo->dct_method = JDCT_IFAST;
+    jpeg_start_decompress(cinfo);
+
+    const uint32_t stride = ALIGN_UP(cinfo->output_width, 16) * bpp;
+    if (stride * cinfo->output_height > outbuf_size) {
+        jpeg_abort_decompress(cinfo);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    while (cinfo->output_scanline < cinfo->output_height) {
+        uint8_t *line = decode_outbuf + cinfo->output_scanline * stride;
+        jpeg_read_scanlines(cinfo, &line, 1);
+        if (decode_cfg->rgb_order == JPEG_DEC_RGB_ELEMENT_ORDER_RGB) {
+            if (bpp == 2) {
+                jpeg_shim_swap565(line, cinfo->output_width);
+            } else if (bpp == 3) {
+                jpeg_shim_swap888(line, cinfo->output_width);
+            }
+        }
+    }
+    if (out_size) {
+        *out_size = stride * cinfo->output_height;
+    }
+    jpeg_finish_decompress(cinfo);
+    return ESP_OK;
+}
+
+void *jpeg_alloc_decoder_mem(size_t size, const jpeg_decode_memory_alloc_cfg_t *mem_cfg, size_t *allocated_size)
+{
+    (void)mem_cfg;
+    size = ALIGN_UP(size, JPEG_SHIM_BUFF_ALIGN);
+    void *buff = aligned_alloc(JPEG_SHIM_BUFF_ALIGN, size);
+    if (buff && allocated_size) {
+        *allocated_size = size;
+    }
+    return buff;
+}
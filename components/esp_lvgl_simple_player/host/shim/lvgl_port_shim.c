@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host implementation of esp_lvgl_port: LVGL task on POSIX thread and display without panel */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "esp_timer.h"
+#include "esp_lvgl_port.h"
+
+#define LVGL_PORT_BUFF_LINES    (50)
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_t       thread;
+    bool            running;
+    uint32_t        max_sleep_ms;
+    uint32_t        timer_period_ms;
+} lvgl_port_ctx_t;
+
+static lvgl_port_ctx_t lvgl_port_ctx;
+
+static uint32_t lvgl_port_tick_get(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void *lvgl_port_task(void *arg)
+{
+    while (lvgl_port_ctx.running) {
+        uint32_t sleep_ms = 0;
+        if (lvgl_port_lock(0)) {
+            sleep_ms = lv_timer_handler();
+            lvgl_port_unlock();
+        }
+        if (sleep_ms > lvgl_port_ctx.max_sleep_ms) {
+            sleep_ms = lvgl_port_ctx.max_sleep_ms;
+        } else if (sleep_ms < 1) {
+            sleep_ms = 1;
+        }
+        if (sleep_ms > lvgl_port_ctx.timer_period_ms) {
+            sleep_ms = lvgl_port_ctx.timer_period_ms;
+        }
+        struct timespec ts = {
+            .tv_sec = 0,
+            .tv_nsec = (long)sleep_ms * 1000000,
+        };
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+esp_err_t lvgl_port_init(const lvgl_port_cfg_t *cfg)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lvgl_port_ctx.lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    lv_init();
+    lv_tick_set_cb(lvgl_port_tick_get);
+
+    lvgl_port_ctx.max_sleep_ms = cfg->task_max_sleep_ms;
+    lvgl_port_ctx.timer_period_ms = cfg->timer_period_ms;
+    lvgl_port_ctx.running = true;
+    if (pthread_create(&lvgl_port_ctx.thread, NULL, lvgl_port_task, NULL) != 0) {
+        lvgl_port_ctx.running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t lvgl_port_deinit(void)
+{
+    lvgl_port_ctx.running = false;
+    pthread_join(lvgl_port_ctx.thread, NULL);
+    lv_deinit();
+    pthread_mutex_destroy(&lvgl_port_ctx.lock);
+    return ESP_OK;
+}
+
+bool lvgl_port_lock(uint32_t timeout_ms)
+{
+    /* Timeout 0 means wait forever, the same as on target */
+    if (timeout_ms == 0) {
+        return (pthread_mutex_lock(&lvgl_port_ctx.lock) == 0);
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return (pthread_mutex_timedlock(&lvgl_port_ctx.lock, &ts) == 0);
+}
+
+void lvgl_port_unlock(void)
+{
+    pthread_mutex_unlock(&lvgl_port_ctx.lock);
+}
+
+/* Rendered area is dropped, only rendering is measured */
+static void lvgl_port_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    (void)area;
+    (void)px_map;
+    lv_display_flush_ready(disp);
+}
+
+lv_display_t *lvgl_port_host_add_display(uint32_t hres, uint32_t vres)
+{
+    const uint32_t buff_size = hres * LVGL_PORT_BUFF_LINES * 2;
+    void *buff = malloc(buff_size);
+    if (buff == NULL) {
+        return NULL;
+    }
+
+    lvgl_port_lock(0);
+    lv_display_t *disp = lv_display_create(hres, vres);
+    if (disp) {
+        lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+        lv_display_set_buffers(disp, buff, NULL, buff_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+        lv_display_set_flush_cb(disp, lvgl_port_flush_cb);
+    } else {
+        free(buff);
+    }
+    lvgl_port_unlock();
+    return disp;
+}
@@ -0,0 +1,17 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Trace points are compiled in, but never enabled on host */
+
+#include "player_trace.h"
+
+volatile bool player_trace_on;
+
+void player_trace_event(const char *name, char phase)
+{
+    (void)name;
+    (void)phase;
+}
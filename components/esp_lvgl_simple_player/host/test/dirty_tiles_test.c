@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test of dirty tile detection: change of any bit of any pixel in a tile gives exactly that tile as changed area.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "dirty_tiles.h"
+
+#define TEST_WIDTH      (72)    /* 4 full tiles and a partial one */
+#define TEST_HEIGHT     (40)
+#define TEST_STRIDE     (TEST_WIDTH * 2)
+
+static uint16_t frame[TEST_HEIGHT][TEST_WIDTH];
+static int failures;
+
+static void fill_frame(void)
+{
+    uint32_t seed = 0x12345678;
+    for (int y = 0; y < TEST_HEIGHT; y++) {
+        for (int x = 0; x < TEST_WIDTH; x++) {
+            seed = seed * 1103515245u + 12345u;
+            frame[y][x] = seed >> 16;
+        }
+    }
+}
+
+/* Flip bits of one pixel, expect one area of its tile, then flip back and expect the tile again */
+static void check_pixel(dirty_tiles_t *tiles, int x, int y, uint16_t bits)
+{
+    dirty_area_t areas[DIRTY_AREAS_MAX];
+    const int x1 = x / DIRTY_TILE_SIZE * DIRTY_TILE_SIZE;
+    const int y1 = y / DIRTY_TILE_SIZE * DIRTY_TILE_SIZE;
+    const int x2 = (x1 + DIRTY_TILE_SIZE > TEST_WIDTH ? TEST_WIDTH : x1 + DIRTY_TILE_SIZE) - 1;
+    const int y2 = (y1 + DIRTY_TILE_SIZE > TEST_HEIGHT ? TEST_HEIGHT : y1 + DIRTY_TILE_SIZE) - 1;
+
+    for (int pass = 0; pass < 2; pass++) {
+        frame[y][x] ^= bits;
+        int count = dirty_tiles_update(tiles, (const uint8_t *)frame, TEST_STRIDE, areas);
+        if (count != 1 || areas[0].x1 != x1 || areas[0].y1 != y1 || areas[0].x2 != x2 || areas[0].y2 != y2) {
+            printf("FAIL pixel %d,%d bits 0x%04x: %d areas", x, y, bits, count);
+            if (count > 0) {
+                printf(", first %d,%d - %d,%d", (int)areas[0].x1, (int)areas[0].y1, (int)areas[0].x2, (int)areas[0].y2);
+            }
+            printf(" (expected %d,%d - %d,%d)\n", x1, y1, x2, y2);
+            failures++;
+        }
+    }
+}
+
+int main(void)
+{
+    dirty_tiles_t tiles = { 0 };
+    dirty_area_t areas[DIRTY_AREAS_MAX];
+
+    fill_frame();
+    if (dirty_tiles_init(&tiles, TEST_WIDTH, TEST_HEIGHT) != ESP_OK) {
+        printf("FAIL init\n");
+        return 1;
+    }
+
+    /* First frame is changed whole */
+    int count = dirty_tiles_update(&tiles, (const uint8_t *)frame, TEST_STRIDE, areas);
+    if (count != 1 || areas[0].x1 != 0 || areas[0].y1 != 0 || areas[0].x2 != TEST_WIDTH - 1 || areas[0].y2 != TEST_HEIGHT - 1) {
+        printf("FAIL first frame: %d areas\n", count);
+        failures++;
+    }
+
+    /* Same frame has no change */
+    count = dirty_tiles_update(&tiles, (const uint8_t *)frame, TEST_STRIDE, areas);
+    if (count != 0) {
+        printf("FAIL same frame: %d areas\n", count);
+        failures++;
+    }
+
+    /* Only the last column of the tile (top bits of the odd pixel were lost by shifted words) */
+    check_pixel(&tiles, 15, 0, 0x8000);
+    check_pixel(&tiles, 31, 5, 0xf800);
+
+    /* Every column and bit of one tile line, full tiles and the partial last tile */
+    for (int x = 0; x < TEST_WIDTH; x++) {
+        for (int bit = 0; bit < 16; bit++) {
+            check_pixel(&tiles, x, 17, 1 << bit);
+        }
+    }
+
+    dirty_tiles_deinit(&tiles);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
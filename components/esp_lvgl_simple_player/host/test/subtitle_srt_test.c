@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test of subtitle cue search (also before the first cue and with overlapping cues) and choice of caption slots.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "subtitle_srt.h"
+
+/* First cue starts later, the second one is inside the first one */
+static const char TEST_SRT[] =
+    "1\n"
+    "00:00:01,000 --> 00:00:04,500\n"
+    "Long cue\n"
+    "\n"
+    "2\n"
+    "00:00:02,000 --> 00:00:03,000\n"
+    "Short <i>overlapping</i>\n"
+    "\n"
+    "3\n"
+    "00:00:04,600 --> 00:00:05,000\n"
+    "Last\n";
+
+static int failures;
+
+static void check_find(const subtitle_track_t *track, uint32_t time_ms, int cue, int next)
+{
+    int found_next;
+    int found = subtitle_srt_find(track, time_ms, &found_next);
+    if (found != cue || found_next != next) {
+        printf("FAIL find %lu ms: cue %d next %d (expected %d, %d)\n", (unsigned long)time_ms, found, found_next, cue, next);
+        failures++;
+    }
+}
+
+static void check_slot(int cue0, int cue1, int active, int next, int slot)
+{
+    const int cues[2] = {cue0, cue1};
+    int found = subtitle_srt_slot(cues, 2, active, next);
+    if (found != slot) {
+        printf("FAIL slot of {%d, %d} active %d next %d: %d (expected %d)\n", cue0, cue1, active, next, found, slot);
+        failures++;
+    }
+}
+
+int main(void)
+{
+    subtitle_track_t track;
+    char *data = strdup(TEST_SRT);
+
+    if (data == NULL || subtitle_srt_parse(&track, data, strlen(TEST_SRT)) != ESP_OK || track.count != 3) {
+        printf("FAIL parse\n");
+        return 1;
+    }
+    if (strcmp(track.cues[1].text, "Short overlapping") != 0) {
+        printf("FAIL text \"%s\"\n", track.cues[1].text);
+        failures++;
+    }
+
+    /* Before the first cue only the next one is known */
+    check_find(&track, 0, -1, 0);
+    check_find(&track, 999, -1, 0);
+    check_find(&track, 1000, 0, 1);
+    /* Later started cue is shown, the earlier one is shown again after it */
+    check_find(&track, 2000, 1, 2);
+    check_find(&track, 2999, 1, 2);
+    check_find(&track, 3000, 0, 2);
+    check_find(&track, 4499, 0, 2);
+    check_find(&track, 4500, -1, 2);
+    check_find(&track, 4600, 2, -1);
+    check_find(&track, 5000, -1, -1);
+
+    /* Empty slots are taken first, also before the first cue (no active cue) */
+    check_slot(-1, -1, -1, 0, 0);
+    check_slot(0, -1, 0, 1, 1);
+    check_slot(-1, 0, -1, 0, 0);
+    /* Slot of a cue, which is not wanted anymore */
+    check_slot(0, 1, 1, 2, 0);
+    check_slot(1, 0, 1, 2, 1);
+    check_slot(0, 1, -1, 2, 0);
+    /* Both slots hold the wanted cues */
+    check_slot(1, 2, 1, 2, -1);
+    check_slot(2, 1, 1, 2, -1);
+
+    subtitle_srt_free(&track);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -5,12 +5,18 @@
  */
  
 #pragma once
+#include "esp_err.h"
 #include "lvgl.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define PLAYER_SPEED_MAX    (64)    /* Maximum trick-play speed */
+#define PLAYER_STATS_WINDOW (128)   /* Number of last frames in performance statistics */
+#define PLAYER_OVERLAYS_MAX (4)     /* Maximum number of overlay layers */
+#define PLAYER_PATH_MAX     (128)   /* Maximum path length of media library files */
+
 /**
  * @brief Player states
  */
@@ -21,6 +27,53 @@ typedef enum
     PLAYER_STATE_STOPPED,
 } player_state_t;
 
+/**
+ * @brief Seek modes
+ */
+typedef enum
+{
+    PLAYER_SEEK_TIME_MS,    /* Seek by time in milliseconds (needs known frame rate) */
+    PLAYER_SEEK_FRAME,      /* Seek by frame number */
+    PLAYER_SEEK_PERMILLE,   /* Seek by position in the file in per mille (0 - 1000) */
+} player_seek_t;
+
+/**
+ * @brief Memory of player buffers
+ */
+typedef enum
+{
+    PLAYER_MEM_DEFAULT,     /* Default memory of the buffer (storage cache in internal SRAM, decoder buffers by JPEG driver) */
+    PLAYER_MEM_INTERNAL,    /* Internal SRAM */
+    PLAYER_MEM_PSRAM,       /* External PSRAM */
+} player_mem_t;
+
+/**
+ * @brief Placement of one class of player buffers
+ */
+typedef struct {
+    player_mem_t    mem;    /* Memory of the buffers, default memory is used when it is full (see misplaced of the memory report) */
+    uint32_t        align;  /* Alignment in bytes, power of two (0 = default, lower alignment than needed by DMA is raised) */
+} esp_lvgl_simple_player_mem_cfg_t;
+
+/**
+ * @brief Usage of memory by one class of player buffers
+ */
+typedef struct {
+    uint32_t    buffers;    /* Number of buffers */
+    uint32_t    internal;   /* Bytes in internal SRAM */
+    uint32_t    psram;      /* Bytes in PSRAM */
+    uint32_t    misplaced;  /* Buffers not in the memory or alignment of the placement (it was full, default memory is used) */
+} esp_lvgl_simple_player_mem_usage_t;
+
+/**
+ * @brief Where the player buffers landed
+ */
+typedef struct {
+    esp_lvgl_simple_player_mem_usage_t storage;     /* Caches of the storage */
+    esp_lvgl_simple_player_mem_usage_t encoded;     /* Frames read from file (JPEG decoder input) */
+    esp_lvgl_simple_player_mem_usage_t decoded;     /* Decoded frames incl. frame cache (JPEG decoder output) */
+} esp_lvgl_simple_player_mem_report_t;
+
 /**
  * @brief Player configuration structure
  */
@@ -30,6 +83,20 @@ typedef struct {
     uint32_t    buff_size;      /* Size of the buffer for one video frame */
     uint32_t    screen_width;   /* Width of the video player object */    
     uint32_t    screen_height;  /* Height of the video player object */
+    uint32_t    release_free_mem;   /* Release buffers and decoder on stop, when free memory is lower (0 = always keep) */
+    uint32_t    fps;            /* Frame rate of the video for presentation timing and seeking by time (0 = from AVI file, or play as fast as decoded) */
+    uint32_t    frame_cache_size;   /* Memory for decoded frames of short looping videos in bytes, video which fits is decoded only once (0 = disabled) */
+    struct {
+        uint32_t    max_width;      /* Biggest video width, all player buffers are reserved on create (0 = allocated on play when needed) */
+        uint32_t    max_height;     /* Biggest video height */
+        uint32_t    max_frames;     /* Capacity of the frame index (0 = 9000), AVI and SLV files with more frames are not played */
+        const lv_font_t *caption_font;  /* Font of subtitles, two captions of three lines and 90 % of max_width are reserved (NULL = no subtitles) */
+    } arena;
+    struct {
+        esp_lvgl_simple_player_mem_cfg_t storage;   /* Caches of the storage (bounce buffer of SD card reads) */
+        esp_lvgl_simple_player_mem_cfg_t encoded;   /* Frames read from file */
+        esp_lvgl_simple_player_mem_cfg_t decoded;   /* Decoded frames incl. frame cache */
+    } placement;
     struct {
         unsigned int hide_controls: 1;  /* Hide control buttons */ 
         unsigned int hide_slider: 1;  /* Hide indication slider */ 
@@ -37,9 +104,151 @@ typedef struct {
                 
         unsigned int auto_width: 1;  /* Set automatic width by video size */ 
         unsigned int auto_height: 1;  /* Set automatic height by video size */ 
+        unsigned int seek_enabled: 1;  /* Allow seeking by dragging the slider */
+        unsigned int scrub_preview: 1;  /* Show thumbnail over the dragged slider and seek on release (with seek_enabled, previews are decoded again without esp_lvgl_simple_player_thumbnail_cache()) */
+
+        unsigned int background: 1;  /* Low priority in shared JPEG decoder (previews), video has priority by default */
+        unsigned int show_stats: 1;  /* Show performance statistics over the video */
+        unsigned int dirty_regions: 1;  /* Refresh only changed 16x16 tiles of the video (mostly static content, e.g. slides, UI recordings) */
+        unsigned int adaptive_skip: 1;  /* Decode only every 2nd or 4th frame when decoding is slower than frame rate */
+        unsigned int skip_repeated: 1;  /* Do not decode and draw frames identical to the shown one (slides, hold frames) */
     } flags;
 } esp_lvgl_simple_player_cfg_t;
 
+/**
+ * @brief Thumbnail configuration structure
+ */
+typedef struct {
+    const char  *file;      /* File path */
+    uint32_t    position;   /* Position in the file in per mille (0 - 1000) */
+    uint32_t    buff_size;  /* Size of the buffer for one video frame */
+    uint32_t    width;      /* Width of the thumbnail */
+    uint32_t    height;     /* Height of the thumbnail */
+    uint8_t     *buff;      /* Output buffer for RGB565 thumbnail (width * height * 2 bytes) */
+} esp_lvgl_simple_player_thumb_cfg_t;
+
+/**
+ * @brief Callback of thumbnail generated in background
+ *
+ * @param result   ESP_OK when the buffer of the configuration is filled, error of esp_lvgl_simple_player_get_thumbnail() otherwise
+ * @param cfg      Configuration of the request
+ * @param user_ctx User context of the request
+ */
+typedef void (*esp_lvgl_simple_player_thumb_cb_t)(esp_err_t result, const esp_lvgl_simple_player_thumb_cfg_t *cfg, void *user_ctx);
+
+/**
+ * @brief Snapshot configuration structure
+ */
+typedef struct {
+    const char  *jpeg_file;     /* File for the original JPEG frame (NULL = not written) */
+    uint8_t     *jpeg_buff;     /* Buffer for the original JPEG frame (NULL = not copied) */
+    uint32_t    jpeg_buff_size;
+    const char  *raw_file;      /* File for the shown RGB565 frame with overlays, rows without padding (NULL = not written) */
+    uint8_t     *raw_buff;      /* Buffer for the shown RGB565 frame (width * height * 2 bytes, NULL = not copied) */
+    uint32_t    raw_buff_size;
+} esp_lvgl_simple_player_snapshot_cfg_t;
+
+/**
+ * @brief Snapshot of the shown frame
+ */
+typedef struct {
+    uint32_t    frame;          /* Number of the frame in the video */
+    uint32_t    jpeg_size;      /* Size of the original JPEG frame */
+    uint32_t    width;          /* Size of the shown RGB565 frame (viewport) */
+    uint32_t    height;
+} esp_lvgl_simple_player_snapshot_t;
+
+/**
+ * @brief Overlay layer configuration structure
+ */
+typedef struct {
+    const lv_image_dsc_t *image;    /* RGB565, RGB565A8 or ARGB8888 image, it is pre-composited on adding and not used after */
+    lv_align_t  align;              /* Alignment in the video (LV_ALIGN_DEFAULT = top left) */
+    int32_t     x_ofs;              /* Offset from the aligned position */
+    int32_t     y_ofs;
+} esp_lvgl_simple_player_overlay_cfg_t;
+
+/**
+ * @brief Subtitles configuration structure
+ */
+typedef struct {
+    const char      *file;          /* SRT file */
+    const lv_font_t *font;          /* Font of captions (NULL = LVGL default font) */
+    lv_color_t      color;          /* Color of the text */
+    lv_color_t      bg_color;       /* Color of the box under the text */
+    lv_opa_t        bg_opa;         /* Opacity of the box (LV_OPA_TRANSP = no box) */
+    int32_t         y_ofs;          /* Offset from the bottom of the video (negative = up) */
+    uint32_t        max_width;      /* Longer lines are wrapped (0 = 90 % of the video width) */
+} esp_lvgl_simple_player_subtitles_cfg_t;
+
+/**
+ * @brief Media library configuration structure
+ */
+typedef struct {
+    const char  *root;          /* Scanned directory (e.g. "/sdcard"), hidden files and directories are skipped */
+    const char  *db_file;       /* Database with metadata of scanned files (e.g. "/sdcard/.media.db"), NULL = all files are parsed on open */
+    const char  *extensions;    /* Extensions of video files separated by ';' (NULL = ".mjpeg;.avi;.slv") */
+    uint32_t    max_depth;      /* Maximum depth of scanned subdirectories (0 = root directory only) */
+    uint32_t    fps;            /* Frame rate of raw M-JPEG files for their duration, they have none (0 = 30) */
+    void        (*changed_cb)(void *user_ctx);  /* Called from scanning task, when files in the library changed (can be NULL) */
+    void        *user_ctx;      /* User data for callback */
+} esp_lvgl_simple_player_library_cfg_t;
+
+/**
+ * @brief Metadata of the media library file
+ */
+typedef struct {
+    char        path[PLAYER_PATH_MAX];  /* Full path of the file */
+    uint64_t    file_size;      /* File size in bytes */
+    uint32_t    width;          /* Video size (0 = unknown) */
+    uint32_t    height;
+    uint32_t    fps;            /* Frame rate (configured one for raw M-JPEG, 0 = unknown) */
+    uint32_t    frames;         /* Number of frames (0 = unknown) */
+    uint32_t    duration_ms;    /* Duration (0 = unknown) */
+    uint32_t    max_frame_size; /* Size of the biggest compressed frame (0 = unknown) */
+} esp_lvgl_simple_player_media_info_t;
+
+/**
+ * @brief Measured stages of one frame
+ */
+typedef enum
+{
+    PLAYER_STAT_READ,       /* Reading from storage (us) */
+    PLAYER_STAT_PARSE,      /* Search of frame boundaries (us) */
+    PLAYER_STAT_DECODE,     /* JPEG decoding incl. waiting for shared decoder (us) */
+    PLAYER_STAT_WAIT,       /* Waiting for presentation time (us) */
+    PLAYER_STAT_HANDOFF,    /* From frame publishing to taking it by LVGL task (us) */
+    PLAYER_STAT_PRESENT,    /* Setting frame to canvas and invalidation in LVGL task (us) */
+    PLAYER_STAT_FRAME_SIZE, /* Size of compressed frame (bytes) */
+    PLAYER_STAT_MAX,
+} player_stat_t;
+
+/**
+ * @brief Statistics of one stage over last frames
+ */
+typedef struct {
+    uint32_t    min;
+    uint32_t    avg;
+    uint32_t    p95;
+    uint32_t    max;
+} player_stat_value_t;
+
+/**
+ * @brief Player performance statistics
+ */
+typedef struct {
+    uint32_t    frames_decoded;     /* Decoded frames since play */
+    uint32_t    frames_displayed;   /* Frames taken by LVGL */
+    uint32_t    frames_dropped;     /* Decoded frames replaced by newer frame before LVGL took them */
+    uint32_t    frames_cached;      /* Frames presented from the cache of decoded frames (not read and decoded) */
+    uint32_t    frames_skipped;     /* Frames not decoded to keep speed of the video under load (adaptive_skip) or dropped by decoder deadline */
+    uint32_t    frames_repeated;    /* Frames identical to the shown one, not decoded and not drawn (skip_repeated) */
+    uint32_t    decode_step;        /* Every decode_step frame is decoded now (1, 2 or 4) */
+    uint32_t    skip_changes;       /* Changes of decode_step */
+    uint32_t    samples;            /* Number of frames in statistics (last PLAYER_STATS_WINDOW frames) */
+    player_stat_value_t stage[PLAYER_STAT_MAX];
+} esp_lvgl_simple_player_stats_t;
+
 /**
  * @brief Create Player
  *
@@ -80,11 +289,351 @@ void esp_lvgl_simple_player_pause(void);
  */
 void esp_lvgl_simple_player_stop(void);
 
+/**
+ * @brief Seek in the playing or paused video
+ *
+ * Player lands on the nearest frame boundary. Known frames are found in the index built while playing.
+ * Seek by frame or time behind the indexed part of raw M-JPEG reads the file up to the frame once and indexes it,
+ * seek by per mille is estimated and resynchronized to the next frame start. When called faster than frames
+ * are decoded, only the latest request is processed (also a running index scan is interrupted).
+ *
+ * @param mode  Seek mode
+ * @param value Time in ms, frame number or per mille of the file (by mode)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_STATE  Player is stopped (or its video task exited at the end of video)
+ *      - ESP_ERR_NOT_SUPPORTED  Seek by time without known frame rate
+ */
+esp_err_t esp_lvgl_simple_player_seek(player_seek_t mode, uint32_t value);
+
+/**
+ * @brief Set trick-play speed
+ *
+ * Only every Nth frame is read and decoded, skipped frames are jumped over by the frame index or resynchronized
+ * to the next frame start. Displayed frames keep the normal presentation rate, so the cost per displayed frame
+ * is the same as in normal playing.
+ *
+ * @param speed Speed (1 = normal, 2, 4, 8, 16 ... fast-forward, negative values rewind)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_ARG    Invalid speed
+ */
+esp_err_t esp_lvgl_simple_player_set_speed(int speed);
+
+/**
+ * @brief Get trick-play speed
+ */
+int esp_lvgl_simple_player_get_speed(void);
+
+/**
+ * @brief Release player resources
+ *
+ * Decoder, file storage and frame buffers are kept after stop, so the next play shows the first frame quickly.
+ * This function releases them (they are created again with the next play).
+ *
+ * Resources are released by the video task in background, the function does not wait for it. So it can be called
+ * from any task, also from LVGL event callbacks and with LVGL lock (lvgl_port_lock()) held. Play requested later
+ * starts after the release.
+ *
+ * @return
+ *      - ESP_OK                 Release is requested (or nothing to release)
+ *      - ESP_ERR_INVALID_STATE  Player is not stopped
+ */
+esp_err_t esp_lvgl_simple_player_release(void);
+
+/**
+ * @brief Get time from the last play request to the first shown frame in microseconds
+ */
+uint32_t esp_lvgl_simple_player_get_first_frame_time(void);
+
+/**
+ * @brief Get performance statistics
+ *
+ * Frame counters are counted from the last play, stages are computed from the last frames.
+ */
+esp_err_t esp_lvgl_simple_player_get_stats(esp_lvgl_simple_player_stats_t *stats);
+
+/**
+ * @brief Get memory of the player buffers (internal SRAM or PSRAM) for each class of buffers
+ *
+ * Report is updated by video task when buffers change. It is empty before the first play and after release
+ * (without arena). Buffers of the next playlist file are counted after its preroll.
+ */
+void esp_lvgl_simple_player_get_mem_report(esp_lvgl_simple_player_mem_report_t *report);
+
+/**
+ * @brief Clear performance statistics
+ */
+void esp_lvgl_simple_player_reset_stats(void);
+
+/**
+ * @brief Show performance statistics over the video
+ */
+void esp_lvgl_simple_player_show_stats(bool show);
+
+/**
+ * @brief Save the shown frame
+ *
+ * The original JPEG frame is read again from its span in the file (no encoding), the shown RGB565 frame is copied
+ * from the canvas. Playback is not disturbed, the video task is not blocked and LVGL is locked only for the copy of
+ * the RGB565 frame. Raw file needs temporary memory for the copy.
+ * The player with arena reads the JPEG by storage reserved in the arena and it does not allocate memory, files are
+ * written from jpeg_buff and raw_buff of the caller, which are required with the files.
+ *
+ * @param[in]  cfg      Outputs of the snapshot, any combination of files and buffers
+ * @param[out] snapshot Information about the frame (can be NULL)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_ARG    Invalid argument, file without buffer of the arena player
+ *      - ESP_ERR_INVALID_STATE  No frame is shown (stopped player), other snapshot of the arena player is taken
+ *      - ESP_ERR_INVALID_SIZE   Buffer is too small
+ *      - ESP_ERR_NO_MEM         Not enough memory for raw file
+ *      - ESP_FAIL               Reading of the video or writing of the file failed
+ */
+esp_err_t esp_lvgl_simple_player_snapshot(const esp_lvgl_simple_player_snapshot_cfg_t *cfg, esp_lvgl_simple_player_snapshot_t *snapshot);
+
+/**
+ * @brief Start recording of trace events
+ *
+ * Reading, decoding, presenting and LVGL refresh phases are recorded with timestamps, task and core.
+ * Recording stops when the buffer is full.
+ *
+ * @param max_events Size of the trace buffer in events (one event takes 16 bytes)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t esp_lvgl_simple_player_trace_start(uint32_t max_events);
+
+/**
+ * @brief Stop recording of trace events (recorded events are kept for dump)
+ */
+void esp_lvgl_simple_player_trace_stop(void);
+
+/**
+ * @brief Save recorded trace in Chrome trace-event format (JSON) and free the trace buffer
+ *
+ * File can be opened in chrome://tracing or https://ui.perfetto.dev
+ *
+ * @param path File path, NULL prints trace to stdout
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_STATE  Trace was not started
+ *      - ESP_FAIL               File cannot be created
+ */
+esp_err_t esp_lvgl_simple_player_trace_dump(const char *path);
+
 /**
  * @brief Set repeat playing
  */
 void esp_lvgl_simple_player_repeat(bool repeat);
 
+/**
+ * @brief Get thumbnail (poster frame) from video file without playing it
+ *
+ * The frame nearest to the position is decoded with background priority and scaled into the caller buffer.
+ * Frames of AVI and SLV files are found by their index, frames of raw M-JPEG by the byte position.
+ * Positions are rounded to 1/50 of the file, so with the cache set by esp_lvgl_simple_player_thumbnail_cache()
+ * scrub previews of near positions are served from it.
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_ARG    Invalid configuration
+ *      - ESP_ERR_NOT_FOUND      File cannot be opened or no frame found
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t esp_lvgl_simple_player_get_thumbnail(const esp_lvgl_simple_player_thumb_cfg_t *cfg);
+
+/**
+ * @brief Get thumbnail in background
+ *
+ * Thumbnail is generated by a worker task and callback is called from LVGL task (lv_async_call), so LVGL objects
+ * can be changed in it. Buffer of the configuration is filled right before the callback and it must stay valid until then.
+ * Only the latest request is pending, an older not started request is replaced without callback (e.g. scrolling a list).
+ *
+ * @return
+ *      - ESP_OK                 Request is queued
+ *      - ESP_ERR_INVALID_ARG    Invalid configuration
+ *      - ESP_ERR_NO_MEM         Worker task cannot be created
+ */
+esp_err_t esp_lvgl_simple_player_get_thumbnail_async(const esp_lvgl_simple_player_thumb_cfg_t *cfg, esp_lvgl_simple_player_thumb_cb_t cb, void *user_ctx);
+
+/**
+ * @brief Set directory for thumbnail cache
+ *
+ * Thumbnails are stored in this directory keyed by file path, file size and modification time.
+ *
+ * @param dir Directory for cache files (e.g. "/sdcard/.thumbs"), NULL disables cache
+ */
+esp_err_t esp_lvgl_simple_player_thumbnail_cache(const char *dir);
+
+/**
+ * @brief Add file to the playlist
+ *
+ * When playlist is not empty, player plays its files instead of the file from configuration. Next file is opened
+ * and its first frame decoded in background while the current file is playing, so files follow without gap.
+ * Playlist can be changed only when player is stopped.
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_STATE  Player is not stopped
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t esp_lvgl_simple_player_playlist_add(const char *file);
+
+/**
+ * @brief Remove all files from the playlist
+ */
+esp_err_t esp_lvgl_simple_player_playlist_clear(void);
+
+/**
+ * @brief Play playlist again after the last file
+ */
+void esp_lvgl_simple_player_playlist_loop(bool loop);
+
+/**
+ * @brief Play playlist files in random order
+ */
+void esp_lvgl_simple_player_playlist_shuffle(bool shuffle);
+
+/**
+ * @brief Add static overlay layer over the video
+ *
+ * Image is pre-composited into 16x16 tiles (opaque tiles are copied, transparent ones skipped, the rest is blended
+ * with premultiplied colors) and blended onto every decoded frame in the video task. LVGL then draws only the video,
+ * instead of blending the image over the refreshed video every frame. Put animated parts (e.g. scrolling text) over
+ * the video as LVGL objects, children of esp_lvgl_simple_player_get_video_obj(), so only they are rendered by LVGL.
+ * Changes of overlays are visible from the next decoded frame.
+ *
+ * @param[in]  cfg Overlay configuration
+ * @param[out] id  Identifier of the overlay (can be NULL)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_SUPPORTED  Unsupported image format
+ *      - ESP_ERR_NO_MEM         Not enough memory or PLAYER_OVERLAYS_MAX overlays already added
+ */
+esp_err_t esp_lvgl_simple_player_overlay_add(const esp_lvgl_simple_player_overlay_cfg_t *cfg, int *id);
+
+/**
+ * @brief Show or hide overlay layer
+ */
+esp_err_t esp_lvgl_simple_player_overlay_show(int id, bool show);
+
+/**
+ * @brief Remove overlay layer and free its memory
+ */
+esp_err_t esp_lvgl_simple_player_overlay_remove(int id);
+
+/**
+ * @brief Load subtitles (SRT) for the playing file
+ *
+ * Caption of a cue is rasterized once into a small overlay layer in LVGL task when it becomes active, the next cue is
+ * rasterized ahead. Captions are blended onto decoded frames like overlays, so a frame with caption costs only the
+ * blending of the caption box. Time of a frame is its number divided by the frame rate, so frame rate must be known.
+ * Subtitles stay loaded for the next files, load subtitles of the new file or clear them.
+ * Overlapping cues are not shown together, the last started one is shown (see README).
+ * With the arena, captions use memory reserved for arena.caption_font, lines which do not fit are cut.
+ *
+ * @param[in] cfg Subtitles configuration
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_FOUND      File not found or no cue in the file
+ *      - ESP_ERR_INVALID_SIZE   File is too big
+ *      - ESP_ERR_NOT_SUPPORTED  Arena has no memory for captions (arena.caption_font is not set)
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t esp_lvgl_simple_player_subtitles_load(const esp_lvgl_simple_player_subtitles_cfg_t *cfg);
+
+/**
+ * @brief Remove subtitles and free their memory
+ */
+void esp_lvgl_simple_player_subtitles_clear(void);
+
+/**
+ * @brief Get LVGL object of the video (parent for LVGL objects over the video)
+ */
+lv_obj_t * esp_lvgl_simple_player_get_video_obj(void);
+
+/**
+ * @brief Show only part of the video (pan and zoom)
+ *
+ * The video object shows only the viewport, zoom it with lv_image_set_scale() on esp_lvgl_simple_player_get_video_obj().
+ * Only restart intervals of JPEG covering the viewport are decoded (restart interval must divide MCU row or be multiple
+ * of it, e.g. cjpeg -restart), rest of the entropy data is skipped.
+ * Frames without suitable restart markers are decoded whole and the viewport is only cropped from them.
+ *
+ * @param[in] x       Left edge in pixels of the video
+ * @param[in] y       Top edge in pixels of the video
+ * @param[in] width   Width of the viewport (0 = whole video)
+ * @param[in] height  Height of the viewport (0 = whole video)
+ *
+ * @return
+ *      - ESP_OK               On success
+ *      - ESP_ERR_INVALID_ARG  Only one of width and height is zero
+ */
+esp_err_t esp_lvgl_simple_player_set_viewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+/**
+ * @brief Open media library
+ *
+ * Files from the database are available immediately after this call (one read of the database file), so menus
+ * can be shown without waiting for the storage. The root directory is then scanned in a low priority task. Only new
+ * and changed files (different size or modification time) are parsed, metadata of the others is taken from the database.
+ * The database is rewritten and changed_cb called, when the scan found any change. Files are sorted by path.
+ *
+ * Metadata are read from headers: SLV header, AVI headers and index. Raw M-JPEG files are read whole once to count
+ * their frames, their duration is computed with the configured frame rate. Files which cannot be parsed are stored with
+ * their failure and parsed again when they change (size or modification time), or when the failure was caused by
+ * the storage or memory.
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_ARG    Invalid configuration
+ *      - ESP_ERR_INVALID_STATE  Library is already open
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t esp_lvgl_simple_player_library_open(const esp_lvgl_simple_player_library_cfg_t *cfg);
+
+/**
+ * @brief Scan the library again in background (e.g. after new card was inserted)
+ */
+esp_err_t esp_lvgl_simple_player_library_rescan(void);
+
+/**
+ * @brief Get true, when the library is being scanned
+ */
+bool esp_lvgl_simple_player_library_is_scanning(void);
+
+/**
+ * @brief Get number of files in the library
+ */
+uint32_t esp_lvgl_simple_player_library_count(void);
+
+/**
+ * @brief Get metadata of the library file
+ *
+ * @param[in]  index Index of the file (0 - esp_lvgl_simple_player_library_count() - 1)
+ * @param[out] info  Metadata of the file
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_FOUND      Index out of range
+ *      - ESP_ERR_INVALID_STATE  Library is not open
+ */
+esp_err_t esp_lvgl_simple_player_library_get(uint32_t index, esp_lvgl_simple_player_media_info_t *info);
+
+/**
+ * @brief Stop scanning and free the library
+ */
+void esp_lvgl_simple_player_library_close(void);
+
 /**
  * @brief Delete Player
  *
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "media_src_storage.h"
+#include "frame_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t    width;          /*!< Width of the video */
+    uint32_t    height;         /*!< Height of the video */
+    uint32_t    fps;            /*!< Frames per second (rounded, 0 = unknown) */
+    uint32_t    fps_num;        /*!< Exact frame rate fps_num / fps_den (dwRate / dwScale of the stream, 0 = unknown) */
+    uint32_t    fps_den;
+    uint32_t    max_frame_size; /*!< Size of the biggest frame */
+} avi_demux_info_t;
+
+/**
+ * @brief Check RIFF AVI header at start of the file
+ */
+bool avi_demux_probe(const uint8_t *data, size_t len);
+
+/**
+ * @brief Parse AVI headers and index of the M-JPEG video stream
+ *
+ * Frame rate and size are taken from avih/strh/strf. Frames are taken from OpenDML index (indx/ix##),
+ * legacy idx1 or by walking the movi list, when the file has no index. Index entries point to JPEG data
+ * of the frames (without chunk headers), empty chunks repeat the previous frame.
+ *
+ * @param[in]  src       Connected media source
+ * @param[in]  buff      Work buffer for headers and index (content is overwritten)
+ * @param[in]  buff_size Size of the work buffer
+ * @param[out] info      Video parameters
+ * @param[out] index     Index of all frames (complete)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_SUPPORTED  Not AVI file
+ *      - ESP_ERR_INVALID_VERSION No M-JPEG video stream, or frames beyond 4 GB
+ *      - ESP_ERR_INVALID_SIZE   Corrupted file or headers bigger than work buffer
+ *      - ESP_ERR_NO_MEM         Not enough memory for the index
+ */
+esp_err_t avi_demux_open(media_src_t *src, uint8_t *buff, uint32_t buff_size, avi_demux_info_t *info, frame_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
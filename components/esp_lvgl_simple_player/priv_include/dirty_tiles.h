@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DIRTY_TILE_SIZE     (16)    /*!< Tile size in pixels (MCU size of 4:2:0 JPEG) */
+#define DIRTY_AREAS_MAX     (16)    /*!< Maximum number of areas, more changes are merged into bounding box */
+
+typedef struct {
+    int32_t     x1;
+    int32_t     y1;
+    int32_t     x2;     /*!< Inclusive */
+    int32_t     y2;     /*!< Inclusive */
+} dirty_area_t;
+
+typedef struct {
+    uint32_t    *signatures;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    cols;
+    uint32_t    rows;
+    uint32_t    capacity;   /*!< Number of signatures in memory */
+    bool        valid;      /*!< Signatures of the previous frame are valid */
+    bool        fixed;      /*!< Memory is owned by the caller */
+} dirty_tiles_t;
+
+/**
+ * @brief Use memory of the caller for signatures of up to capacity tiles
+ */
+void dirty_tiles_init_static(dirty_tiles_t *tiles, uint32_t *signatures, uint32_t capacity);
+
+/**
+ * @brief Prepare tile signatures for frame size (memory is reused when size is not bigger)
+ *
+ * @return ESP_ERR_NO_MEM when memory cannot be allocated or the frame has more tiles than memory of the caller
+ */
+esp_err_t dirty_tiles_init(dirty_tiles_t *tiles, uint32_t width, uint32_t height);
+
+/**
+ * @brief Forget previous frame, next update returns whole frame
+ */
+void dirty_tiles_reset(dirty_tiles_t *tiles);
+
+/**
+ * @brief Free tile signatures (memory of the caller is kept)
+ */
+void dirty_tiles_deinit(dirty_tiles_t *tiles);
+
+/**
+ * @brief Compare RGB565 frame with the previous one
+ *
+ * @param[in]  tiles  Tiles
+ * @param[in]  frame  RGB565 frame
+ * @param[in]  stride Line size in bytes
+ * @param[out] areas  Changed areas (DIRTY_AREAS_MAX items)
+ *
+ * @return Number of changed areas (0 when frame is the same)
+ */
+int dirty_tiles_update(dirty_tiles_t *tiles, const uint8_t *frame, uint32_t stride, dirty_area_t *areas);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_lvgl_simple_player.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_CACHE_ALIGN   (128)   /*!< Alignment of frames in memory of the caller (cache line of PSRAM) */
+
+/**
+ * @brief Decoded frames of the whole video by frame number
+ *
+ * Frames are allocated as decoder output buffers with the placement one by one, when they are decoded for the first time.
+ */
+typedef struct {
+    uint8_t     **frames;       /*!< Decoded frames (NULL = not cached) */
+    uint32_t    capacity;       /*!< Maximum number of frames in the budget */
+    uint32_t    count;          /*!< Number of cached frames */
+    uint32_t    frame_size;     /*!< Size of one decoded frame */
+    uint8_t     *mem;           /*!< Memory of the caller for frames (NULL = frames are allocated one by one) */
+    esp_lvgl_simple_player_mem_cfg_t placement;     /*!< Placement of allocated frames */
+} frame_cache_t;
+
+/**
+ * @brief Prepare empty cache
+ *
+ * @param[in] cache      Cache
+ * @param[in] budget     Maximum memory for decoded frames in bytes
+ * @param[in] frame_size Size of one decoded frame
+ * @param[in] placement  Memory of decoded frames (NULL = default)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_SIZE   Not even one frame fits the budget
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t frame_cache_init(frame_cache_t *cache, uint32_t budget, uint32_t frame_size, const esp_lvgl_simple_player_mem_cfg_t *placement);
+
+/**
+ * @brief Prepare empty cache in memory of the caller (decoder output memory)
+ *
+ * Table of frames is at the start of the memory, frames follow it aligned to FRAME_CACHE_ALIGN.
+ *
+ * @param[in] cache      Cache
+ * @param[in] mem        Memory aligned to FRAME_CACHE_ALIGN
+ * @param[in] size       Size of the memory
+ * @param[in] frame_size Size of one decoded frame
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_INVALID_SIZE   Not even one frame fits the memory
+ */
+esp_err_t frame_cache_init_static(frame_cache_t *cache, uint8_t *mem, uint32_t size, uint32_t frame_size);
+
+/**
+ * @brief Free all frames (memory of the caller is kept)
+ */
+void frame_cache_deinit(frame_cache_t *cache);
+
+/**
+ * @brief Get decoded frame, NULL when the frame is not cached
+ */
+uint8_t *frame_cache_get(const frame_cache_t *cache, uint32_t frame);
+
+/**
+ * @brief Allocate buffer of the frame for decoding, NULL when the frame is behind the budget or allocation failed
+ */
+uint8_t *frame_cache_alloc(frame_cache_t *cache, uint32_t frame);
+
+/**
+ * @brief Free frame, whose decoding failed
+ */
+void frame_cache_drop(frame_cache_t *cache, uint32_t frame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fingerprint of encoded frame
+ *
+ * Two lanes hash the data word by word, each step is bijective, so a single changed word always changes the result.
+ *
+ * @param[in] data Encoded frame
+ * @param[in] len  Length of the frame
+ *
+ * @return Hash of the frame
+ */
+uint64_t frame_hash(const uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
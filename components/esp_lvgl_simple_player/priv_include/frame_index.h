@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t    offset;     /*!< Offset of the frame in the file */
+    uint32_t    size;       /*!< Size of the frame */
+} frame_index_entry_t;
+
+typedef struct {
+    frame_index_entry_t *entries;
+    uint32_t            count;      /*!< Number of known frames (frames 0 .. count-1) */
+    uint32_t            capacity;
+    bool                complete;   /*!< All frames of the file are in the index */
+    bool                fixed;      /*!< Entries are owned by the caller, index does not grow */
+} frame_index_t;
+
+/**
+ * @brief Use entries of the caller, frames behind the capacity are not indexed
+ */
+void frame_index_init_static(frame_index_t *index, frame_index_entry_t *entries, uint32_t capacity);
+
+/**
+ * @brief Add frame to the index
+ *
+ * Frames are indexed in order, frame which is not next to the last known frame is ignored.
+ */
+esp_err_t frame_index_add(frame_index_t *index, uint32_t frame, uint32_t offset, uint32_t size);
+
+/**
+ * @brief Allocate index for the number of frames (when it is known in advance)
+ */
+esp_err_t frame_index_reserve(frame_index_t *index, uint32_t frames);
+
+/**
+ * @brief Get frame from the index
+ *
+ * @return true when frame is in the index
+ */
+bool frame_index_get(const frame_index_t *index, uint32_t frame, frame_index_entry_t *entry);
+
+/**
+ * @brief Find frame which contains the offset
+ *
+ * @return true when offset is inside of the indexed part of the file
+ */
+bool frame_index_find(const frame_index_t *index, uint32_t offset, uint32_t *frame);
+
+/**
+ * @brief Average size of the indexed frames (0 when index is empty)
+ */
+uint32_t frame_index_avg_size(const frame_index_t *index);
+
+/**
+ * @brief Remove all frames from the index (memory is kept)
+ */
+void frame_index_clear(frame_index_t *index);
+
+/**
+ * @brief Free index memory (entries of the caller are kept)
+ */
+void frame_index_free(frame_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
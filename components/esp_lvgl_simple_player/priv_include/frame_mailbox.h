@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_MAILBOX_SLOTS     (3)     /*!< Back (written), published and front (shown) frame */
+
+/**
+ * @brief Lock-free single producer / single consumer mailbox of frames (latest frame wins)
+ *
+ * Mailbox only moves slot indexes, frames are owned by the user. Producer writes to the back slot and publishes it,
+ * unread published frame is replaced by newer one. Consumer takes the latest published frame as front slot.
+ */
+typedef struct {
+    atomic_uint shared;     /*!< Published slot, FRAME_MAILBOX_FRESH when not taken yet */
+    uint8_t     back;       /*!< Producer only */
+    uint8_t     front;      /*!< Consumer only */
+} frame_mailbox_t;
+
+/**
+ * @brief Reset mailbox (producer and consumer must not run)
+ *
+ * @param[in] mailbox Mailbox
+ * @param[in] front   Slot shown by consumer
+ */
+void frame_mailbox_reset(frame_mailbox_t *mailbox, uint8_t front);
+
+/**
+ * @brief Slot for writing the next frame (producer)
+ */
+uint8_t frame_mailbox_back(const frame_mailbox_t *mailbox);
+
+/**
+ * @brief Publish back slot, producer gets new back slot (producer)
+ */
+void frame_mailbox_publish(frame_mailbox_t *mailbox);
+
+/**
+ * @brief Take the latest published frame (consumer)
+ *
+ * @return true when front slot was changed to new frame
+ */
+bool frame_mailbox_take(frame_mailbox_t *mailbox);
+
+/**
+ * @brief Slot of the shown frame (consumer)
+ */
+uint8_t frame_mailbox_front(const frame_mailbox_t *mailbox);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_SKIP_LEVELS       (3)     /*!< Every 1st, 2nd or 4th frame is decoded */
+#define FRAME_SKIP_WINDOW       (8)     /*!< Decoded frames in one measurement */
+#define FRAME_SKIP_HIGH_LOAD    (90)    /*!< Load in percent of the time of decoded frame, more frames are skipped above it */
+#define FRAME_SKIP_LOW_LOAD     (40)    /*!< Load in percent, less frames are skipped below it (half of high load and margin) */
+#define FRAME_SKIP_OVERLOAD     (2)     /*!< Windows with high load in row before more frames are skipped */
+#define FRAME_SKIP_RECOVERY     (4)     /*!< Windows with low load in row before less frames are skipped */
+
+/**
+ * @brief Controller of decoded frames under load
+ *
+ * Time spent on each decoded frame (reading of skipped frames, decoding, blending) is compared with the time
+ * of all frames it stands for. Level goes up after short overload (single slow frames are ignored), it goes down
+ * only after longer time with load low enough to stay below the high load at the lower level (hysteresis).
+ */
+typedef struct {
+    uint32_t    level;          /*!< Every (1 << level) frame is decoded */
+    uint32_t    samples;        /*!< Decoded frames in the current window */
+    uint64_t    sum;            /*!< Time of decoded frames in the current window (us) */
+    uint32_t    overload;       /*!< Windows with high load in row */
+    uint32_t    recovery;       /*!< Windows with low load in row */
+} frame_skip_t;
+
+/**
+ * @brief Decode all frames and forget measurement
+ */
+void frame_skip_reset(frame_skip_t *skip);
+
+/**
+ * @brief Add time of one decoded frame
+ *
+ * @param[in] skip       Controller
+ * @param[in] frame_time Time spent on the decoded frame (us)
+ * @param[in] budget     Time of one frame of the video (us)
+ *
+ * @return true when the level was changed
+ */
+bool frame_skip_update(frame_skip_t *skip, uint32_t frame_time, uint32_t budget);
+
+/**
+ * @brief Every step frame is decoded (1, 2 or 4)
+ */
+static inline uint32_t frame_skip_step(const frame_skip_t *skip)
+{
+    return 1 << skip->level;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/jpeg_decode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JPEG_DEC_SERVICE_MAX_CLIENTS    (8)    /*!< Maximum number of streams sharing the decoder */
+
+/**
+ * @brief Decoder priorities (higher value wins)
+ */
+#define JPEG_DEC_PRIORITY_BACKGROUND    (0)    /*!< Thumbnails, previews */
+#define JPEG_DEC_PRIORITY_NORMAL        (8)
+#define JPEG_DEC_PRIORITY_FOREGROUND    (16)   /*!< Visible video */
+
+#define JPEG_DEC_DEADLINE_RELAXED_US    (1000 * 1000)  /*!< Deadline of jobs which are not shown at once (preroll, thumbnails) */
+
+#define JPEG_DEC_ERR_LATE               (0x6a01)       /*!< Job was dropped by its deadline (not returned by the driver) */
+
+typedef struct jpeg_dec_client_s *jpeg_dec_client_handle_t;
+
+/**
+ * @brief Register new stream in the shared JPEG decoder service
+ *
+ * The first client creates the hardware engine and the scheduler task, the last deleted client releases them.
+ *
+ * @param[in]  priority  Priority of the stream, jobs with higher priority are decoded first
+ * @param[out] ret_client Created client handle
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NO_MEM         Not enough memory or all client slots are used
+ */
+esp_err_t jpeg_dec_service_client_new(uint8_t priority, jpeg_dec_client_handle_t *ret_client);
+
+/**
+ * @brief Unregister stream from the shared JPEG decoder service
+ */
+esp_err_t jpeg_dec_service_client_del(jpeg_dec_client_handle_t client);
+
+/**
+ * @brief Change priority of the stream
+ */
+void jpeg_dec_service_client_set_priority(jpeg_dec_client_handle_t client, uint8_t priority);
+
+/**
+ * @brief Decode one JPEG picture (blocking)
+ *
+ * Job is queued to the service and scheduled by client priority, jobs with the same priority are ordered by deadline.
+ * Job which was not started before its deadline is dropped without touching the engine.
+ *
+ * @param[in]  client      Client handle
+ * @param[in]  cfg         Decoder configuration
+ * @param[in]  in          Input JPEG data
+ * @param[in]  in_size     Size of input data
+ * @param[out] out         Output buffer (allocated by jpeg_alloc_decoder_mem)
+ * @param[in]  out_size    Size of output buffer
+ * @param[in]  deadline_us Absolute deadline in esp_timer time, 0 means no deadline
+ * @param[out] ret_size    Size of decoded data
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - JPEG_DEC_ERR_LATE      Deadline passed before the job was started
+ *      - Others                 Error from jpeg_decoder_process (ESP_ERR_TIMEOUT is a timeout of the engine)
+ */
+esp_err_t jpeg_dec_service_decode(jpeg_dec_client_handle_t client, const jpeg_decode_cfg_t *cfg,
+                                  const uint8_t *in, uint32_t in_size, uint8_t *out, uint32_t out_size,
+                                  int64_t deadline_us, uint32_t *ret_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t    x;
+    uint32_t    y;
+    uint32_t    width;
+    uint32_t    height;
+} jpeg_roi_rect_t;
+
+/**
+ * @brief Crop baseline JPEG picture to MCUs covering the region, without decoding
+ *
+ * Restart intervals of the picture are independent (DC prediction is reset on restart marker), so only intervals
+ * covering the region are kept and restart markers are numbered again. Restart interval must divide MCU row
+ * (columns and rows are cropped) or it must be multiple of MCU row (only rows are cropped).
+ * Picture is rewritten in place, it is never longer than the original one.
+ *
+ * @param[in,out] data   JPEG picture
+ * @param[in]     len    Length of the picture
+ * @param[in]     roi    Requested region in pixels
+ * @param[out]    crop   Region of the cropped picture in pixels of the original picture (contains roi)
+ * @param[out]    out_len Length of the cropped picture
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_SUPPORTED  Picture without suitable restart interval, progressive or multi-scan picture
+ *      - ESP_ERR_INVALID_SIZE   Damaged picture or region outside of the picture
+ */
+esp_err_t jpeg_roi_crop(uint8_t *data, uint32_t len, const jpeg_roi_rect_t *roi, jpeg_roi_rect_t *crop, uint32_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
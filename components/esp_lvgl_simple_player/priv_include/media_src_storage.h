@@ -15,9 +15,21 @@ typedef struct {
 } media_src_t;
 
 int media_src_storage_open(media_src_t *src);
+/* Size of the cache for media_src_storage_open_cache() (0 = storage without cache) */
+size_t media_src_storage_cache_size(void);
+/* Open with cache allocated by the caller (aligned to 64 bytes, DMA capable), close frees it */
+int media_src_storage_open_cache(media_src_t *src, void *cache);
+/* Cache of the opened storage (NULL = no cache) */
+const void *media_src_storage_get_cache(media_src_t *src);
+/* Size of memory for media_src_storage_open_static() */
+size_t media_src_storage_mem_size(void);
+/* Open in memory of the caller (internal memory aligned to 64 bytes), close does not free it */
+int media_src_storage_open_static(media_src_t *src, void *mem);
 int media_src_storage_connect(media_src_t *src, char *uri);
 int media_src_storage_disconnect(media_src_t *src);
 int media_src_storage_read(media_src_t *src, void *data, size_t len);
+/* Read from position, whole sectors (512 bytes) are read by one direct read without the cache */
+int media_src_storage_read_at(media_src_t *src, uint64_t position, void *data, size_t len);
 int media_src_storage_seek(media_src_t *src, uint64_t position);
 int media_src_storage_get_position(media_src_t *src, uint64_t *position);
 int media_src_storage_get_size(media_src_t *src, uint64_t *size);
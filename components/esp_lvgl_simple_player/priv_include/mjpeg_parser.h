@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Find start of the JPEG frame (SOI marker FF D8 FF)
+ *
+ * @return Offset of the SOI marker in data or -1 if not found
+ */
+int mjpeg_find_frame_start(const uint8_t *data, size_t len);
+
+/**
+ * @brief Find end of the JPEG frame (EOI marker FF D9)
+ *
+ * @return Size of the frame including EOI marker or -1 if not found
+ */
+int mjpeg_find_frame_end(const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVERLAY_TILE_SIZE   (16)    /*!< Tile size in pixels */
+
+typedef enum {
+    OVERLAY_TILE_TRANSPARENT,       /*!< Tile is skipped */
+    OVERLAY_TILE_OPAQUE,            /*!< Tile lines are copied */
+    OVERLAY_TILE_BLEND,             /*!< Tile pixels are blended */
+} overlay_tile_t;
+
+typedef struct {
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    cols;
+    uint32_t    rows;
+    uint16_t    *color;     /*!< Premultiplied RGB565 pixels */
+    uint8_t     *alpha;     /*!< Inverse alpha of pixels (0 = opaque, 32 = transparent) */
+    uint8_t     *tiles;     /*!< Type of tiles (overlay_tile_t) */
+    bool        fixed;      /*!< Memory is owned by the caller */
+} overlay_layer_t;
+
+/**
+ * @brief Pre-composite image to the layer
+ *
+ * Supported image formats are RGB565, RGB565A8 and ARGB8888. Image is not used after this call.
+ */
+esp_err_t overlay_layer_init(overlay_layer_t *layer, const lv_image_dsc_t *image);
+
+/**
+ * @brief Size of memory for layer of the size
+ */
+uint32_t overlay_layer_mem_size(uint32_t width, uint32_t height);
+
+/**
+ * @brief Pre-composite image to the layer in memory of the caller (nothing is allocated)
+ *
+ * @return ESP_ERR_INVALID_SIZE when the layer does not fit into the memory
+ */
+esp_err_t overlay_layer_init_static(overlay_layer_t *layer, const lv_image_dsc_t *image, void *mem, uint32_t mem_size);
+
+/**
+ * @brief Free layer memory (memory of the caller is kept)
+ */
+void overlay_layer_deinit(overlay_layer_t *layer);
+
+/**
+ * @brief Blend layer onto RGB565 frame
+ *
+ * @param[in] layer  Layer
+ * @param[in] x      Position of the layer in the frame (layer can be partially outside)
+ * @param[in] y
+ * @param[in] frame  RGB565 frame
+ * @param[in] stride Line size in bytes
+ * @param[in] width  Width of the frame
+ * @param[in] height Height of the frame
+ */
+void overlay_layer_blend(const overlay_layer_t *layer, int32_t x, int32_t y, uint8_t *frame, uint32_t stride, uint32_t width, uint32_t height);
+
+#ifdef __cplusplus
+}
+#endif
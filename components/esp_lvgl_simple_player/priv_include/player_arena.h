@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "player_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLAYER_ARENA_ALIGN      (128)   /*!< Minimal alignment of parts (cache line of PSRAM) */
+
+typedef enum {
+    PLAYER_ARENA_STORAGE = PLAYER_MEM_CLASS_STORAGE,    /*!< Caches of storage */
+    PLAYER_ARENA_ENCODED = PLAYER_MEM_CLASS_ENCODED,    /*!< Input buffers of JPEG decoder */
+    PLAYER_ARENA_DECODED = PLAYER_MEM_CLASS_DECODED,    /*!< Output buffers of JPEG decoder */
+    PLAYER_ARENA_ANY,           /*!< Any memory (indexes, signatures of tiles) */
+    PLAYER_ARENA_MEM_MAX,
+} player_arena_mem_t;
+
+/**
+ * @brief Memory of the player reserved at once and divided into fixed parts
+ *
+ * Layout is done twice by the same code: before player_arena_reserve() parts are only counted (NULL is returned),
+ * after it they are taken from the reserved memory. Parts are never returned, the memory is freed at once.
+ */
+typedef struct {
+    uint8_t     *base[PLAYER_ARENA_MEM_MAX];
+    uint32_t    size[PLAYER_ARENA_MEM_MAX];
+    uint32_t    used[PLAYER_ARENA_MEM_MAX];
+    esp_lvgl_simple_player_mem_cfg_t placement[PLAYER_MEM_CLASS_MAX];   /*!< Placement of memory of buffer classes */
+} player_arena_t;
+
+/**
+ * @brief Set placement of memory for buffer class, before the first layout
+ */
+void player_arena_set_placement(player_arena_t *arena, player_arena_mem_t mem, const esp_lvgl_simple_player_mem_cfg_t *placement);
+
+/**
+ * @brief Take part of the memory, NULL before reservation or when the part does not fit
+ */
+void *player_arena_take(player_arena_t *arena, player_arena_mem_t mem, uint32_t size);
+
+/**
+ * @brief Reserve memory of all counted parts, next layout takes them
+ *
+ * @return
+ *      - ESP_OK            On success
+ *      - ESP_ERR_NO_MEM    Not enough memory
+ */
+esp_err_t player_arena_reserve(player_arena_t *arena);
+
+/**
+ * @brief Total size of reserved memory
+ */
+uint32_t player_arena_size(const player_arena_t *arena);
+
+/**
+ * @brief Free reserved memory
+ */
+void player_arena_free(player_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
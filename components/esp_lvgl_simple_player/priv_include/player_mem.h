@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lvgl_simple_player.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLAYER_MEM_STORAGE_ALIGN    (64)    /*!< Minimal alignment of storage cache (DMA of SD card) */
+#define PLAYER_MEM_DECODER_ALIGN    (128)   /*!< Minimal alignment of decoder buffers (cache line of PSRAM) */
+
+/**
+ * @brief Classes of player buffers with their own placement
+ */
+typedef enum {
+    PLAYER_MEM_CLASS_STORAGE,   /*!< Cache of the storage, internal by default */
+    PLAYER_MEM_CLASS_ENCODED,   /*!< Input of JPEG decoder, placed by JPEG driver by default */
+    PLAYER_MEM_CLASS_DECODED,   /*!< Output of JPEG decoder, placed by JPEG driver by default */
+    PLAYER_MEM_CLASS_MAX,
+} player_mem_class_t;
+
+/**
+ * @brief Allocate buffer of the class with the placement
+ *
+ * Size is aligned up to the alignment. When the requested memory is full, default memory of the class is used.
+ *
+ * @param[in]  placement Placement of the class (NULL = default)
+ * @param[in]  mem_class Class of the buffer
+ * @param[in]  size      Size of the buffer
+ * @param[out] out_size  Allocated size (can be NULL)
+ *
+ * @return Buffer or NULL when there is no memory
+ */
+void *player_mem_alloc(const esp_lvgl_simple_player_mem_cfg_t *placement, player_mem_class_t mem_class, uint32_t size, uint32_t *out_size);
+
+/**
+ * @brief Memory where the buffer landed (PLAYER_MEM_INTERNAL or PLAYER_MEM_PSRAM)
+ */
+player_mem_t player_mem_of(const void *buff);
+
+/**
+ * @brief Add buffer to the usage of its class, buffer outside of the placement is counted as misplaced (NULL buffer is ignored)
+ */
+void player_mem_count(esp_lvgl_simple_player_mem_usage_t *usage, const esp_lvgl_simple_player_mem_cfg_t *placement, const void *buff, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_lvgl_simple_player.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Ring buffers of the last frame samples, one per stage
+ *
+ * Each stage has one writer (video task or LVGL task), lock only keeps query consistent.
+ */
+typedef struct {
+    portMUX_TYPE    lock;
+    uint32_t        samples[PLAYER_STAT_MAX][PLAYER_STATS_WINDOW];
+    uint32_t        head[PLAYER_STAT_MAX];
+    uint32_t        count[PLAYER_STAT_MAX];
+    uint32_t        decoded;
+    uint32_t        displayed;
+    uint32_t        dropped;
+    uint32_t        cached;
+    uint32_t        skipped;
+    uint32_t        repeated;
+    uint32_t        skip_changes;
+    uint32_t        skip_step;
+} player_stats_t;
+
+/**
+ * @brief Clear all samples and counters
+ */
+void player_stats_reset(player_stats_t *stats);
+
+/**
+ * @brief Add sample of one stage
+ */
+void player_stats_add(player_stats_t *stats, player_stat_t stage, uint32_t value);
+
+/**
+ * @brief Compute min/avg/p95/max of all stages
+ */
+void player_stats_get(player_stats_t *stats, esp_lvgl_simple_player_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
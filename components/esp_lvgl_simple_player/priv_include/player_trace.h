@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set only while tracing is running, so disabled trace points cost one load and branch */
+extern volatile bool player_trace_on;
+
+/**
+ * @brief Record trace event of the current task
+ *
+ * @param[in] name  Event name (must be static string)
+ * @param[in] phase Chrome trace phase ('B' begin, 'E' end, 'i' instant)
+ */
+void player_trace_event(const char *name, char phase);
+
+#define PLAYER_TRACE_BEGIN(name)    do { if (player_trace_on) { player_trace_event(name, 'B'); } } while (0)
+#define PLAYER_TRACE_END(name)      do { if (player_trace_on) { player_trace_event(name, 'E'); } } while (0)
+#define PLAYER_TRACE_INSTANT(name)  do { if (player_trace_on) { player_trace_event(name, 'i'); } } while (0)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "media_src_storage.h"
+#include "frame_index.h"
+#include "slv_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t        width;          /*!< Width of the video */
+    uint32_t        height;         /*!< Height of the video */
+    uint32_t        fps;            /*!< Frames per second (rounded, 0 = unknown) */
+    uint32_t        max_frame_size; /*!< Size of the biggest frame */
+    uint32_t        align;          /*!< Frames can be read with padding up to multiple of align */
+    slv_sampling_t  sampling;       /*!< Chroma subsampling of the frames */
+} slv_demux_info_t;
+
+/**
+ * @brief Check SLV header at start of the file
+ */
+bool slv_demux_probe(const uint8_t *data, size_t len);
+
+/**
+ * @brief Parse SLV header and read its frame table to the index
+ *
+ * Frame table is read by one read directly to the index.
+ *
+ * @param[in]  src       Connected media source
+ * @param[in]  data      Start of the file (at least header)
+ * @param[in]  len       Length of data
+ * @param[out] info      Video parameters
+ * @param[out] index     Index of all frames (complete)
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_SUPPORTED  Not SLV file
+ *      - ESP_ERR_INVALID_VERSION Unsupported SLV version
+ *      - ESP_ERR_INVALID_SIZE   Corrupted or truncated file
+ *      - ESP_ERR_NO_MEM         Not enough memory for the index
+ */
+esp_err_t slv_demux_open(media_src_t *src, const uint8_t *data, size_t len, slv_demux_info_t *info, frame_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
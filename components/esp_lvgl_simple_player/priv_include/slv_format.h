@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SLV (Simple LVGL Video) file format, written by host tool slv_convert.
+ *
+ *   header (slv_header_t) | frame table (frame_count x slv_frame_t) | padding | frames
+ *
+ * All numbers are little endian. Every frame is one JPEG picture, it starts at multiple of align and it is
+ * padded with zeros up to the next multiple of align (also the last one), so every frame can be read by one
+ * sector aligned read. Repeated frames point to the same data.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SLV_MAGIC           "SLVP"
+#define SLV_VERSION         (1)
+#define SLV_DEFAULT_ALIGN   (512)   /* Sector size of SD cards */
+
+typedef enum {
+    SLV_SAMPLING_UNKNOWN = 0,
+    SLV_SAMPLING_444,
+    SLV_SAMPLING_422,
+    SLV_SAMPLING_420,
+    SLV_SAMPLING_GRAY,
+} slv_sampling_t;
+
+typedef struct __attribute__((packed)) {
+    char        magic[4];       /*!< SLV_MAGIC */
+    uint16_t    version;        /*!< SLV_VERSION */
+    uint16_t    header_size;    /*!< Size of the header, newer versions may add fields behind */
+    uint16_t    width;          /*!< Width of the video */
+    uint16_t    height;         /*!< Height of the video */
+    uint32_t    fps_num;        /*!< Frame rate is fps_num / fps_den (0 = unknown) */
+    uint32_t    fps_den;
+    uint32_t    frame_count;    /*!< Number of frames in the table */
+    uint32_t    max_frame_size; /*!< Size of the biggest frame (without padding) */
+    uint32_t    align;          /*!< Alignment of frames (power of two) */
+    uint32_t    table_offset;   /*!< Offset of the frame table */
+    uint8_t     sampling;       /*!< Chroma subsampling of all frames (slv_sampling_t), hint for output buffers */
+    uint8_t     reserved[27];
+} slv_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t    offset;         /*!< Offset of the frame, multiple of align */
+    uint32_t    size;           /*!< Size of the JPEG picture (without padding) */
+} slv_frame_t;
+
+#ifdef __cplusplus
+}
+#endif
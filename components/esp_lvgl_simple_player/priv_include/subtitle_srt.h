@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SUBTITLE_SRT_MAX_SIZE   (256 * 1024)    /*!< Maximum size of SRT file */
+
+typedef struct {
+    uint32_t    start_ms;
+    uint32_t    end_ms;
+    const char  *text;      /*!< Lines separated by '\n', formatting tags are removed */
+} subtitle_cue_t;
+
+typedef struct {
+    subtitle_cue_t  *cues;  /*!< Sorted by start time */
+    uint32_t        count;
+    uint32_t        max_duration_ms;    /*!< The longest cue, earlier cues still shown are searched back by it */
+    char            *data;  /*!< Content of the file, texts of cues point into it */
+} subtitle_track_t;
+
+/**
+ * @brief Load SRT file
+ *
+ * @return
+ *      - ESP_OK                 On success
+ *      - ESP_ERR_NOT_FOUND      File not found or no cue in the file
+ *      - ESP_ERR_INVALID_SIZE   File is bigger than SUBTITLE_SRT_MAX_SIZE
+ *      - ESP_ERR_NO_MEM         Not enough memory
+ */
+esp_err_t subtitle_srt_load(subtitle_track_t *track, const char *path);
+
+/**
+ * @brief Parse SRT text
+ *
+ * Text is changed in place and it is owned by the track then (freed by subtitle_srt_free(), or here on error).
+ *
+ * @param[out] track Track
+ * @param[in]  data  Text terminated by zero, allocated by malloc
+ * @param[in]  len   Length of the text
+ */
+esp_err_t subtitle_srt_parse(subtitle_track_t *track, char *data, uint32_t len);
+
+/**
+ * @brief Free track
+ */
+void subtitle_srt_free(subtitle_track_t *track);
+
+/**
+ * @brief Find cue shown in the time
+ *
+ * Only one cue is shown: from overlapping cues the last started one, which is still shown. When it ends before
+ * an earlier started cue, the earlier one is shown again for the rest of its time.
+ *
+ * @param[in]  track   Track
+ * @param[in]  time_ms Time in the video
+ * @param[out] next    Index of the next cue starting after the time (-1 = none, can be NULL)
+ *
+ * @return Index of the cue (-1 = no cue is shown)
+ */
+int subtitle_srt_find(const subtitle_track_t *track, uint32_t time_ms, int *next);
+
+/**
+ * @brief Choose slot of rasterized captions for a cue
+ *
+ * Empty slot is taken first, then a slot with a cue which is neither the active nor the next one.
+ *
+ * @param[in] cues   Cues in the slots (-1 = empty slot)
+ * @param[in] count  Number of slots
+ * @param[in] active Shown cue (-1 = none)
+ * @param[in] next   Next cue (-1 = none)
+ *
+ * @return Index of the slot (-1 = all slots hold the active and the next cue)
+ */
+int subtitle_srt_slot(const int *cues, int count, int active, int next);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,321 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "avi_demux.h"
+
+#define FOURCC(a, b, c, d)      ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+
+#define AVI_IDX1_ENTRY_SIZE     (16)    /* ckid, flags, offset, size */
+#define AVI_INDX_ENTRY_SIZE     (16)    /* qwOffset, dwSize, dwDuration */
+#define AVI_IX_HEADER_SIZE      (32)    /* Chunk header and standard index header */
+#define AVI_INDEX_OF_INDEXES    (0x00)
+#define AVI_INDEX_OF_CHUNKS     (0x01)
+#define AVI_IX_DELTA_FRAME      (0x80000000)
+
+static const char *TAG = "AVI_DEMUX";
+
+typedef struct {
+    media_src_t *src;
+    uint8_t     *buff;
+    uint32_t    buff_size;
+    uint64_t    file_size;
+
+    int         stream;         /* Number of the video stream (-1 = not found) */
+    uint32_t    frames;         /* Number of frames from headers */
+    uint32_t    movi_pos;       /* Position of the 'movi' list type */
+    uint32_t    movi_end;
+    uint32_t    idx1_pos;       /* Position of idx1 data (0 = no idx1) */
+    uint32_t    idx1_size;
+    uint32_t    indx_pos;       /* Position of OpenDML super index entries (0 = no indx) */
+    uint32_t    indx_count;
+} avi_parser_t;
+
+static uint16_t avi_u16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t avi_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t avi_u64(const uint8_t *p)
+{
+    return avi_u32(p) | ((uint64_t)avi_u32(p + 4) << 32);
+}
+
+static bool avi_read_at(avi_parser_t *p, uint64_t pos, void *data, uint32_t len)
+{
+    if (media_src_storage_seek(p->src, pos) != 0) {
+        return false;
+    }
+    return (media_src_storage_read(p->src, data, len) == (int)len);
+}
+
+/* Video chunk of the stream: "##dc" (compressed) or "##db" */
+static bool avi_is_video_chunk(const avi_parser_t *p, uint32_t ckid)
+{
+    const uint32_t id = FOURCC('0' + p->stream / 10, '0' + p->stream % 10, 'd', 0);
+    return ((ckid & 0x00ffffff) == id && ((ckid >> 24) == 'c' || (ckid >> 24) == 'b'));
+}
+
+static esp_err_t avi_add_frame(avi_parser_t *p, frame_index_t *index, avi_demux_info_t *info, uint64_t offset, uint32_t size)
+{
+    frame_index_entry_t prev;
+
+    /* Empty chunk repeats the previous frame (dropped frame of capture) */
+    if (size == 0) {
+        if (index->count == 0) {
+            return ESP_OK;
+        }
+        frame_index_get(index, index->count - 1, &prev);
+        offset = prev.offset;
+        size = prev.size;
+    }
+    ESP_RETURN_ON_FALSE(offset + size <= UINT32_MAX, ESP_ERR_INVALID_VERSION, TAG, "Frames beyond 4 GB are not supported");
+    if (offset + size > p->file_size) {
+        /* Truncated file */
+        return ESP_OK;
+    }
+    info->max_frame_size = MAX(info->max_frame_size, size);
+    return frame_index_add(index, index->count, (uint32_t)offset, size);
+}
+
+static bool avi_is_mjpeg(uint32_t fourcc)
+{
+    return (fourcc == FOURCC('M', 'J', 'P', 'G') || fourcc == FOURCC('m', 'j', 'p', 'g') ||
+            fourcc == FOURCC('J', 'P', 'E', 'G') || fourcc == FOURCC('j', 'p', 'e', 'g'));
+}
+
+/* Stream list, only the first video stream is used */
+static esp_err_t avi_parse_strl(avi_parser_t *p, const uint8_t *data, uint32_t len, uint32_t data_pos, int stream, avi_demux_info_t *info)
+{
+    bool video = false;
+
+    for (uint64_t pos = 0; pos + 8 <= len; pos += 8 + ALIGN_UP((uint64_t)avi_u32(data + pos + 4), 2)) {
+        const uint32_t id = avi_u32(data + pos);
+        const uint32_t size = MIN(avi_u32(data + pos + 4), len - pos - 8);
+        const uint8_t *body = data + pos + 8;
+
+        if (id == FOURCC('s', 't', 'r', 'h') && size >= 36) {
+            if (avi_u32(body) != FOURCC('v', 'i', 'd', 's') || p->stream >= 0) {
+                return ESP_OK;
+            }
+            video = true;
+            p->stream = stream;
+            const uint32_t scale = avi_u32(body + 20);
+            const uint32_t rate = avi_u32(body + 24);
+            if (scale > 0 && rate > 0) {
+                info->fps = (rate + scale / 2) / scale;
+                info->fps_num = rate;
+                info->fps_den = scale;
+            }
+            p->frames = MAX(p->frames, avi_u32(body + 32));
+        } else if (video && id == FOURCC('s', 't', 'r', 'f') && size >= 20) {
+            /* BITMAPINFOHEADER, height is negative for top-down pictures */
+            int32_t height = (int32_t)avi_u32(body + 8);
+            info->width = avi_u32(body + 4);
+            info->height = (height < 0 ? -height : height);
+            ESP_RETURN_ON_FALSE(avi_is_mjpeg(avi_u32(body + 16)), ESP_ERR_INVALID_VERSION, TAG, "Video stream is not M-JPEG");
+        } else if (video && id == FOURCC('i', 'n', 'd', 'x') && size >= 24) {
+            /* OpenDML super index, entries are read when the index is built */
+            if (avi_u16(body) == 4 && body[3] == AVI_INDEX_OF_INDEXES) {
+                p->indx_pos = data_pos + pos + 8 + 24;
+                p->indx_count = MIN(avi_u32(body + 4), (size - 24) / AVI_INDX_ENTRY_SIZE);
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t avi_parse_hdrl(avi_parser_t *p, const uint8_t *data, uint32_t len, uint32_t data_pos, avi_demux_info_t *info)
+{
+    int stream = 0;
+
+    for (uint64_t pos = 0; pos + 8 <= len; pos += 8 + ALIGN_UP((uint64_t)avi_u32(data + pos + 4), 2)) {
+        const uint32_t id = avi_u32(data + pos);
+        const uint32_t size = MIN(avi_u32(data + pos + 4), len - pos - 8);
+        const uint8_t *body = data + pos + 8;
+
+        if (id == FOURCC('a', 'v', 'i', 'h') && size >= 40) {
+            /* Main header is used when stream headers do not give the values */
+            const uint32_t us_per_frame = avi_u32(body);
+            if (info->fps == 0 && us_per_frame > 0) {
+                info->fps = (1000000 + us_per_frame / 2) / us_per_frame;
+                info->fps_num = 1000000;
+                info->fps_den = us_per_frame;
+            }
+            p->frames = MAX(p->frames, avi_u32(body + 16));
+            if (info->width == 0) {
+                info->width = avi_u32(body + 32);
+                info->height = avi_u32(body + 36);
+            }
+        } else if (id == FOURCC('L', 'I', 'S', 'T') && size >= 4 && avi_u32(body) == FOURCC('s', 't', 'r', 'l')) {
+            ESP_RETURN_ON_ERROR(avi_parse_strl(p, body + 4, size - 4, data_pos + pos + 12, stream, info), TAG, "Stream header");
+            stream++;
+        }
+    }
+    return ESP_OK;
+}
+
+/* OpenDML: super index points to standard indexes (ix##) with offsets of frame data */
+static esp_err_t avi_index_indx(avi_parser_t *p, frame_index_t *index, avi_demux_info_t *info)
+{
+    const uint32_t batch = p->buff_size / 8;
+
+    for (uint32_t i = 0; i < p->indx_count; i++) {
+        uint8_t entry[AVI_INDX_ENTRY_SIZE];
+        uint8_t header[AVI_IX_HEADER_SIZE];
+        ESP_RETURN_ON_FALSE(avi_read_at(p, p->indx_pos + i * AVI_INDX_ENTRY_SIZE, entry, sizeof(entry)), ESP_ERR_INVALID_SIZE, TAG, "Read indx failed");
+        const uint64_t ix_pos = avi_u64(entry);
+        ESP_RETURN_ON_FALSE(avi_read_at(p, ix_pos, header, sizeof(header)), ESP_ERR_INVALID_SIZE, TAG, "Read ix chunk failed");
+        ESP_RETURN_ON_FALSE(avi_u16(header + 8) == 2 && header[11] == AVI_INDEX_OF_CHUNKS, ESP_ERR_INVALID_SIZE, TAG, "Unknown ix chunk");
+
+        const uint32_t count = avi_u32(header + 12);
+        const uint64_t base = avi_u64(header + 20);
+        for (uint32_t done = 0; done < count; ) {
+            const uint32_t n = MIN(count - done, batch);
+            ESP_RETURN_ON_FALSE(avi_read_at(p, ix_pos + AVI_IX_HEADER_SIZE + done * 8, p->buff, n * 8), ESP_ERR_INVALID_SIZE, TAG, "Read ix entries failed");
+            for (uint32_t j = 0; j < n; j++) {
+                const uint32_t offset = avi_u32(p->buff + j * 8);
+                const uint32_t size = avi_u32(p->buff + j * 8 + 4) & ~AVI_IX_DELTA_FRAME;
+                ESP_RETURN_ON_ERROR(avi_add_frame(p, index, info, base + offset, size), TAG, "Add frame failed");
+            }
+            done += n;
+        }
+    }
+    return ESP_OK;
+}
+
+/* Legacy index, offsets are relative to the movi list or absolute (both are written by encoders) */
+static esp_err_t avi_index_idx1(avi_parser_t *p, frame_index_t *index, avi_demux_info_t *info)
+{
+    const uint32_t batch = p->buff_size / AVI_IDX1_ENTRY_SIZE;
+    const uint32_t count = p->idx1_size / AVI_IDX1_ENTRY_SIZE;
+    int64_t base = -1;
+
+    for (uint32_t done = 0; done < count; ) {
+        const uint32_t n = MIN(count - done, batch);
+        ESP_RETURN_ON_FALSE(avi_read_at(p, p->idx1_pos + done * AVI_IDX1_ENTRY_SIZE, p->buff, n * AVI_IDX1_ENTRY_SIZE), ESP_ERR_INVALID_SIZE, TAG, "Read idx1 failed");
+        for (uint32_t j = 0; j < n; j++) {
+            const uint8_t *entry = p->buff + j * AVI_IDX1_ENTRY_SIZE;
+            const uint32_t ckid = avi_u32(entry);
+            if (!avi_is_video_chunk(p, ckid)) {
+                continue;
+            }
+            const uint32_t offset = avi_u32(entry + 8);
+            if (base < 0) {
+                /* Chunk header of the first frame is checked at the relative offset */
+                uint8_t header[4];
+                base = (avi_read_at(p, (uint64_t)p->movi_pos + offset, header, sizeof(header)) && avi_u32(header) == ckid ? p->movi_pos : 0);
+            }
+            ESP_RETURN_ON_ERROR(avi_add_frame(p, index, info, base + offset + 8, avi_u32(entry + 12)), TAG, "Add frame failed");
+        }
+        done += n;
+    }
+    return ESP_OK;
+}
+
+/* File without index (e.g. interrupted recording), chunk headers of the movi list are read */
+static esp_err_t avi_index_movi(avi_parser_t *p, frame_index_t *index, avi_demux_info_t *info)
+{
+    uint8_t header[12];
+    uint64_t pos = p->movi_pos + 4;
+
+    while (pos + 8 <= p->movi_end && avi_read_at(p, pos, header, 8)) {
+        const uint32_t id = avi_u32(header);
+        const uint32_t size = avi_u32(header + 4);
+        if (id == FOURCC('L', 'I', 'S', 'T')) {
+            /* 'rec ' groups, their chunks are walked */
+            pos += 12;
+            continue;
+        }
+        if (avi_is_video_chunk(p, id)) {
+            ESP_RETURN_ON_ERROR(avi_add_frame(p, index, info, pos + 8, size), TAG, "Add frame failed");
+        }
+        pos += 8 + ALIGN_UP((uint64_t)size, 2);
+    }
+    return ESP_OK;
+}
+
+bool avi_demux_probe(const uint8_t *data, size_t len)
+{
+    return (len >= 12 && avi_u32(data) == FOURCC('R', 'I', 'F', 'F') && avi_u32(data + 8) == FOURCC('A', 'V', 'I', ' '));
+}
+
+esp_err_t avi_demux_open(media_src_t *src, uint8_t *buff, uint32_t buff_size, avi_demux_info_t *info, frame_index_t *index)
+{
+    uint8_t header[12];
+    avi_parser_t p = {
+        .src = src,
+        .buff = buff,
+        .buff_size = buff_size,
+        .stream = -1,
+    };
+
+    memset(info, 0, sizeof(avi_demux_info_t));
+    frame_index_clear(index);
+    ESP_RETURN_ON_FALSE(media_src_storage_get_size(src, &p.file_size) == 0, ESP_ERR_INVALID_SIZE, TAG, "Get file size failed");
+    ESP_RETURN_ON_FALSE(avi_read_at(&p, 0, header, sizeof(header)) && avi_demux_probe(header, sizeof(header)), ESP_ERR_NOT_SUPPORTED, TAG, "Not AVI file");
+
+    /* Size in RIFF header is zero or wrong in interrupted recordings */
+    uint64_t riff_end = 8 + (uint64_t)avi_u32(header + 4);
+    if (riff_end <= 12 || riff_end > p.file_size) {
+        riff_end = p.file_size;
+    }
+
+    /* Top level chunks: hdrl, movi and idx1 */
+    for (uint64_t pos = 12; pos + 12 <= riff_end; ) {
+        ESP_RETURN_ON_FALSE(avi_read_at(&p, pos, header, sizeof(header)), ESP_ERR_INVALID_SIZE, TAG, "Read chunk failed");
+        const uint32_t id = avi_u32(header);
+        const uint32_t size = avi_u32(header + 4);
+        const uint32_t type = avi_u32(header + 8);
+
+        if (id == FOURCC('L', 'I', 'S', 'T') && type == FOURCC('h', 'd', 'r', 'l')) {
+            ESP_RETURN_ON_FALSE(size >= 4 && size - 4 <= buff_size, ESP_ERR_INVALID_SIZE, TAG, "AVI headers do not fit into buffer");
+            ESP_RETURN_ON_FALSE(avi_read_at(&p, pos + 12, buff, size - 4), ESP_ERR_INVALID_SIZE, TAG, "Read headers failed");
+            ESP_RETURN_ON_ERROR(avi_parse_hdrl(&p, buff, size - 4, pos + 12, info), TAG, "Parse headers failed");
+        } else if (id == FOURCC('L', 'I', 'S', 'T') && type == FOURCC('m', 'o', 'v', 'i')) {
+            p.movi_pos = pos + 8;
+            if (size <= 4 || pos + 8 + size > riff_end) {
+                /* Interrupted recording, movi list is not closed and there is no index behind it */
+                p.movi_end = riff_end;
+                break;
+            }
+            p.movi_end = pos + 8 + size;
+        } else if (id == FOURCC('i', 'd', 'x', '1')) {
+            p.idx1_pos = pos + 8;
+            p.idx1_size = MIN(size, riff_end - pos - 8);
+        }
+        pos += 8 + ALIGN_UP((uint64_t)size, 2);
+    }
+    ESP_RETURN_ON_FALSE(p.stream >= 0, ESP_ERR_INVALID_VERSION, TAG, "No video stream");
+    ESP_RETURN_ON_FALSE(p.movi_pos, ESP_ERR_INVALID_SIZE, TAG, "No movi list");
+
+    /* Index is allocated at once, when the number of frames is known */
+    if (p.frames) {
+        frame_index_reserve(index, p.frames);
+    }
+    if (p.indx_count) {
+        ESP_RETURN_ON_ERROR(avi_index_indx(&p, index, info), TAG, "OpenDML index failed");
+    } else if (p.idx1_pos) {
+        ESP_RETURN_ON_ERROR(avi_index_idx1(&p, index, info), TAG, "idx1 index failed");
+    } else {
+        ESP_LOGW(TAG, "AVI file without index, reading chunk headers");
+        ESP_RETURN_ON_ERROR(avi_index_movi(&p, index, info), TAG, "Reading movi list failed");
+    }
+    ESP_RETURN_ON_FALSE(index->count > 0, ESP_ERR_INVALID_SIZE, TAG, "No frames in AVI file");
+    index->complete = true;
+
+    ESP_LOGI(TAG, "AVI video %ld x %ld, %ld fps, %ld frames, max frame %ld bytes", info->width, info->height, info->fps, index->count, info->max_frame_size);
+    return ESP_OK;
+}
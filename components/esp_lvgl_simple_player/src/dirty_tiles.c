@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "dirty_tiles.h"
+
+#define TILE_WORDS  (DIRTY_TILE_SIZE * 2 / 4)   /* 32-bit words in one tile line of RGB565 */
+
+/* Rotation keeps all bits of the word (shift would drop the top bits of the odd pixels) */
+#define ROTL32(w, k)    (((w) << (k)) | ((w) >> (32 - (k))))
+
+esp_err_t dirty_tiles_init(dirty_tiles_t *tiles, uint32_t width, uint32_t height)
+{
+    uint32_t cols = (width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+    uint32_t rows = (height + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+
+    if (tiles->signatures == NULL || cols * rows > tiles->capacity) {
+        if (tiles->fixed) {
+            return ESP_ERR_NO_MEM;
+        }
+        free(tiles->signatures);
+        tiles->signatures = malloc(cols * rows * sizeof(uint32_t));
+        if (tiles->signatures == NULL) {
+            tiles->cols = tiles->rows = tiles->capacity = 0;
+            return ESP_ERR_NO_MEM;
+        }
+        tiles->capacity = cols * rows;
+    }
+    tiles->width = width;
+    tiles->height = height;
+    tiles->cols = cols;
+    tiles->rows = rows;
+    tiles->valid = false;
+    return ESP_OK;
+}
+
+void dirty_tiles_reset(dirty_tiles_t *tiles)
+{
+    tiles->valid = false;
+}
+
+void dirty_tiles_init_static(dirty_tiles_t *tiles, uint32_t *signatures, uint32_t capacity)
+{
+    memset(tiles, 0, sizeof(dirty_tiles_t));
+    tiles->signatures = signatures;
+    tiles->capacity = capacity;
+    tiles->fixed = true;
+}
+
+void dirty_tiles_deinit(dirty_tiles_t *tiles)
+{
+    if (tiles->fixed) {
+        tiles->valid = false;
+        return;
+    }
+    free(tiles->signatures);
+    memset(tiles, 0, sizeof(dirty_tiles_t));
+}
+
+/* Signatures of one row of tiles, lines are processed word by word for all tiles in the row */
+static void dirty_tiles_hash_row(const dirty_tiles_t *tiles, const uint8_t *frame, uint32_t stride, uint32_t lines, uint32_t *sig)
+{
+    const uint32_t full_cols = tiles->width / DIRTY_TILE_SIZE;
+
+    for (uint32_t c = 0; c < tiles->cols; c++) {
+        sig[c] = 2166136261u;
+    }
+    for (uint32_t y = 0; y < lines; y++) {
+        const uint32_t *line = (const uint32_t *)(frame + y * stride);
+        for (uint32_t c = 0; c < full_cols; c++) {
+            const uint32_t *w = line + c * TILE_WORDS;
+            /* Two independent lanes, so the loop is not limited by multiply latency */
+            uint32_t a = w[0] ^ ROTL32(w[1], 7) ^ ROTL32(w[2], 13) ^ ROTL32(w[3], 19);
+            uint32_t b = w[4] ^ ROTL32(w[5], 5) ^ ROTL32(w[6], 11) ^ ROTL32(w[7], 17);
+            sig[c] = (sig[c] ^ a) * 16777619u + b;
+        }
+        if (full_cols < tiles->cols) {
+            /* Last partial tile */
+            const uint16_t *px = (const uint16_t *)line + full_cols * DIRTY_TILE_SIZE;
+            uint32_t h = sig[full_cols];
+            for (uint32_t x = full_cols * DIRTY_TILE_SIZE; x < tiles->width; x++) {
+                h = (h ^ *px++) * 16777619u;
+            }
+            sig[full_cols] = h;
+        }
+    }
+}
+
+/* Add changed area, extends area from the previous tile row when it has the same columns */
+static int dirty_tiles_add(dirty_area_t *areas, int count, int row_start, const dirty_area_t *area)
+{
+    for (int i = row_start - 1; i >= 0; i--) {
+        if (areas[i].x1 == area->x1 && areas[i].x2 == area->x2 && areas[i].y2 + 1 == area->y1) {
+            areas[i].y2 = area->y2;
+            return count;
+        }
+    }
+    if (count < DIRTY_AREAS_MAX) {
+        areas[count++] = *area;
+        return count;
+    }
+    /* Too many areas, merge into the last one */
+    dirty_area_t *last = &areas[DIRTY_AREAS_MAX - 1];
+    last->x1 = MIN(last->x1, area->x1);
+    last->y1 = MIN(last->y1, area->y1);
+    last->x2 = MAX(last->x2, area->x2);
+    last->y2 = MAX(last->y2, area->y2);
+    return count;
+}
+
+int dirty_tiles_update(dirty_tiles_t *tiles, const uint8_t *frame, uint32_t stride, dirty_area_t *areas)
+{
+    uint32_t sig[tiles->cols];
+    int count = 0;
+
+    for (uint32_t r = 0; r < tiles->rows; r++) {
+        const uint32_t y1 = r * DIRTY_TILE_SIZE;
+        const uint32_t lines = MIN(DIRTY_TILE_SIZE, tiles->height - y1);
+        uint32_t *prev = &tiles->signatures[r * tiles->cols];
+        int row_start = count;
+
+        dirty_tiles_hash_row(tiles, frame + y1 * stride, stride, lines, sig);
+
+        /* Runs of changed tiles */
+        uint32_t c = 0;
+        while (c < tiles->cols) {
+            if (tiles->valid && sig[c] == prev[c]) {
+                c++;
+                continue;
+            }
+            uint32_t run = c;
+            while (c < tiles->cols && (!tiles->valid || sig[c] != prev[c])) {
+                c++;
+            }
+            dirty_area_t area = {
+                .x1 = run * DIRTY_TILE_SIZE,
+                .y1 = y1,
+                .x2 = MIN(c * DIRTY_TILE_SIZE, tiles->width) - 1,
+                .y2 = y1 + lines - 1,
+            };
+            count = dirty_tiles_add(areas, count, row_start, &area);
+        }
+        memcpy(prev, sig, tiles->cols * sizeof(uint32_t));
+    }
+    tiles->valid = true;
+
+    return MIN(count, DIRTY_AREAS_MAX);
+}
@@ -4,47 +4,254 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdio.h>
 #include <string.h>
+#include <sys/param.h>
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_random.h"
 #include "driver/jpeg_decode.h"
 #include "esp_lvgl_port.h"
 #include "media_src_storage.h"
+#include "jpeg_dec_service.h"
+#include "mjpeg_parser.h"
+#include "frame_index.h"
+#include "avi_demux.h"
+#include "slv_demux.h"
+#include "dirty_tiles.h"
+#include "overlay_layer.h"
+#include "frame_mailbox.h"
+#include "frame_cache.h"
+#include "frame_skip.h"
+#include "frame_hash.h"
+#include "player_arena.h"
+#include "player_mem.h"
+#include "jpeg_roi.h"
+#include "subtitle_srt.h"
+#include "player_stats.h"
+#include "player_trace.h"
 #include "esp_lvgl_simple_player.h"
 
 #define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
 
+#define PLAYER_PRESENT_PERIOD_MS    (5)     /* Polling period of decoded frames in LVGL task */
+#define PLAYER_STATS_PERIOD_MS      (500)   /* Refresh period of statistics overlay */
+#define PLAYER_CAPTION_PERIOD_MS    (100)   /* Period of look-ahead rasterization of captions */
+#define PLAYER_CAPTIONS             (2)     /* Rasterized captions (the active and the next cue) */
+#define PLAYER_CAPTION_PAD          (4)     /* Padding of the caption box */
+#define PLAYER_CAPTION_LINES        (3)     /* Lines of captions reserved in the arena */
+#define PLAYER_PREVIEW_SIZE         (128)   /* Longer side of scrub preview */
+#define PLAYER_PREVIEW_GAP          (8)     /* Space between scrub preview and slider */
+
+#define PLAYER_ARENA_FRAMES         (9000)  /* Default index capacity of the arena (5 minutes at 30 fps) */
+
+/* Steady state with arena does not use heap (no fragmentation in long run), allocation there is a bug */
+#define PLAYER_HEAP_CHECK()         assert(!player_ctx.arena_sealed)
+
 static const char *TAG = "PLAYER";
-static const uint16_t EOI = 0xd9ff; /* End of image */
+
+/* Image layer blended to decoded frames */
+typedef struct
+{
+    overlay_layer_t     layer;
+    bool                used;
+    bool                visible;
+    lv_align_t          align;
+    int32_t             x_ofs;
+    int32_t             y_ofs;
+} player_overlay_t;
+
+/* Rasterized caption of the subtitle cue */
+typedef struct
+{
+    player_overlay_t    overlay;        /* Layer is not used, when rasterization failed */
+    int                 cue;            /* Index of the cue (-1 = empty) */
+} player_caption_t;
+
+/* Next file of the playlist, opened and decoded in background */
+typedef struct
+{
+    char                *file_path;
+    media_src_t         file;
+    uint64_t            filesize;
+    uint32_t            width;
+    uint32_t            height;
+    int                 frame_size;     /* Size of the first (decoded) frame */
+    uint32_t            playlist_index;
+    bool                container;      /* Frames are in the container index */
+    uint32_t            align;          /* Frames of the container can be read up to multiple of align */
+    uint32_t            fps;            /* Frame rate from the container (0 = unknown) */
+    uint32_t            out_size;       /* Size of decoded frame */
+    frame_index_t       index;
+    
+    uint8_t             *in_buff;
+    uint32_t            in_buff_size;
+    uint8_t             *out_buff;
+    uint32_t            out_buff_size;
+    
+    TaskHandle_t        task;           /* Preroll task and its decoder client are kept between files */
+    jpeg_dec_client_handle_t jpeg;
+    bool                exit;
+    bool                started;
+    esp_err_t           result;
+    SemaphoreHandle_t   done;
+} player_preroll_t;
+
+/* Decoded frame handed over from video task to LVGL task */
+typedef struct
+{
+    uint8_t             *buff;
+    uint32_t            buff_size;
+    uint8_t             *data;          /* Decoded data, own buffer or frame of the cache */
+    uint32_t            offset;         /* Shown area (viewport) in data */
+    uint32_t            width;
+    uint32_t            height;
+    uint32_t            stride;
+    uint32_t            seq;            /* Sequence number of published frame */
+    uint32_t            progress;       /* Slider value (per mille) */
+    int64_t             publish_time;   /* Time of handing over to LVGL task (us) */
+    int                 areas_count;    /* Changed areas against the previous frame (-1 = whole frame) */
+    dirty_area_t        areas[DIRTY_AREAS_MAX];
+    const char          *file;          /* Span of the original JPEG for snapshot (NULL = no frame) */
+    uint32_t            number;
+    uint32_t            jpeg_offset;
+    uint32_t            jpeg_size;
+} player_frame_t;
 
 typedef struct
 {
-    char                    *file_path;
+    char                    *file_path;     /* Playing file */
+    char                    *single_file;   /* File to play without playlist */
     media_src_t             file;
     uint64_t                filesize;
-    jpeg_decoder_handle_t   jpeg;
+    jpeg_dec_client_handle_t jpeg;
+    uint8_t                 decode_priority;
     
     uint32_t    screen_width;   /* Width of the video player object */    
     uint32_t    screen_height;  /* Height of the video player object */
-    uint32_t    video_width;      /* Maximum width of the video */
+    uint32_t    video_width;      /* Width of the video, lines of decoded frames are longer (video_stride()) */
     uint32_t    video_height;     /* Maximum height of the video  */
+    uint32_t    fps;              /* Frames per second (0 = unknown) */
+    uint32_t    cfg_fps;          /* Frames per second from configuration (0 = from the file) */
     
+    TaskHandle_t    task;           /* Video task is kept between plays */
+    SemaphoreHandle_t task_lock;    /* Task handle is valid while locked, so exited task is never notified */
+    bool            play_request;
+    bool            release_request;
+    uint32_t        release_free_mem;   /* Release resources on stop below this free memory (0 = keep) */
+    int64_t         play_time;          /* Time of play request (us) */
+    uint32_t        first_frame_time;   /* Time to first frame (us) */
     player_state_t  state;
+    int             speed;          /* Trick-play speed (1 = normal, negative = rewind) */
+    int64_t         present_time;   /* Time of the next frame presentation (us) */
     bool            loop;
     bool            hide_controls;
     bool            hide_slider;
     bool            hide_status;
     bool            auto_width;
     bool            auto_height;
+    bool            seek_enabled;
+    bool            scrub_preview;  /* Thumbnail over the dragged slider, seek on release */
+    bool            dirty_regions;  /* Invalidate only changed tiles of the video */
+    bool            adaptive_skip;  /* Skip decoding of frames when decoding is slower than frame rate */
+    frame_skip_t    skip;
+    uint32_t        skip_run;       /* Frames since the last decoded frame */
+    bool            skip_repeated;  /* Encoded frame identical to the shown one is not decoded and drawn again */
+    bool            repeat_valid;   /* Fingerprint of the shown frame is known */
+    uint64_t        repeat_hash;    /* Fingerprint of encoded shown frame */
+    uint32_t        repeat_size;
+    int             repeat_cue;     /* Subtitle cue of the shown frame */
+    dirty_tiles_t   tiles;          /* Tile signatures of the previous frame */
+    
+    /* Position in the video */
+    uint64_t        position;       /* Offset of the next frame */
+    uint32_t        frame;          /* Number of the next frame */
+    bool            frame_exact;    /* Frame number is known exactly (not estimated after seek) */
+    frame_index_t   index;          /* Known frame offsets */
+    bool            container;      /* Exact frame spans are in the index from the container (no marker search) */
+    uint32_t        container_align;/* Frames of the container can be read up to multiple of align */
+    
+    /* Seek request, only the latest one is processed */
+    portMUX_TYPE    seek_lock;
+    bool            seek_pending;
+    player_seek_t   seek_mode;
+    uint32_t        seek_value;
     
     /* Buffers */
     uint8_t     *in_buff;
     uint32_t    in_buff_size;
-    uint8_t     *out_buff;
-    uint32_t    out_buff_size;
+    
+    /* Decoded frames, video task decodes to back frame, LVGL timer shows the latest published one */
+    player_frame_t  frames[FRAME_MAILBOX_SLOTS];
+    frame_mailbox_t mailbox;
+    uint32_t        frame_seq;      /* Sequence number of the last published frame */
+    uint32_t        shown_seq;      /* Sequence number of the frame on canvas */
+    lv_timer_t      *present_timer;
+    lv_draw_buf_t   canvas_buf;     /* Draw buffer of the canvas with line pitch of the decoder, frames change only its data */
+    
+    /* Decoded frames of short videos, they are presented without reading and decoding */
+    uint32_t        cache_budget;       /* Memory for cached frames (0 = disabled) */
+    uint32_t        cache_frame_size;   /* Size of decoded frame of the current video */
+    frame_cache_t   cache;
+    volatile bool   cache_flush;        /* Overlays changed, cached frames must be decoded again */
+    
+    /* Viewport for pan and zoom, only restart intervals of JPEG covering it are decoded */
+    portMUX_TYPE    viewport_lock;
+    bool            viewport_pending;
+    jpeg_roi_rect_t viewport_request;
+    jpeg_roi_rect_t viewport;           /* Shown area of the video (width 0 = whole video) */
+    uint32_t        decoded_frame;      /* Number of the last decoded frame, it is decoded again on viewport change */
+    
+    /* Performance statistics */
+    player_stats_t  stats;
+    lv_timer_t      *stats_timer;
+    uint32_t        stats_displayed;    /* Displayed frames in the last overlay refresh */
+    int64_t         stats_time;         /* Time of the last overlay refresh */
+    
+    /* Overlays, blended in video task */
+    player_overlay_t    overlays[PLAYER_OVERLAYS_MAX];
+    SemaphoreHandle_t   overlay_lock;
+    
+    /* Subtitles, track is changed under LVGL and overlay lock, captions are rasterized in LVGL task */
+    subtitle_track_t    subtitles;
+    esp_lvgl_simple_player_subtitles_cfg_t subtitles_cfg;
+    player_caption_t    captions[PLAYER_CAPTIONS];
+    lv_timer_t          *caption_timer;
+    lv_obj_t            *caption_canvas;
+    lv_draw_buf_t       *caption_buf;
+    /* Captions reserved in the arena: rasterization buffer followed by layers of the captions */
+    uint8_t             *caption_mem;
+    uint32_t            caption_width;      /* The biggest caption (0 = captions are allocated when rasterized) */
+    uint32_t            caption_height;
+    lv_draw_buf_t       caption_draw_buf;
+    
+    /* Memory of storage caches, encoded and decoded frames */
+    esp_lvgl_simple_player_mem_cfg_t placement[PLAYER_MEM_CLASS_MAX];
+    portMUX_TYPE    mem_lock;
+    esp_lvgl_simple_player_mem_report_t mem_report;     /* Updated by video task, when buffers change */
+    
+    /* Memory reserved on create, buffers, indexes and storage are never allocated from heap then */
+    player_arena_t  arena;
+    uint32_t        arena_width;        /* Biggest video (0 = no arena) */
+    uint32_t        arena_height;
+    uint32_t        arena_frames;       /* Capacity of frame indexes */
+    uint8_t         *arena_cache;       /* Memory of the frame cache */
+    bool            arena_sealed;       /* First play prepared everything, heap must not be used */
+    void            *snapshot_storage;  /* Storage memory of snapshot reads */
+    bool            snapshot_busy;      /* Snapshot storage is used (under seek_lock) */
+    
+    /* Playlist */
+    char        **playlist;
+    uint32_t    playlist_count;
+    uint32_t    playlist_current;
+    bool        playlist_loop;
+    bool        playlist_shuffle;
+    player_preroll_t preroll;
     
     /* LVGL objects */
     lv_obj_t    *main;
@@ -56,10 +263,18 @@ typedef struct
     lv_obj_t    *btn_repeat;
     lv_obj_t    *img_pause;
     lv_obj_t    *img_stop;
+    lv_obj_t    *label_stats;
     lv_obj_t    *controls;
+    lv_obj_t    *preview;       /* Scrub preview, thumbnail is generated in background */
+    uint8_t     *preview_buff;
 } player_ctx_t;
 
-static player_ctx_t player_ctx;
+static player_ctx_t player_ctx = {
+    .seek_lock = portMUX_INITIALIZER_UNLOCKED,
+    .viewport_lock = portMUX_INITIALIZER_UNLOCKED,
+    .mem_lock = portMUX_INITIALIZER_UNLOCKED,
+    .stats.lock = portMUX_INITIALIZER_UNLOCKED,
+};
 
     
 static const jpeg_decode_cfg_t jpeg_decode_cfg = {
@@ -110,6 +325,356 @@ static void repeat_event_cb(lv_event_t *e)
     }
 }
 
+/* Called from LVGL task, when thumbnail of the dragged position is in preview buffer */
+static void preview_ready_cb(esp_err_t result, const esp_lvgl_simple_player_thumb_cfg_t *cfg, void *user_ctx)
+{
+    if (result == ESP_OK && lv_slider_is_dragged(player_ctx.slider)) {
+        lv_obj_remove_flag(player_ctx.preview, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_invalidate(player_ctx.preview);
+    }
+}
+
+/* Move preview over the knob and request thumbnail of the position */
+static void preview_request(int32_t value)
+{
+    uint32_t width = PLAYER_PREVIEW_SIZE;
+    uint32_t height = PLAYER_PREVIEW_SIZE;
+
+    if (player_ctx.video_width == 0 || player_ctx.video_height == 0 || player_ctx.file_path == NULL) {
+        return;
+    }
+    if (player_ctx.video_width >= player_ctx.video_height) {
+        height = MAX(1, PLAYER_PREVIEW_SIZE * player_ctx.video_height / player_ctx.video_width);
+    } else {
+        width = MAX(1, PLAYER_PREVIEW_SIZE * player_ctx.video_width / player_ctx.video_height);
+    }
+    if (lv_obj_get_width(player_ctx.preview) != (int32_t)width || lv_obj_get_height(player_ctx.preview) != (int32_t)height) {
+        lv_canvas_set_buffer(player_ctx.preview, player_ctx.preview_buff, width, height, LV_COLOR_FORMAT_RGB565);
+        lv_obj_add_flag(player_ctx.preview, LV_OBJ_FLAG_HIDDEN);
+    }
+    
+    const int32_t slider_width = lv_obj_get_width(player_ctx.slider);
+    int32_t x = (value * slider_width) / 1000 - (int32_t)width / 2;
+    x = MAX(0, MIN(x, slider_width - (int32_t)width));
+    lv_obj_align_to(player_ctx.preview, player_ctx.slider, LV_ALIGN_OUT_TOP_LEFT, x, -PLAYER_PREVIEW_GAP);
+    
+    const esp_lvgl_simple_player_thumb_cfg_t cfg = {
+        .file = player_ctx.file_path,
+        .position = value,
+        .buff_size = player_ctx.in_buff_size,
+        .width = width,
+        .height = height,
+        .buff = player_ctx.preview_buff,
+    };
+    esp_lvgl_simple_player_get_thumbnail_async(&cfg, preview_ready_cb, NULL);
+}
+
+static void slider_event_cb(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t *obj = lv_event_get_target(e);
+
+    /* Dragging shows thumbnails only, video seeks to the released position */
+    if (player_ctx.preview) {
+        if (code == LV_EVENT_VALUE_CHANGED && lv_slider_is_dragged(obj)) {
+            preview_request(lv_slider_get_value(obj));
+        } else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
+            lv_obj_add_flag(player_ctx.preview, LV_OBJ_FLAG_HIDDEN);
+            esp_lvgl_simple_player_seek(PLAYER_SEEK_PERMILLE, lv_slider_get_value(obj));
+        }
+        return;
+    }
+
+    /* Value is changed by user only, the player sets value without event */
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        esp_lvgl_simple_player_seek(PLAYER_SEEK_PERMILLE, lv_slider_get_value(obj));
+    }
+}
+
+/* Refresh video canvas, count < 0 refreshes the whole canvas */
+static void video_invalidate(const dirty_area_t *areas, int count)
+{
+    if (count < 0) {
+        lv_obj_invalidate(player_ctx.canvas);
+        return;
+    }
+    
+    /* Tiles are relative to the canvas */
+    lv_area_t coords;
+    lv_obj_get_coords(player_ctx.canvas, &coords);
+    for (int i = 0; i < count; i++) {
+        lv_area_t area = {
+            .x1 = coords.x1 + areas[i].x1,
+            .y1 = coords.y1 + areas[i].y1,
+            .x2 = coords.x1 + areas[i].x2,
+            .y2 = coords.y1 + areas[i].y2,
+        };
+        lv_obj_invalidate_area(player_ctx.canvas, &area);
+    }
+}
+
+/* Line pitch of decoded RGB565 frame, decoder aligns lines of the output to 16 pixels */
+static uint32_t video_stride(uint32_t width)
+{
+    return ALIGN_UP(width, 16) * 2;
+}
+
+/* Set draw buffer of the canvas, only the width is drawn from each line of the decoder output (LVGL must be locked) */
+static void video_canvas_init(uint8_t *data, uint32_t width, uint32_t height, uint32_t stride)
+{
+    lv_draw_buf_init(&player_ctx.canvas_buf, width, height, LV_COLOR_FORMAT_RGB565, stride, data, stride * height);
+    lv_canvas_set_draw_buf(player_ctx.canvas, &player_ctx.canvas_buf);
+}
+
+/* Point the canvas to the shown area of the frame, returns true when the canvas was resized (LVGL must be locked) */
+static bool video_canvas_set(const player_frame_t *frame)
+{
+    lv_draw_buf_t *draw_buf = lv_canvas_get_draw_buf(player_ctx.canvas);
+    bool resized = (draw_buf->header.w != frame->width || draw_buf->header.h != frame->height || draw_buf->header.stride != frame->stride);
+    
+    if (resized) {
+        /* Video or viewport changed, decoded area is wider than shown one */
+        video_canvas_init(frame->data + frame->offset, frame->width, frame->height, frame->stride);
+        draw_buf = lv_canvas_get_draw_buf(player_ctx.canvas);
+    }
+    draw_buf->data = frame->data + frame->offset;
+    draw_buf->unaligned_data = draw_buf->data;
+    lv_image_cache_drop(draw_buf);
+    return resized;
+}
+
+/* Show the latest decoded frame, runs in LVGL task */
+static void present_timer_cb(lv_timer_t *timer)
+{
+    if (!frame_mailbox_take(&player_ctx.mailbox)) {
+        return;
+    }
+    player_frame_t *frame = &player_ctx.frames[frame_mailbox_front(&player_ctx.mailbox)];
+    PLAYER_TRACE_BEGIN("present");
+    int64_t start = esp_timer_get_time();
+    player_stats_add(&player_ctx.stats, PLAYER_STAT_HANDOFF, start - frame->publish_time);
+    player_ctx.stats.displayed++;
+    if (frame->seq > player_ctx.shown_seq + 1) {
+        player_ctx.stats.dropped += frame->seq - player_ctx.shown_seq - 1;
+    }
+    
+    /* Frames have the same size, so only data of the canvas buffer is changed (without refreshing whole image) */
+    bool resized = video_canvas_set(frame);
+    
+    /* Changed areas are valid only against the previous frame, skipped frame refreshes the whole canvas */
+    video_invalidate(frame->areas, (frame->seq == player_ctx.shown_seq + 1 && !resized ? frame->areas_count : -1));
+    player_ctx.shown_seq = frame->seq;
+    
+    /* Set slider, when user does not drag it */
+    if (!lv_slider_is_dragged(player_ctx.slider)) {
+        lv_slider_set_value(player_ctx.slider, frame->progress, LV_ANIM_ON);
+    }
+    player_stats_add(&player_ctx.stats, PLAYER_STAT_PRESENT, esp_timer_get_time() - start);
+    PLAYER_TRACE_END("present");
+}
+
+/* Print average and 95th percentile in ms */
+static int stats_print_time(char *buf, size_t size, const char *name, const player_stat_value_t *value)
+{
+    return snprintf(buf, size, "%s %lu.%lu/%lu.%lu ms\n", name,
+                    (unsigned long)(value->avg / 1000), (unsigned long)((value->avg % 1000) / 100),
+                    (unsigned long)(value->p95 / 1000), (unsigned long)((value->p95 % 1000) / 100));
+}
+
+/* Refresh statistics overlay, runs in LVGL task */
+static void stats_timer_cb(lv_timer_t *timer)
+{
+    esp_lvgl_simple_player_stats_t stats;
+    char text[256];
+    int len = 0;
+    
+    player_stats_get(&player_ctx.stats, &stats);
+    
+    /* Displayed frame rate since the last refresh */
+    int64_t now = esp_timer_get_time();
+    uint32_t fps10 = 0;
+    if (player_ctx.stats_time && now > player_ctx.stats_time && stats.frames_displayed >= player_ctx.stats_displayed) {
+        fps10 = ((uint64_t)(stats.frames_displayed - player_ctx.stats_displayed) * 10000000) / (now - player_ctx.stats_time);
+    }
+    player_ctx.stats_time = now;
+    player_ctx.stats_displayed = stats.frames_displayed;
+    
+    len += snprintf(text + len, sizeof(text) - len, "%lu.%lu fps, dropped %lu, cached %lu, step %lu\n", (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10),
+                    (unsigned long)stats.frames_dropped, (unsigned long)stats.frames_cached, (unsigned long)stats.decode_step);
+    len += stats_print_time(text + len, sizeof(text) - len, "read", &stats.stage[PLAYER_STAT_READ]);
+    len += stats_print_time(text + len, sizeof(text) - len, "parse", &stats.stage[PLAYER_STAT_PARSE]);
+    len += stats_print_time(text + len, sizeof(text) - len, "decode", &stats.stage[PLAYER_STAT_DECODE]);
+    len += stats_print_time(text + len, sizeof(text) - len, "wait", &stats.stage[PLAYER_STAT_WAIT]);
+    len += stats_print_time(text + len, sizeof(text) - len, "handoff", &stats.stage[PLAYER_STAT_HANDOFF]);
+    snprintf(text + len, sizeof(text) - len, "frame %lu kB", (unsigned long)(stats.stage[PLAYER_STAT_FRAME_SIZE].avg / 1024));
+    lv_label_set_text(player_ctx.label_stats, text);
+}
+
+/* Time of the frame for subtitles (ms) */
+static uint32_t caption_time(uint32_t frame)
+{
+    return (uint32_t)(((uint64_t)frame * 1000) / player_ctx.fps);
+}
+
+/* Caption of the cue, if it is rasterized */
+static player_caption_t *caption_find(int cue)
+{
+    for (int i = 0; i < PLAYER_CAPTIONS && cue >= 0; i++) {
+        if (player_ctx.captions[i].cue == cue) {
+            return &player_ctx.captions[i];
+        }
+    }
+    return NULL;
+}
+
+/* Size of the rasterization buffer of captions in the arena */
+static uint32_t caption_buf_size(void)
+{
+    return ALIGN_UP(lv_draw_buf_width_to_stride(player_ctx.caption_width, LV_COLOR_FORMAT_ARGB8888) * player_ctx.caption_height, PLAYER_ARENA_ALIGN);
+}
+
+/* Size of memory of one caption layer in the arena */
+static uint32_t caption_layer_size(void)
+{
+    return ALIGN_UP(overlay_layer_mem_size(player_ctx.caption_width, player_ctx.caption_height), PLAYER_ARENA_ALIGN);
+}
+
+/* Rasterize text into ARGB8888 buffer and pre-composite it into layer of the caption slot, LVGL lock must be held */
+static esp_err_t caption_render(const char *text, int slot, overlay_layer_t *layer)
+{
+    const esp_lvgl_simple_player_subtitles_cfg_t *cfg = &player_ctx.subtitles_cfg;
+    const lv_font_t *font = (cfg->font ? cfg->font : LV_FONT_DEFAULT);
+    const uint32_t video_width = (player_ctx.video_width ? player_ctx.video_width : player_ctx.screen_width);
+    uint32_t max_width = (cfg->max_width ? cfg->max_width : video_width * 9 / 10);
+    lv_point_t size;
+    
+    if (player_ctx.caption_mem) {
+        max_width = MIN(max_width, player_ctx.caption_width);
+    }
+    lv_text_get_size(&size, text, font, 0, 0, MAX(max_width, 3 * PLAYER_CAPTION_PAD) - 2 * PLAYER_CAPTION_PAD, LV_TEXT_FLAG_NONE);
+    const int32_t width = size.x + 2 * PLAYER_CAPTION_PAD;
+    int32_t height = size.y + 2 * PLAYER_CAPTION_PAD;
+    lv_draw_buf_t *buf;
+    if (player_ctx.caption_mem) {
+        /* Memory of the arena, lines which do not fit are cut */
+        height = MIN(height, player_ctx.caption_height);
+        buf = &player_ctx.caption_draw_buf;
+        lv_draw_buf_init(buf, width, height, LV_COLOR_FORMAT_ARGB8888, lv_draw_buf_width_to_stride(width, LV_COLOR_FORMAT_ARGB8888),
+                         player_ctx.caption_mem, caption_buf_size());
+        lv_draw_buf_clear(buf, NULL);
+        lv_canvas_set_draw_buf(player_ctx.caption_canvas, buf);
+    } else {
+        PLAYER_HEAP_CHECK();
+        buf = lv_draw_buf_create(width, height, LV_COLOR_FORMAT_ARGB8888, 0);
+        ESP_RETURN_ON_FALSE(buf, ESP_ERR_NO_MEM, TAG, "Allocation of caption failed");
+        lv_draw_buf_clear(buf, NULL);
+        
+        /* Previous buffer is freed only after the canvas has the new one */
+        lv_canvas_set_draw_buf(player_ctx.caption_canvas, buf);
+        if (player_ctx.caption_buf) {
+            lv_draw_buf_destroy(player_ctx.caption_buf);
+        }
+        player_ctx.caption_buf = buf;
+    }
+    
+    lv_layer_t canvas_layer;
+    lv_canvas_init_layer(player_ctx.caption_canvas, &canvas_layer);
+    if (cfg->bg_opa > LV_OPA_TRANSP) {
+        lv_draw_rect_dsc_t rect;
+        lv_draw_rect_dsc_init(&rect);
+        rect.bg_color = cfg->bg_color;
+        rect.bg_opa = cfg->bg_opa;
+        rect.radius = PLAYER_CAPTION_PAD;
+        const lv_area_t area = {0, 0, width - 1, height - 1};
+        lv_draw_rect(&canvas_layer, &rect, &area);
+    }
+    lv_draw_label_dsc_t label;
+    lv_draw_label_dsc_init(&label);
+    label.color = cfg->color;
+    label.font = font;
+    label.text = text;
+    label.align = LV_TEXT_ALIGN_CENTER;
+    const lv_area_t area = {PLAYER_CAPTION_PAD, PLAYER_CAPTION_PAD, width - PLAYER_CAPTION_PAD - 1, height - PLAYER_CAPTION_PAD - 1};
+    lv_draw_label(&canvas_layer, &label, &area);
+    lv_canvas_finish_layer(player_ctx.caption_canvas, &canvas_layer);
+    
+    const lv_image_dsc_t image = {
+        .header = buf->header,
+        .data_size = buf->data_size,
+        .data = buf->data,
+    };
+    if (player_ctx.caption_mem) {
+        uint8_t *mem = player_ctx.caption_mem + caption_buf_size() + slot * caption_layer_size();
+        return overlay_layer_init_static(layer, &image, mem, caption_layer_size());
+    }
+    return overlay_layer_init(layer, &image);
+}
+
+/* Rasterize captions of the active and the next cue, which are not ready yet, LVGL lock must be held */
+static void caption_prepare(int active, int next)
+{
+    const int wanted[PLAYER_CAPTIONS] = {active, next};
+    
+    for (int i = 0; i < PLAYER_CAPTIONS; i++) {
+        if (wanted[i] < 0 || caption_find(wanted[i])) {
+            continue;
+        }
+        
+        /* Empty caption or caption of a cue, which is not wanted anymore, is replaced */
+        int cues[PLAYER_CAPTIONS];
+        for (int j = 0; j < PLAYER_CAPTIONS; j++) {
+            cues[j] = player_ctx.captions[j].cue;
+        }
+        const int slot = subtitle_srt_slot(cues, PLAYER_CAPTIONS, active, next);
+        if (slot < 0) {
+            continue;
+        }
+        player_caption_t *caption = &player_ctx.captions[slot];
+        
+        /* Replaced caption is not blended from now, its memory in the arena is rasterized again */
+        xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+        overlay_layer_t old = caption->overlay.layer;
+        const bool old_used = caption->overlay.used;
+        caption->overlay.used = false;
+        caption->cue = -1;
+        xSemaphoreGive(player_ctx.overlay_lock);
+        if (old_used) {
+            overlay_layer_deinit(&old);
+        }
+        
+        /* Rasterization takes time, it is done without overlay lock */
+        PLAYER_TRACE_BEGIN("caption");
+        overlay_layer_t layer = {0};
+        const bool rendered = (caption_render(player_ctx.subtitles.cues[wanted[i]].text, caption - player_ctx.captions, &layer) == ESP_OK);
+        PLAYER_TRACE_END("caption");
+        if (!rendered) {
+            ESP_LOGW(TAG, "Caption of subtitle %d not shown", wanted[i]);
+        }
+        
+        xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+        caption->overlay.layer = layer;
+        caption->overlay.used = rendered;
+        caption->overlay.visible = true;
+        caption->overlay.align = LV_ALIGN_BOTTOM_MID;
+        caption->overlay.x_ofs = 0;
+        caption->overlay.y_ofs = player_ctx.subtitles_cfg.y_ofs;
+        caption->cue = wanted[i];
+        xSemaphoreGive(player_ctx.overlay_lock);
+    }
+}
+
+/* Look-ahead rasterization of captions, runs in LVGL task */
+static void caption_timer_cb(lv_timer_t *timer)
+{
+    int next;
+    
+    if (player_ctx.subtitles.count == 0 || player_ctx.fps == 0) {
+        return;
+    }
+    const int active = subtitle_srt_find(&player_ctx.subtitles, caption_time(player_ctx.decoded_frame), &next);
+    caption_prepare(active, next);
+}
+
 static lv_obj_t * create_lvgl_objects(lv_obj_t * screen)
 {
     /* Create LVGL objects */
@@ -133,9 +698,28 @@ static lv_obj_t * create_lvgl_objects(lv_obj_t * screen)
     lv_obj_t * slider = lv_slider_create(cont_col);
     lv_obj_set_size(slider, player_ctx.screen_width, 5);
     lv_obj_add_state(slider, LV_STATE_DISABLED);
-    lv_obj_set_style_opa(slider, LV_OPA_TRANSP, LV_PART_KNOB);
+    if (player_ctx.seek_enabled) {
+        lv_obj_add_event_cb(slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+        if (player_ctx.scrub_preview) {
+            lv_obj_add_event_cb(slider, slider_event_cb, LV_EVENT_RELEASED, NULL);
+            lv_obj_add_event_cb(slider, slider_event_cb, LV_EVENT_PRESS_LOST, NULL);
+        }
+    } else {
+        lv_obj_set_style_opa(slider, LV_OPA_TRANSP, LV_PART_KNOB);
+    }
     player_ctx.slider = slider;
     
+    /* Scrub preview over the slider, it is not placed by layout of the player (arena player has its buffer in the arena) */
+    if (player_ctx.seek_enabled && player_ctx.scrub_preview && player_ctx.preview_buff == NULL) {
+        player_ctx.preview_buff = heap_caps_malloc(PLAYER_PREVIEW_SIZE * PLAYER_PREVIEW_SIZE * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (player_ctx.preview_buff) {
+        player_ctx.preview = lv_canvas_create(cont_col);
+        lv_obj_add_flag(player_ctx.preview, LV_OBJ_FLAG_FLOATING | LV_OBJ_FLAG_HIDDEN);
+        lv_obj_set_style_border_width(player_ctx.preview, 2, 0);
+        lv_obj_set_style_border_color(player_ctx.preview, lv_color_white(), 0);
+    }
+    
     /* Buttons */
     lv_obj_t *cont_row = lv_obj_create(cont_col);
     lv_obj_set_size(cont_row, player_ctx.screen_width - 20, 80);
@@ -194,6 +778,21 @@ static lv_obj_t * create_lvgl_objects(lv_obj_t * screen)
     lv_obj_add_flag(img_stop, LV_OBJ_FLAG_HIDDEN);
     player_ctx.img_stop = img_stop;
     
+    /* Statistics overlay */
+    lv_obj_t * label_stats = lv_label_create(player_ctx.canvas);
+    lv_obj_set_style_text_color(label_stats, lv_color_white(), 0);
+    lv_obj_set_style_bg_color(label_stats, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(label_stats, LV_OPA_50, 0);
+    lv_obj_set_style_pad_all(label_stats, 4, 0);
+    lv_label_set_text_static(label_stats, "");
+    lv_obj_align(label_stats, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_add_flag(label_stats, LV_OBJ_FLAG_HIDDEN);
+    player_ctx.label_stats = label_stats;
+    
+    /* Hidden canvas for rasterization of captions */
+    player_ctx.caption_canvas = lv_canvas_create(player_ctx.canvas);
+    lv_obj_add_flag(player_ctx.caption_canvas, LV_OBJ_FLAG_HIDDEN);
+    
     /* Hide control buttons */
     if (player_ctx.hide_controls) {
         lv_obj_add_flag(cont_row, LV_OBJ_FLAG_HIDDEN);
@@ -207,127 +806,1363 @@ static lv_obj_t * create_lvgl_objects(lv_obj_t * screen)
         lv_obj_add_flag(img_pause, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(img_stop, LV_OBJ_FLAG_HIDDEN);
     }
-        
+    
+    /* Decoded frames are shown from LVGL task, video task does not need LVGL lock while playing */
+    player_ctx.present_timer = lv_timer_create(present_timer_cb, PLAYER_PRESENT_PERIOD_MS, NULL);
+    player_ctx.stats_timer = lv_timer_create(stats_timer_cb, PLAYER_STATS_PERIOD_MS, NULL);
+    lv_timer_pause(player_ctx.stats_timer);
+    player_ctx.caption_timer = lv_timer_create(caption_timer_cb, PLAYER_CAPTION_PERIOD_MS, NULL);
+    lv_timer_pause(player_ctx.caption_timer);
+    
     lvgl_port_unlock();
     
     return cont_col;
 }
 
-static esp_err_t get_video_size(uint32_t * width, uint32_t * height)
+static esp_err_t video_decoder_init(void)
+{
+    PLAYER_HEAP_CHECK();
+    
+    /* Hardware engine is owned by the shared decoder service */
+    return jpeg_dec_service_client_new(player_ctx.decode_priority, &player_ctx.jpeg);
+}
+
+static void video_decoder_deinit(void)
+{
+    if (player_ctx.jpeg) {
+        jpeg_dec_service_client_del(player_ctx.jpeg);
+        player_ctx.jpeg = NULL;
+    }
+}
+
+static uint8_t * video_decoder_malloc(uint32_t size, bool inbuff, uint32_t * outsize)
+{
+    PLAYER_HEAP_CHECK();
+    
+    const player_mem_class_t mem_class = (inbuff ? PLAYER_MEM_CLASS_ENCODED : PLAYER_MEM_CLASS_DECODED);
+    return (uint8_t *)player_mem_alloc(&player_ctx.placement[mem_class], mem_class, size, outsize);
+}
+
+static void video_decoder_free(uint8_t *buff)
+{
+    PLAYER_HEAP_CHECK();
+    
+    heap_caps_free(buff);
+}
+
+/* Open storage with its cache in memory of the placement */
+static esp_err_t video_storage_open(media_src_t *file)
+{
+    PLAYER_HEAP_CHECK();
+    
+    void *cache = NULL;
+    const uint32_t cache_size = media_src_storage_cache_size();
+    if (cache_size > 0) {
+        cache = player_mem_alloc(&player_ctx.placement[PLAYER_MEM_CLASS_STORAGE], PLAYER_MEM_CLASS_STORAGE, cache_size, NULL);
+        ESP_RETURN_ON_FALSE(cache, ESP_ERR_NO_MEM, TAG, "Allocation of storage cache failed");
+    }
+    if (media_src_storage_open_cache(file, cache) != 0) {
+        heap_caps_free(cache);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* Buffers are parts of the arena, they are never reallocated */
+static bool video_arena_used(void)
+{
+    return (player_ctx.arena_width > 0);
+}
+
+typedef struct {
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    fps;            /* Frame rate (0 = unknown) */
+    uint32_t    align;          /* Frames can be read up to multiple of align (1 = exact spans) */
+    uint32_t    out_size;       /* Size of decoded frame (0 = unknown) */
+} video_container_info_t;
+
+/* Size of RGB565 frame decoded from JPEG with the chroma subsampling, output is aligned to MCU */
+static uint32_t video_out_size(uint32_t width, uint32_t height, slv_sampling_t sampling)
+{
+    switch (sampling) {
+    case SLV_SAMPLING_420:
+        return ALIGN_UP(width, 16) * ALIGN_UP(height, 16) * 2;
+    case SLV_SAMPLING_422:
+    case SLV_SAMPLING_444:
+    case SLV_SAMPLING_GRAY:
+        return ALIGN_UP(width, 16) * ALIGN_UP(height, 8) * 2;
+    default:
+        return 0;
+    }
+}
+
+/* Divide memory of the arena, the first call only counts sizes of the parts (see player_arena_t) */
+static void video_arena_layout(void)
+{
+    player_arena_t *arena = &player_ctx.arena;
+    player_preroll_t *preroll = &player_ctx.preroll;
+    const uint32_t out_size = video_out_size(player_ctx.arena_width, player_ctx.arena_height, SLV_SAMPLING_420);
+    
+    /* Decoder buffers, prerolled file has its own ones (they are swapped on switch) */
+    player_ctx.in_buff = player_arena_take(arena, PLAYER_ARENA_ENCODED, player_ctx.in_buff_size);
+    preroll->in_buff = player_arena_take(arena, PLAYER_ARENA_ENCODED, player_ctx.in_buff_size);
+    preroll->in_buff_size = (preroll->in_buff ? player_ctx.in_buff_size : 0);
+    for (int i = 0; i < FRAME_MAILBOX_SLOTS; i++) {
+        player_frame_t *frame = &player_ctx.frames[i];
+        frame->buff = player_arena_take(arena, PLAYER_ARENA_DECODED, out_size);
+        frame->buff_size = (frame->buff ? out_size : 0);
+        frame->data = frame->buff;
+    }
+    preroll->out_buff = player_arena_take(arena, PLAYER_ARENA_DECODED, out_size);
+    preroll->out_buff_size = (preroll->out_buff ? out_size : 0);
+    if (player_ctx.cache_budget) {
+        player_ctx.arena_cache = player_arena_take(arena, PLAYER_ARENA_DECODED, player_ctx.cache_budget);
+    }
+    
+    /* Indexes of the playing and the prerolled file */
+    const uint32_t index_size = player_ctx.arena_frames * sizeof(frame_index_entry_t);
+    frame_index_entry_t *entries = player_arena_take(arena, PLAYER_ARENA_ANY, index_size);
+    if (entries) {
+        frame_index_init_static(&player_ctx.index, entries, player_ctx.arena_frames);
+    }
+    entries = player_arena_take(arena, PLAYER_ARENA_ANY, index_size);
+    if (entries) {
+        frame_index_init_static(&preroll->index, entries, player_ctx.arena_frames);
+    }
+    
+    if (player_ctx.dirty_regions) {
+        const uint32_t tiles = ((player_ctx.arena_width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE) *
+                               ((player_ctx.arena_height + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE);
+        uint32_t *signatures = player_arena_take(arena, PLAYER_ARENA_ANY, tiles * sizeof(uint32_t));
+        if (signatures) {
+            dirty_tiles_init_static(&player_ctx.tiles, signatures, tiles);
+        }
+    }
+    
+    /* Captions are rasterized into fixed memory */
+    if (player_ctx.caption_width) {
+        player_ctx.caption_mem = player_arena_take(arena, PLAYER_ARENA_ANY, caption_buf_size() + PLAYER_CAPTIONS * caption_layer_size());
+    }
+    
+    /* Scrub preview over the slider */
+    if (player_ctx.seek_enabled && player_ctx.scrub_preview) {
+        player_ctx.preview_buff = player_arena_take(arena, PLAYER_ARENA_ANY, PLAYER_PREVIEW_SIZE * PLAYER_PREVIEW_SIZE * 2);
+    }
+    
+    /* Storage is opened once, files are only connected */
+    void *storage = player_arena_take(arena, PLAYER_ARENA_STORAGE, media_src_storage_mem_size());
+    if (storage) {
+        media_src_storage_open_static(&player_ctx.file, storage);
+    }
+    storage = player_arena_take(arena, PLAYER_ARENA_STORAGE, media_src_storage_mem_size());
+    if (storage) {
+        media_src_storage_open_static(&preroll->file, storage);
+    }
+    player_ctx.snapshot_storage = player_arena_take(arena, PLAYER_ARENA_STORAGE, media_src_storage_mem_size());
+}
+
+/* Parse container of the file from its start in data, only raw M-JPEG returns ESP_ERR_NOT_SUPPORTED. Input buffer is enlarged to the biggest frame. */
+static esp_err_t video_container_open(media_src_t *file, const uint8_t *data, int size, uint8_t **buff, uint32_t *buff_size,
+                                      frame_index_t *index, video_container_info_t *info)
+{
+    uint32_t max_frame_size = 0;
+    
+    memset(info, 0, sizeof(video_container_info_t));
+    info->align = 1;
+    if (size > 0 && slv_demux_probe(data, size)) {
+        slv_demux_info_t slv;
+        esp_err_t err = slv_demux_open(file, data, size, &slv, index);
+        ESP_RETURN_ON_FALSE(err == ESP_OK, (err == ESP_ERR_NOT_SUPPORTED ? ESP_ERR_INVALID_VERSION : err), TAG, "SLV file parsing failed");
+        info->width = slv.width;
+        info->height = slv.height;
+        info->fps = slv.fps;
+        info->align = slv.align;
+        info->out_size = video_out_size(slv.width, slv.height, slv.sampling);
+        max_frame_size = ALIGN_UP(slv.max_frame_size, slv.align);
+    } else if (size > 0 && avi_demux_probe(data, size)) {
+        avi_demux_info_t avi;
+        esp_err_t err = avi_demux_open(file, *buff, *buff_size, &avi, index);
+        ESP_RETURN_ON_FALSE(err == ESP_OK, (err == ESP_ERR_NOT_SUPPORTED ? ESP_ERR_INVALID_VERSION : err), TAG, "AVI file parsing failed");
+        info->width = avi.width;
+        info->height = avi.height;
+        info->fps = avi.fps;
+        max_frame_size = avi.max_frame_size;
+    } else {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    if (max_frame_size > *buff_size) {
+        uint32_t new_size = 0;
+        ESP_RETURN_ON_FALSE(!video_arena_used(), ESP_ERR_INVALID_SIZE, TAG, "The biggest frame (%ld bytes) does not fit buff_size", max_frame_size);
+        ESP_LOGW(TAG, "Input buffer is enlarged to the biggest frame (%ld bytes)", max_frame_size);
+        video_decoder_free(*buff);
+        *buff = video_decoder_malloc(max_frame_size, true, &new_size);
+        ESP_RETURN_ON_FALSE(*buff, ESP_ERR_NO_MEM, TAG, "Allocation in_buff failed");
+        *buff_size = new_size;
+    }
+    return ESP_OK;
+}
+
+/* Read frame of the container to buff, aligned frames are read with their padding by one direct read */
+static int video_container_read(media_src_t *file, uint32_t frame, const frame_index_t *index, uint32_t align, uint8_t *buff, uint32_t buff_size)
+{
+    frame_index_entry_t entry;
+    if (!frame_index_get(index, frame, &entry)) {
+        return -1;
+    }
+    uint32_t len = ALIGN_UP(entry.size, align);
+    if (len > buff_size) {
+        return -1;
+    }
+    int read_size = media_src_storage_read_at(file, entry.offset, buff, len);
+    return (read_size >= (int)entry.size ? (int)entry.size : -1);
+}
+
+static esp_err_t get_video_size(uint32_t * width, uint32_t * height, uint32_t * out_size)
 {
     esp_err_t err;
     jpeg_decode_picture_info_t header;
-    assert(width && height);
+    video_container_info_t info;
+    assert(width && height && out_size);
     
     int size = media_src_storage_read(&player_ctx.file, player_ctx.in_buff, player_ctx.in_buff_size);
     if(size < 0)
         return ESP_ERR_INVALID_SIZE;
     
+    /* Container gives size, frame rate and all frames */
+    err = video_container_open(&player_ctx.file, player_ctx.in_buff, size, &player_ctx.in_buff, &player_ctx.in_buff_size, &player_ctx.index, &info);
+    player_ctx.container = (err == ESP_OK);
+    player_ctx.container_align = info.align;
+    if (err == ESP_OK) {
+        if (player_ctx.cfg_fps == 0) {
+            player_ctx.fps = info.fps;
+        }
+        *width = info.width;
+        *height = info.height;
+        *out_size = info.out_size;
+        return ESP_OK;
+    } else if (err != ESP_ERR_NOT_SUPPORTED) {
+        return err;
+    }
+    
     err = jpeg_decoder_get_info(player_ctx.in_buff, size, &header);
     
     *width = header.width;
     *height = header.height;
+    *out_size = 0;
     
     return err;
 }
 
-static esp_err_t video_decoder_init(void)
+/* Allocate decoded frames which are smaller than size (LVGL must be locked and canvas must not show them) */
+static esp_err_t video_frames_alloc(uint32_t size)
 {
-    jpeg_decode_engine_cfg_t engine_cfg = {
-        .intr_priority = 0,
-        .timeout_ms = 50,
-    };
-    return jpeg_new_decoder_engine(&engine_cfg, &player_ctx.jpeg);
+    for (int i = 0; i < FRAME_MAILBOX_SLOTS; i++) {
+        player_frame_t *frame = &player_ctx.frames[i];
+        frame->data = frame->buff;
+        if (frame->buff_size >= size) {
+            continue;
+        }
+        ESP_RETURN_ON_FALSE(!video_arena_used(), ESP_ERR_INVALID_SIZE, TAG, "Video is bigger than arena of the player");
+        if (frame->buff) {
+            video_decoder_free(frame->buff);
+        }
+        frame->buff = video_decoder_malloc(size, false, &frame->buff_size);
+        frame->data = frame->buff;
+        if (frame->buff == NULL) {
+            frame->buff_size = 0;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
 }
 
-static void video_decoder_deinit(void)
+/* Frame for decoding */
+static player_frame_t *video_back_frame(void)
 {
-    if (player_ctx.jpeg) {
-        jpeg_del_decoder_engine(player_ctx.jpeg);
+    return &player_ctx.frames[frame_mailbox_back(&player_ctx.mailbox)];
+}
+
+/* Read frame from the current position to in_buff, returns size of the frame */
+static int video_read_frame(void)
+{
+    int64_t start = esp_timer_get_time();
+    
+    /* Container gives exact span of the frame */
+    if (player_ctx.container) {
+        int read_size = video_container_read(&player_ctx.file, player_ctx.frame, &player_ctx.index, player_ctx.container_align,
+                                             player_ctx.in_buff, player_ctx.in_buff_size);
+        player_stats_add(&player_ctx.stats, PLAYER_STAT_READ, esp_timer_get_time() - start);
+        return read_size;
+    }
+    
+    /* Behind the last frame, all frames are known after the first pass */
+    if (player_ctx.index.complete && player_ctx.frame >= player_ctx.index.count) {
+        return -1;
+    }
+    
+    int read_size = media_src_storage_read(&player_ctx.file, player_ctx.in_buff, player_ctx.in_buff_size);
+    int64_t read_time = esp_timer_get_time() - start;
+    if (read_size <= 0) {
+        return -1;
+    }
+    
+    /* Search for SOI, position is not on frame boundary after seek without index */
+    int soi = mjpeg_find_frame_start(player_ctx.in_buff, read_size);
+    if (soi < 0) {
+        return -1;
+    }
+    if (soi > 0) {
+        player_ctx.position += soi;
+        media_src_storage_seek(&player_ctx.file, player_ctx.position);
+        int64_t resync = esp_timer_get_time();
+        read_size = media_src_storage_read(&player_ctx.file, player_ctx.in_buff, player_ctx.in_buff_size);
+        read_time += esp_timer_get_time() - resync;
+        if (read_size <= 0) {
+            return -1;
+        }
     }
+    
+    /* Search for EOI */
+    int frame_size = mjpeg_find_frame_end(player_ctx.in_buff, read_size);
+    player_stats_add(&player_ctx.stats, PLAYER_STAT_READ, read_time);
+    player_stats_add(&player_ctx.stats, PLAYER_STAT_PARSE, esp_timer_get_time() - start - read_time);
+    return frame_size;
 }
 
-static uint8_t * video_decoder_malloc(uint32_t size, bool inbuff, uint32_t * outsize)
+/* Decoding which does not start before presentation time of the next frame is not worth it */
+static int64_t video_decode_deadline(void)
 {
-    jpeg_decode_memory_alloc_cfg_t tx_mem_cfg = {
-        .buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER,
-    };
-    jpeg_decode_memory_alloc_cfg_t rx_mem_cfg = {
-        .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
-    };
-    return (uint8_t *)jpeg_alloc_decoder_mem(size, (inbuff ? &tx_mem_cfg : &rx_mem_cfg), (size_t*)outsize);
+    if (player_ctx.fps == 0 || player_ctx.present_time == 0 || player_ctx.state != PLAYER_STATE_PLAYING) {
+        return 0;
+    }
+    return player_ctx.present_time + 1000000 / player_ctx.fps;
 }
 
-static int video_decoder_decode(void)
+/* Returns size of the decoded frame, 0 when the frame was dropped by its deadline, -1 on error */
+static int video_decoder_decode(uint32_t jpeg_image_size, uint8_t *out_buff, uint32_t out_buff_size)
 {
     esp_err_t err;
     uint32_t ret_size = 0;
-    uint32_t jpeg_image_size = 0;
-    uint32_t jpeg_image_size_aligned = 0;
+    uint32_t jpeg_image_size_aligned = ALIGN_UP(jpeg_image_size, 16);
     
-    /* Search for EOI. */
-    uint8_t * match = memmem(player_ctx.in_buff, player_ctx.in_buff_size, &EOI, 2); 
-    if(match)
-    {
-        jpeg_image_size = ((uint32_t)((match+2) - player_ctx.in_buff));  // move match by 2 for skip EOI
-        jpeg_image_size_aligned = ALIGN_UP(jpeg_image_size, 16);
-        assert(jpeg_image_size < player_ctx.in_buff_size);
-        assert(jpeg_image_size_aligned < player_ctx.in_buff_size);
-    }
+    assert(jpeg_image_size <= player_ctx.in_buff_size);
+    jpeg_image_size_aligned = MIN(jpeg_image_size_aligned, player_ctx.in_buff_size);
     
     /* Decode JPEG */
-    ret_size = player_ctx.out_buff_size;
-    err = jpeg_decoder_process(player_ctx.jpeg, &jpeg_decode_cfg, player_ctx.in_buff, jpeg_image_size_aligned, player_ctx.out_buff, player_ctx.out_buff_size, &ret_size);
+    ret_size = out_buff_size;
+    const int64_t deadline = video_decode_deadline();
+    err = jpeg_dec_service_decode(player_ctx.jpeg, &jpeg_decode_cfg, player_ctx.in_buff, jpeg_image_size_aligned, out_buff, out_buff_size,
+                                  deadline, &ret_size);
+    if (err == JPEG_DEC_ERR_LATE && deadline)
+        return 0;
     if(err != ESP_OK)
         return -1;
     
-    assert(ret_size < player_ctx.out_buff_size);
+    assert(ret_size <= out_buff_size);
     
     return jpeg_image_size;
 }
 
-static void show_video_task(void *arg)
+/* Find position and frame number of the seek target, it costs no file access */
+static void video_seek_target(player_seek_t mode, uint32_t value)
+{
+    frame_index_entry_t entry;
+    uint32_t frame = 0;
+    uint64_t position = 0;
+    
+    if (mode == PLAYER_SEEK_TIME_MS) {
+        mode = PLAYER_SEEK_FRAME;
+        value = (uint32_t)(((uint64_t)value * player_ctx.fps) / 1000);
+    }
+    
+    if (mode == PLAYER_SEEK_PERMILLE) {
+        position = (player_ctx.filesize * MIN(value, 1000)) / 1000;
+        if (frame_index_find(&player_ctx.index, position, &frame)) {
+            mode = PLAYER_SEEK_FRAME;
+            value = frame;
+        } else if (player_ctx.container) {
+            /* Headers or index of the container, take the nearest frame */
+            frame_index_get(&player_ctx.index, 0, &entry);
+            mode = PLAYER_SEEK_FRAME;
+            value = (position < entry.offset ? 0 : player_ctx.index.count - 1);
+        } else {
+            /* Not indexed yet, estimate frame number and resync to next SOI */
+            uint32_t avg = frame_index_avg_size(&player_ctx.index);
+            player_ctx.position = position;
+            player_ctx.frame = (avg ? (uint32_t)(position / avg) : 0);
+            player_ctx.frame_exact = (position == 0);
+            return;
+        }
+    }
+    
+    if (player_ctx.index.complete && player_ctx.index.count > 0) {
+        value = MIN(value, player_ctx.index.count - 1);
+    }
+    if (frame_index_get(&player_ctx.index, value, &entry)) {
+        player_ctx.position = entry.offset;
+        player_ctx.frame = value;
+        player_ctx.frame_exact = true;
+    } else if (player_ctx.index.count > 0) {
+        /* Behind the index, estimate position from the last known frame and resync to next SOI */
+        frame_index_get(&player_ctx.index, player_ctx.index.count - 1, &entry);
+        position = entry.offset + entry.size + (uint64_t)(value - player_ctx.index.count) * frame_index_avg_size(&player_ctx.index);
+        player_ctx.position = MIN(position, player_ctx.filesize);
+        player_ctx.frame = value;
+        /* Frame right behind the last known frame starts at its end */
+        player_ctx.frame_exact = (value == player_ctx.index.count);
+    } else {
+        player_ctx.position = 0;
+        player_ctx.frame = 0;
+        player_ctx.frame_exact = true;
+    }
+}
+
+/* Move to the next displayed frame by the index (container or trick-play), skipped frames are not read */
+static void video_step(void)
+{
+    int64_t next = (int64_t)player_ctx.frame + player_ctx.speed;
+    
+    if (next < 0) {
+        ESP_LOGI(TAG, "Rewind reached start of the video.");
+        player_ctx.speed = 1;
+        next = 0;
+    }
+    if (player_ctx.index.complete && next >= player_ctx.index.count) {
+        /* Behind the last frame */
+        player_ctx.position = player_ctx.filesize;
+        player_ctx.frame = player_ctx.index.count;
+        return;
+    }
+    video_seek_target(PLAYER_SEEK_FRAME, (uint32_t)next);
+}
+
+/* Wait for presentation time of the frame, when frame rate is known */
+static void video_wait_present(void)
+{
+    if (player_ctx.fps == 0) {
+        return;
+    }
+    
+    const int64_t frame_time = 1000000 / player_ctx.fps;
+    int64_t now = esp_timer_get_time();
+    if (player_ctx.present_time == 0 || now - player_ctx.present_time > 4 * frame_time) {
+        /* First frame or too late, restart timing */
+        player_ctx.present_time = now;
+    } else if (player_ctx.present_time > now) {
+        vTaskDelay(pdMS_TO_TICKS((player_ctx.present_time - now) / 1000));
+    }
+    player_ctx.present_time += frame_time;
+}
+
+/* Position of the overlay aligned in the video */
+static void video_overlay_pos(const player_overlay_t *overlay, uint32_t width, uint32_t height, int32_t *x, int32_t *y)
+{
+    const int32_t dx = (int32_t)width - (int32_t)overlay->layer.width;
+    const int32_t dy = (int32_t)height - (int32_t)overlay->layer.height;
+    
+    switch (overlay->align) {
+    case LV_ALIGN_TOP_MID:
+    case LV_ALIGN_BOTTOM_MID:
+    case LV_ALIGN_CENTER:
+        *x = dx / 2;
+        break;
+    case LV_ALIGN_TOP_RIGHT:
+    case LV_ALIGN_BOTTOM_RIGHT:
+    case LV_ALIGN_RIGHT_MID:
+        *x = dx;
+        break;
+    default:
+        *x = 0;
+        break;
+    }
+    switch (overlay->align) {
+    case LV_ALIGN_LEFT_MID:
+    case LV_ALIGN_RIGHT_MID:
+    case LV_ALIGN_CENTER:
+        *y = dy / 2;
+        break;
+    case LV_ALIGN_BOTTOM_LEFT:
+    case LV_ALIGN_BOTTOM_MID:
+    case LV_ALIGN_BOTTOM_RIGHT:
+        *y = dy;
+        break;
+    default:
+        *y = 0;
+        break;
+    }
+    *x += overlay->x_ofs;
+    *y += overlay->y_ofs;
+}
+
+/* Index of the subtitle cue shown in the frame (-1 = none), overlay or LVGL lock must be held */
+static int video_caption_cue(uint32_t frame, int *next)
+{
+    if (player_ctx.subtitles.count == 0 || player_ctx.fps == 0) {
+        return -1;
+    }
+    return subtitle_srt_find(&player_ctx.subtitles, caption_time(frame), next);
+}
+
+/* Caption of the frame is rasterized now, when look-ahead did not prepare it (start of the video, seek) */
+static void video_caption_prepare(uint32_t frame)
+{
+    int next = -1;
+    
+    xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+    const int cue = video_caption_cue(frame, NULL);
+    const bool ready = (cue < 0 || caption_find(cue));
+    xSemaphoreGive(player_ctx.overlay_lock);
+    if (ready) {
+        return;
+    }
+    
+    /* Overlay lock is always taken after LVGL lock */
+    lvgl_port_lock(0);
+    const int active = video_caption_cue(frame, &next);
+    caption_prepare(active, next);
+    lvgl_port_unlock();
+}
+
+/* Blend visible overlays and caption onto decoded region of the video, LVGL draws only the video then */
+static void video_overlays_blend(uint8_t *buff, uint32_t stride, const jpeg_roi_rect_t *region, uint32_t frame)
+{
+    if (player_ctx.overlay_lock == NULL) {
+        return;
+    }
+    
+    video_caption_prepare(frame);
+    
+    PLAYER_TRACE_BEGIN("overlay");
+    xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+    for (int i = 0; i < PLAYER_OVERLAYS_MAX; i++) {
+        const player_overlay_t *overlay = &player_ctx.overlays[i];
+        if (overlay->used && overlay->visible) {
+            int32_t x, y;
+            video_overlay_pos(overlay, player_ctx.video_width, player_ctx.video_height, &x, &y);
+            overlay_layer_blend(&overlay->layer, x - region->x, y - region->y, buff, stride, region->width, region->height);
+        }
+    }
+    const player_caption_t *caption = caption_find(video_caption_cue(frame, NULL));
+    if (caption && caption->overlay.used) {
+        int32_t x, y;
+        video_overlay_pos(&caption->overlay, player_ctx.video_width, player_ctx.video_height, &x, &y);
+        overlay_layer_blend(&caption->overlay.layer, x - region->x, y - region->y, buff, stride, region->width, region->height);
+    }
+    xSemaphoreGive(player_ctx.overlay_lock);
+    PLAYER_TRACE_END("overlay");
+}
+
+/* Viewport clipped to the video, returns false when the whole video is shown */
+static bool video_viewport(jpeg_roi_rect_t *view)
+{
+    const jpeg_roi_rect_t *viewport = &player_ctx.viewport;
+    
+    view->x = 0;
+    view->y = 0;
+    view->width = player_ctx.video_width;
+    view->height = player_ctx.video_height;
+    if (viewport->width == 0 || viewport->x >= player_ctx.video_width || viewport->y >= player_ctx.video_height) {
+        return false;
+    }
+    view->x = viewport->x;
+    view->y = viewport->y;
+    view->width = MIN(viewport->width, player_ctx.video_width - viewport->x);
+    view->height = MIN(viewport->height, player_ctx.video_height - viewport->y);
+    return true;
+}
+
+/* Set shown area of the frame decoded from region of the video */
+static void video_frame_area(player_frame_t *frame, const jpeg_roi_rect_t *region)
+{
+    jpeg_roi_rect_t view;
+    
+    video_viewport(&view);
+    frame->stride = video_stride(region->width);
+    frame->offset = (view.y - region->y) * frame->stride + (view.x - region->x) * 2;
+    frame->width = view.width;
+    frame->height = view.height;
+}
+
+/* Apply the latest viewport request, returns true when the viewport was changed */
+static bool video_process_viewport(void)
+{
+    portENTER_CRITICAL(&player_ctx.viewport_lock);
+    bool pending = player_ctx.viewport_pending;
+    if (pending) {
+        player_ctx.viewport = player_ctx.viewport_request;
+        player_ctx.viewport_pending = false;
+    }
+    portEXIT_CRITICAL(&player_ctx.viewport_lock);
+    
+    /* Shown frame is decoded again with the new viewport */
+    if (pending) {
+        player_ctx.repeat_valid = false;
+    }
+    return pending;
+}
+
+/* Count memory of all buffers, called from video task when buffers change */
+static void video_mem_update(void)
+{
+    esp_lvgl_simple_player_mem_report_t report = {0};
+    player_preroll_t *preroll = &player_ctx.preroll;
+    const uint32_t storage_size = media_src_storage_cache_size();
+    
+    if (player_ctx.file.sub_src) {
+        player_mem_count(&report.storage, &player_ctx.placement[PLAYER_MEM_CLASS_STORAGE], media_src_storage_get_cache(&player_ctx.file), storage_size);
+    }
+    player_mem_count(&report.encoded, &player_ctx.placement[PLAYER_MEM_CLASS_ENCODED], player_ctx.in_buff, player_ctx.in_buff_size);
+    for (int i = 0; i < FRAME_MAILBOX_SLOTS; i++) {
+        player_mem_count(&report.decoded, &player_ctx.placement[PLAYER_MEM_CLASS_DECODED], player_ctx.frames[i].buff, player_ctx.frames[i].buff_size);
+    }
+    /* Running preroll changes its buffers, they are counted after switch */
+    if (!preroll->started) {
+        if (preroll->file.sub_src) {
+            player_mem_count(&report.storage, &player_ctx.placement[PLAYER_MEM_CLASS_STORAGE], media_src_storage_get_cache(&preroll->file), storage_size);
+        }
+        player_mem_count(&report.encoded, &player_ctx.placement[PLAYER_MEM_CLASS_ENCODED], preroll->in_buff, preroll->in_buff_size);
+        player_mem_count(&report.decoded, &player_ctx.placement[PLAYER_MEM_CLASS_DECODED], preroll->out_buff, preroll->out_buff_size);
+    }
+    if (player_ctx.arena_cache) {
+        player_mem_count(&report.decoded, &player_ctx.placement[PLAYER_MEM_CLASS_DECODED], player_ctx.arena_cache, player_ctx.cache_budget);
+    } else if (player_ctx.cache.frames) {
+        for (uint32_t i = 0; i < player_ctx.cache.capacity; i++) {
+            player_mem_count(&report.decoded, &player_ctx.placement[PLAYER_MEM_CLASS_DECODED], player_ctx.cache.frames[i], player_ctx.cache.frame_size);
+        }
+    }
+    
+    portENTER_CRITICAL(&player_ctx.mem_lock);
+    player_ctx.mem_report = report;
+    portEXIT_CRITICAL(&player_ctx.mem_lock);
+}
+
+/* Frame cache uses memory of the arena when it was reserved */
+static esp_err_t video_cache_create(void)
+{
+    if (player_ctx.arena_cache) {
+        return frame_cache_init_static(&player_ctx.cache, player_ctx.arena_cache, player_ctx.cache_budget, player_ctx.cache_frame_size);
+    }
+    return frame_cache_init(&player_ctx.cache, player_ctx.cache_budget, player_ctx.cache_frame_size, &player_ctx.placement[PLAYER_MEM_CLASS_DECODED]);
+}
+
+/* Cache of decoded frames for the current video, when all its frames fit the budget */
+static void video_cache_init(uint32_t width, uint32_t height, uint32_t out_size)
+{
+    if (player_ctx.cache_budget == 0) {
+        return;
+    }
+    
+    /* RGB565 output is never bigger than the video aligned to 16x16 MCU */
+    player_ctx.cache_frame_size = MIN(out_size, video_out_size(width, height, SLV_SAMPLING_420));
+    if (player_ctx.index.complete && (uint64_t)player_ctx.index.count * player_ctx.cache_frame_size > player_ctx.cache_budget) {
+        ESP_LOGI(TAG, "Video does not fit frame cache (%ld frames)", player_ctx.index.count);
+        return;
+    }
+    if (video_cache_create() != ESP_OK) {
+        ESP_LOGW(TAG, "Frame cache not available");
+    }
+}
+
+/* Free cached frames, frames handed over to LVGL are copied to their own buffers */
+static void video_cache_free(void)
+{
+    if (player_ctx.cache.frames == NULL) {
+        return;
+    }
+    
+    lvgl_port_lock(0);
+    for (int i = 0; i < FRAME_MAILBOX_SLOTS; i++) {
+        player_frame_t *frame = &player_ctx.frames[i];
+        if (frame->data != frame->buff) {
+            memcpy(frame->buff, frame->data, MIN(frame->buff_size, player_ctx.cache.frame_size));
+            frame->data = frame->buff;
+        }
+    }
+    lv_draw_buf_t *draw_buf = lv_canvas_get_draw_buf(player_ctx.canvas);
+    if (draw_buf && draw_buf->data) {
+        const player_frame_t *front = &player_ctx.frames[frame_mailbox_front(&player_ctx.mailbox)];
+        draw_buf->data = front->data + front->offset;
+        draw_buf->unaligned_data = draw_buf->data;
+        lv_image_cache_drop(draw_buf);
+    }
+    lvgl_port_unlock();
+    frame_cache_deinit(&player_ctx.cache);
+    video_mem_update();
+}
+
+/* Buffer of the cache for decoding the current frame, NULL when the frame is not cached */
+static uint8_t *video_cache_slot(void)
+{
+    if (player_ctx.cache.frames == NULL || !player_ctx.frame_exact) {
+        return NULL;
+    }
+    uint8_t *buff = frame_cache_alloc(&player_ctx.cache, player_ctx.frame);
+    if (buff == NULL) {
+        /* Longer raw M-JPEG than the budget or not enough memory */
+        ESP_LOGI(TAG, "Video does not fit frame cache, frames are decoded every time");
+        video_cache_free();
+    }
+    return buff;
+}
+
+/* Index of the next playlist file, returns false at the end of the playlist */
+static bool playlist_next_index(uint32_t *next)
+{
+    if (player_ctx.playlist_count == 0) {
+        return false;
+    }
+    if (player_ctx.playlist_shuffle && player_ctx.playlist_count > 1) {
+        /* Random file, other than current */
+        *next = (player_ctx.playlist_current + 1 + esp_random() % (player_ctx.playlist_count - 1)) % player_ctx.playlist_count;
+        return true;
+    }
+    if (player_ctx.playlist_current + 1 < player_ctx.playlist_count) {
+        *next = player_ctx.playlist_current + 1;
+        return true;
+    }
+    if (player_ctx.playlist_loop) {
+        *next = 0;
+        return true;
+    }
+    return false;
+}
+
+/* Open next file, read and decode its first frame */
+static esp_err_t preroll_file(void)
 {
     esp_err_t ret = ESP_OK;
-    int read_size = 0;
-    int processed = 0;
-    uint32_t all_size = 0;
+    player_preroll_t *preroll = &player_ctx.preroll;
+    jpeg_decode_picture_info_t header;
+    video_container_info_t info;
+    
+    ESP_LOGI(TAG, "Preroll file %s ...", preroll->file_path);
+    PLAYER_TRACE_BEGIN("preroll");
+    if (preroll->file.sub_src == NULL) {
+        ESP_GOTO_ON_ERROR(video_storage_open(&preroll->file), err, TAG, "Storage open failed");
+    }
+    ESP_GOTO_ON_FALSE(media_src_storage_connect(&preroll->file, preroll->file_path) == 0, ESP_ERR_NOT_FOUND, err, TAG, "Storage connect failed");
+    ESP_GOTO_ON_FALSE(media_src_storage_get_size(&preroll->file, &preroll->filesize) == 0, ESP_ERR_NOT_FOUND, err, TAG, "Get file size failed");
+    
+    /* Buffers are kept between prerolls */
+    if (preroll->in_buff == NULL) {
+        preroll->in_buff = video_decoder_malloc(player_ctx.in_buff_size, true, &preroll->in_buff_size);
+        ESP_GOTO_ON_FALSE(preroll->in_buff, ESP_ERR_NO_MEM, err, TAG, "Allocation in_buff failed");
+    }
+    
+    /* First frame */
+    int size = media_src_storage_read(&preroll->file, preroll->in_buff, preroll->in_buff_size);
+    ret = video_container_open(&preroll->file, preroll->in_buff, size, &preroll->in_buff, &preroll->in_buff_size, &preroll->index, &info);
+    preroll->container = (ret == ESP_OK);
+    preroll->align = info.align;
+    preroll->fps = info.fps;
+    if (preroll->container) {
+        size = video_container_read(&preroll->file, 0, &preroll->index, info.align, preroll->in_buff, preroll->in_buff_size);
+        ESP_GOTO_ON_FALSE(size > 0, ESP_ERR_INVALID_SIZE, err, TAG, "Read first frame failed");
+        preroll->frame_size = size;
+    } else {
+        ESP_GOTO_ON_FALSE(ret == ESP_ERR_NOT_SUPPORTED, ret, err, TAG, "Container parsing failed");
+        ret = ESP_OK;
+        ESP_GOTO_ON_FALSE(size > 0 && mjpeg_find_frame_start(preroll->in_buff, size) == 0, ESP_ERR_INVALID_SIZE, err, TAG, "No frame at start of file");
+        preroll->frame_size = mjpeg_find_frame_end(preroll->in_buff, size);
+        ESP_GOTO_ON_FALSE(preroll->frame_size > 0, ESP_ERR_INVALID_SIZE, err, TAG, "First frame is bigger than buffer");
+    }
+    ESP_GOTO_ON_ERROR(jpeg_decoder_get_info(preroll->in_buff, preroll->frame_size, &header), err, TAG, "Get video size failed");
+    preroll->width = header.width;
+    preroll->height = header.height;
+    preroll->out_size = (info.out_size ? info.out_size : video_out_size(preroll->width, preroll->height, SLV_SAMPLING_420));
+    
+    if (preroll->out_buff_size < preroll->out_size) {
+        ESP_GOTO_ON_FALSE(!video_arena_used(), ESP_ERR_INVALID_SIZE, err, TAG, "Video is bigger than arena of the player");
+        video_decoder_free(preroll->out_buff);
+        preroll->out_buff = video_decoder_malloc(preroll->out_size, false, &preroll->out_buff_size);
+        ESP_GOTO_ON_FALSE(preroll->out_buff, ESP_ERR_NO_MEM, err, TAG, "Allocation out_buff failed");
+    }
+    
+    /* Decode first frame with lower priority than playing video, it is shown at the end of the playing one */
+    uint32_t decode_size = MIN(ALIGN_UP((uint32_t)preroll->frame_size, 16), preroll->in_buff_size);
+    ret = jpeg_dec_service_decode(preroll->jpeg, &jpeg_decode_cfg, preroll->in_buff, decode_size, preroll->out_buff, preroll->out_buff_size,
+                                  esp_timer_get_time() + JPEG_DEC_DEADLINE_RELAXED_US, NULL);
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "Decode first frame failed");
+    
+err:
+    if (ret != ESP_OK && preroll->file.sub_src) {
+        media_src_storage_disconnect(&preroll->file);
+    }
+    PLAYER_TRACE_END("preroll");
+    return ret;
+}
+
+/* Preroll task is kept between files, it prerolls on notification */
+static void preroll_task(void *arg)
+{
+    player_preroll_t *preroll = &player_ctx.preroll;
+    
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (preroll->exit) {
+            break;
+        }
+        preroll->result = preroll_file();
+        xSemaphoreGive(preroll->done);
+    }
+    preroll->task = NULL;
+    xSemaphoreGive(preroll->done);
+    vTaskDelete(NULL);
+}
+
+/* Create preroll task and its decoder client, once for all files */
+static esp_err_t preroll_init(void)
+{
+    player_preroll_t *preroll = &player_ctx.preroll;
+    
+    if (preroll->task) {
+        return ESP_OK;
+    }
+    PLAYER_HEAP_CHECK();
+    if (preroll->done == NULL) {
+        preroll->done = xSemaphoreCreateBinary();
+        ESP_RETURN_ON_FALSE(preroll->done, ESP_ERR_NO_MEM, TAG, "Create semaphore failed");
+    }
+    /* First frame is decoded with lower priority than playing video */
+    if (preroll->jpeg == NULL) {
+        ESP_RETURN_ON_ERROR(jpeg_dec_service_client_new(JPEG_DEC_PRIORITY_NORMAL, &preroll->jpeg), TAG, "JPEG decoder not available");
+    }
+    preroll->exit = false;
+    ESP_RETURN_ON_FALSE(xTaskCreate(preroll_task, "preroll task", 4096, NULL, 3, &preroll->task) == pdPASS, ESP_ERR_NO_MEM, TAG, "Create preroll task failed");
+    return ESP_OK;
+}
+
+/* Stop preroll task and delete its decoder client */
+static void preroll_deinit(void)
+{
+    player_preroll_t *preroll = &player_ctx.preroll;
+    
+    if (preroll->task) {
+        preroll->exit = true;
+        xTaskNotifyGive(preroll->task);
+        xSemaphoreTake(preroll->done, portMAX_DELAY);
+    }
+    if (preroll->jpeg) {
+        jpeg_dec_service_client_del(preroll->jpeg);
+        preroll->jpeg = NULL;
+    }
+}
+
+/* Start preroll of the next playlist file */
+static void preroll_start(void)
+{
+    uint32_t next;
+    player_preroll_t *preroll = &player_ctx.preroll;
+    
+    if (preroll->started || !playlist_next_index(&next)) {
+        return;
+    }
+    if (preroll_init() != ESP_OK) {
+        return;
+    }
+    
+    preroll->playlist_index = next;
+    preroll->file_path = player_ctx.playlist[next];
+    preroll->result = ESP_FAIL;
+    preroll->started = true;
+    xTaskNotifyGive(preroll->task);
+}
+
+/* Wait for running preroll */
+static esp_err_t preroll_wait(void)
+{
+    player_preroll_t *preroll = &player_ctx.preroll;
+    
+    if (!preroll->started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(preroll->done, portMAX_DELAY);
+    preroll->started = false;
+    return preroll->result;
+}
+
+/* Release prerolled file and buffers, buffers of the arena are kept */
+static void preroll_free(void)
+{
+    player_preroll_t *preroll = &player_ctx.preroll;
+    
+    preroll_wait();
+    preroll_deinit();
+    if (preroll->file.sub_src) {
+        media_src_storage_disconnect(&preroll->file);
+    }
+    if (video_arena_used()) {
+        frame_index_free(&preroll->index);
+        return;
+    }
+    if (preroll->file.sub_src) {
+        media_src_storage_close(&preroll->file);
+        preroll->file.sub_src = NULL;
+    }
+    if (preroll->in_buff) {
+        video_decoder_free(preroll->in_buff);
+        preroll->in_buff = NULL;
+    }
+    if (preroll->out_buff) {
+        video_decoder_free(preroll->out_buff);
+        preroll->out_buff = NULL;
+        preroll->out_buff_size = 0;
+    }
+    frame_index_free(&preroll->index);
+}
+
+/* Span of the original JPEG of the current frame in the file, snapshot reads it again */
+static void video_frame_span(player_frame_t *frame, int frame_size)
+{
+    frame_index_entry_t entry;
+    
+    frame->file = player_ctx.file_path;
+    frame->number = player_ctx.frame;
+    if ((player_ctx.container || player_ctx.frame_exact) && frame_index_get(&player_ctx.index, player_ctx.frame, &entry)) {
+        frame->jpeg_offset = entry.offset;
+        frame->jpeg_size = entry.size;
+    } else {
+        frame->jpeg_offset = player_ctx.position;
+        frame->jpeg_size = frame_size;
+    }
+}
+
+/* Switch to the prerolled file, its first frame is shown without gap */
+static esp_err_t preroll_switch(void)
+{
+    esp_err_t ret = ESP_OK;
+    player_preroll_t *preroll = &player_ctx.preroll;
+    player_frame_t *frame = video_back_frame();
+    uint8_t index = frame_mailbox_back(&player_ctx.mailbox);
+    uint8_t *buff;
+    uint32_t buff_size;
+    jpeg_roi_rect_t region;
+    
+    ESP_RETURN_ON_ERROR(preroll_wait(), TAG, "Preroll of next file failed");
+    
+    /* Close current file, its storage is reused by the next preroll */
+    media_src_t file = player_ctx.file;
+    media_src_storage_disconnect(&file);
+    player_ctx.file = preroll->file;
+    preroll->file = file;
+    player_ctx.file_path = preroll->file_path;
+    player_ctx.filesize = preroll->filesize;
+    player_ctx.playlist_current = preroll->playlist_index;
+    ESP_LOGI(TAG, "Playing file %s", player_ctx.file_path);
+    
+    /* Swap buffers, current buffers are reused by the next preroll */
+    buff = player_ctx.in_buff;
+    buff_size = player_ctx.in_buff_size;
+    player_ctx.in_buff = preroll->in_buff;
+    player_ctx.in_buff_size = preroll->in_buff_size;
+    preroll->in_buff = buff;
+    preroll->in_buff_size = buff_size;
+    buff = frame->buff;
+    buff_size = frame->buff_size;
+    frame->buff = preroll->out_buff;
+    frame->buff_size = preroll->out_buff_size;
+    preroll->out_buff = buff;
+    preroll->out_buff_size = buff_size;
+    frame->data = frame->buff;
+    
+    /* First frame is decoded whole, viewport is only its part */
+    const bool resized = (preroll->width != player_ctx.video_width || preroll->height != player_ctx.video_height);
+    player_ctx.video_width = preroll->width;
+    player_ctx.video_height = preroll->height;
+    region.x = 0;
+    region.y = 0;
+    region.width = preroll->width;
+    region.height = preroll->height;
+    video_frame_area(frame, &region);
+    player_ctx.fps = (player_ctx.cfg_fps ? player_ctx.cfg_fps : preroll->fps);
+    video_overlays_blend(frame->buff, frame->stride, &region, 0);
+    
+    /* First frame is already decoded */
+    player_ctx.container = preroll->container;
+    player_ctx.container_align = preroll->align;
+    if (preroll->container) {
+        /* Swap indexes, memory of the current one is reused by the next preroll */
+        frame_index_t index = player_ctx.index;
+        player_ctx.index = preroll->index;
+        preroll->index = index;
+        player_ctx.frame = 0;
+        video_frame_span(frame, preroll->frame_size);
+        video_step();
+    } else {
+        frame_index_clear(&player_ctx.index);
+        frame_index_add(&player_ctx.index, 0, 0, preroll->frame_size);
+        player_ctx.frame = 0;
+        player_ctx.frame_exact = true;
+        video_frame_span(frame, preroll->frame_size);
+        player_ctx.position = preroll->frame_size;
+        player_ctx.frame = 1;
+    }
+    media_src_storage_seek(&player_ctx.file, player_ctx.position);
+    
+    video_wait_present();
+    
+    lvgl_port_lock(0);
+    /* First frame is shown directly, other frames are reallocated when they are too small for the next video */
+    frame_mailbox_reset(&player_ctx.mailbox, index);
+    player_ctx.shown_seq = player_ctx.frame_seq;
+    video_canvas_set(frame);
+    ret = video_frames_alloc(preroll->out_size);
+    if (resized) {
+        if (player_ctx.auto_width || player_ctx.auto_height) {
+            uint32_t h = (player_ctx.auto_height ? (preroll->height+120) : lv_obj_get_height(player_ctx.main));
+            uint32_t w = (player_ctx.auto_width ? preroll->width : lv_obj_get_width(player_ctx.main));
+            lv_obj_set_size(player_ctx.main, w, h);
+        }
+    }
+    lv_obj_invalidate(player_ctx.canvas);
+    lv_slider_set_value(player_ctx.slider, ((float)player_ctx.position/(float)player_ctx.filesize)*1000, LV_ANIM_OFF);
+    lvgl_port_unlock();
+    ESP_RETURN_ON_ERROR(ret, TAG, "Allocation of frames failed");
+    if (player_ctx.dirty_regions && dirty_tiles_init(&player_ctx.tiles, player_ctx.video_width, player_ctx.video_height) != ESP_OK) {
+        ESP_LOGW(TAG, "Not enough memory for dirty regions, whole video will be refreshed");
+    }
+    player_ctx.repeat_valid = false;
+    video_cache_init(preroll->width, preroll->height, preroll->out_size);
+    video_mem_update();
+    
+    /* Prepare the following file */
+    preroll_start();
+    return ESP_OK;
+}
+
+/* Index frames of raw M-JPEG from the end of the indexed part up to the target, returns false when it was interrupted */
+static bool video_index_scan(uint32_t target)
+{
+    frame_index_entry_t entry;
+    uint64_t position = 0;
+    uint32_t frame = player_ctx.index.count;
+    int offset = 0;
+    
+    if (frame > 0) {
+        frame_index_get(&player_ctx.index, frame - 1, &entry);
+        position = (uint64_t)entry.offset + entry.size;
+    }
+    
+    PLAYER_TRACE_BEGIN("index scan");
+    media_src_storage_seek(&player_ctx.file, position);
+    int size = media_src_storage_read(&player_ctx.file, player_ctx.in_buff, player_ctx.in_buff_size);
+    while (frame <= target && size > 0) {
+        /* Newer seek or stop wins */
+        if (player_ctx.seek_pending || player_ctx.state == PLAYER_STATE_STOPPED) {
+            PLAYER_TRACE_END("index scan");
+            return false;
+        }
+        
+        /* All frames in the read data are indexed, data is read again from the first incomplete frame */
+        int start = (offset < size ? mjpeg_find_frame_start(player_ctx.in_buff + offset, size - offset) : -1);
+        int frame_size = (start < 0 ? -1 : mjpeg_find_frame_end(player_ctx.in_buff + offset + start, size - offset - start));
+        if (frame_size > 0) {
+            if (frame_index_add(&player_ctx.index, frame, position + offset + start, frame_size) != ESP_OK) {
+                break;
+            }
+            offset += start + frame_size;
+            frame++;
+            continue;
+        }
+        if (size < (int)player_ctx.in_buff_size) {
+            /* No complete frame up to the end of file */
+            size = 0;
+            break;
+        }
+        if (offset == 0 && start == 0) {
+            ESP_LOGW(TAG, "Frame %ld is bigger than buffer", frame);
+            break;
+        }
+        /* Without start marker, its first bytes can be at the end of data */
+        position += (start < 0 ? (uint64_t)MAX(offset, size - 2) : (uint64_t)(offset + start));
+        media_src_storage_seek(&player_ctx.file, position);
+        size = media_src_storage_read(&player_ctx.file, player_ctx.in_buff, player_ctx.in_buff_size);
+        offset = 0;
+    }
+    if (size == 0) {
+        player_ctx.index.complete = true;
+    }
+    PLAYER_TRACE_END("index scan");
+    return true;
+}
+
+/* Process the latest seek request, returns true if seek was done */
+static bool video_process_seek(void)
+{
+    portENTER_CRITICAL(&player_ctx.seek_lock);
+    bool pending = player_ctx.seek_pending;
+    player_seek_t mode = player_ctx.seek_mode;
+    uint32_t value = player_ctx.seek_value;
+    player_ctx.seek_pending = false;
+    portEXIT_CRITICAL(&player_ctx.seek_lock);
+    
+    if (!pending) {
+        return false;
+    }
+    
+    /* Frame and time seeks land on the exact frame, raw M-JPEG is indexed up to it */
+    if (mode != PLAYER_SEEK_PERMILLE && !player_ctx.container && !player_ctx.index.complete) {
+        const uint32_t target = (mode == PLAYER_SEEK_TIME_MS ? (uint32_t)(((uint64_t)value * player_ctx.fps) / 1000) : value);
+        if (target >= player_ctx.index.count && !video_index_scan(target)) {
+            /* Newer request is processed right now */
+            return false;
+        }
+    }
+    
+    video_seek_target(mode, value);
+    media_src_storage_seek(&player_ctx.file, player_ctx.position);
+    return true;
+}
+
+/* Open file and prepare buffers, buffers and decoder from previous play are reused when possible */
+static esp_err_t video_open(void)
+{
+    /* Playlist has priority over file from configuration */
+    if (player_ctx.playlist_count > 0) {
+        player_ctx.file_path = player_ctx.playlist[player_ctx.playlist_current];
+    } else {
+        player_ctx.file_path = player_ctx.single_file;
+    }
     
     /* Open file */
     ESP_LOGI(TAG, "Opening file %s ...", player_ctx.file_path);
-    ESP_GOTO_ON_FALSE(media_src_storage_open(&player_ctx.file) == 0, ESP_ERR_NO_MEM, err, TAG, "Storage open failed");
-    ESP_GOTO_ON_FALSE(media_src_storage_connect(&player_ctx.file, player_ctx.file_path) == 0, ESP_ERR_NO_MEM, err, TAG, "Storage connect failed");
-
+    if (player_ctx.file.sub_src == NULL) {
+        ESP_RETURN_ON_ERROR(video_storage_open(&player_ctx.file), TAG, "Storage open failed");
+    }
+    ESP_RETURN_ON_FALSE(media_src_storage_connect(&player_ctx.file, player_ctx.file_path) == 0, ESP_ERR_NOT_FOUND, TAG, "Storage connect failed");
+    
     /* Get file size */
-    ESP_GOTO_ON_FALSE(media_src_storage_get_size(&player_ctx.file, &player_ctx.filesize) == 0, ESP_ERR_NO_MEM, err, TAG, "Get file size failed");
-
+    ESP_RETURN_ON_FALSE(media_src_storage_get_size(&player_ctx.file, &player_ctx.filesize) == 0, ESP_ERR_NOT_FOUND, TAG, "Get file size failed");
+    
     /* Create input buffer */
-    player_ctx.in_buff = video_decoder_malloc(player_ctx.in_buff_size, true, &player_ctx.in_buff_size);
-    ESP_GOTO_ON_FALSE(player_ctx.in_buff, ESP_ERR_NO_MEM, err, TAG, "Allocation in_buff failed");
-
+    if (player_ctx.in_buff == NULL) {
+        player_ctx.in_buff = video_decoder_malloc(player_ctx.in_buff_size, true, &player_ctx.in_buff_size);
+        ESP_RETURN_ON_FALSE(player_ctx.in_buff, ESP_ERR_NO_MEM, TAG, "Allocation in_buff failed");
+    }
+    
     /* Init video decoder */
-    ESP_GOTO_ON_ERROR(video_decoder_init(), err, TAG, "Initialize video decoder failed");
-    /* Get video output size */
+    if (player_ctx.jpeg == NULL) {
+        ESP_RETURN_ON_ERROR(video_decoder_init(), TAG, "Initialize video decoder failed");
+    }
+    /* Get video output size, frame rate and index from container */
     uint32_t height = 0;
     uint32_t width = 0;
-    ESP_GOTO_ON_ERROR(get_video_size(&width, &height), err, TAG, "Get video file size failed");
-    width = ALIGN_UP(width, 16);
+    uint32_t out_size = 0;
+    player_ctx.fps = player_ctx.cfg_fps;
+    frame_index_clear(&player_ctx.index);
+    ESP_RETURN_ON_ERROR(get_video_size(&width, &height, &out_size), TAG, "Get video file size failed");
+    player_ctx.video_width = width;
+    player_ctx.video_height = height;
     
     ESP_LOGI(TAG, "Video size: %ld x %ld", width, height);
     
-    /* Create output buffer */
-    player_ctx.out_buff_size = width * height * 3;
-    player_ctx.out_buff = video_decoder_malloc(player_ctx.out_buff_size, false, &player_ctx.out_buff_size);
-    ESP_GOTO_ON_FALSE(player_ctx.out_buff, ESP_ERR_NO_MEM, err, TAG, "Allocation out_buff failed");
-    			 
+    /* Create output frames, when the previous ones are too small */
     lvgl_port_lock(0);
-	/* Set buffer to LVGL canvas */ 
-    lv_canvas_set_buffer(player_ctx.canvas, player_ctx.out_buff, width, height, LV_COLOR_FORMAT_RGB565);
-    lv_obj_invalidate(player_ctx.canvas);
+    lv_canvas_set_buffer(player_ctx.canvas, NULL, 0, 0, LV_COLOR_FORMAT_RGB565);
+    frame_mailbox_reset(&player_ctx.mailbox, 0);
+    player_ctx.shown_seq = player_ctx.frame_seq;
+    if (out_size == 0) {
+        out_size = video_out_size(width, height, SLV_SAMPLING_420);
+    }
+    esp_err_t ret = video_frames_alloc(out_size);
+    lvgl_port_unlock();
+    ESP_RETURN_ON_ERROR(ret, TAG, "Allocation of frames failed");
+    video_cache_init(width, height, out_size);
+    
+    /* Signatures of tiles for dirty regions, whole video is refreshed when allocation fails */
+    if (player_ctx.dirty_regions && dirty_tiles_init(&player_ctx.tiles, width, height) != ESP_OK) {
+        ESP_LOGW(TAG, "Not enough memory for dirty regions, whole video will be refreshed");
+    }
+    
+    video_mem_update();
+    const esp_lvgl_simple_player_mem_report_t *report = &player_ctx.mem_report;
+    ESP_LOGI(TAG, "Memory internal/PSRAM: storage %ld/%ld, encoded %ld/%ld, decoded %ld/%ld bytes",
+             report->storage.internal, report->storage.psram, report->encoded.internal, report->encoded.psram,
+             report->decoded.internal, report->decoded.psram);
+    if (report->storage.misplaced || report->encoded.misplaced || report->decoded.misplaced) {
+        ESP_LOGW(TAG, "Buffers not placed as requested: storage %ld, encoded %ld, decoded %ld",
+                 report->storage.misplaced, report->encoded.misplaced, report->decoded.misplaced);
+    }
+    
+    /* Everything is prepared with the arena, playing must not use heap from now */
+    if (video_arena_used()) {
+        ESP_RETURN_ON_ERROR(preroll_init(), TAG, "Preroll init failed");
+        player_ctx.arena_sealed = true;
+    }
+    return ESP_OK;
+}
+
+/* Release all buffers, decoder and storage */
+static void video_release(void)
+{
+    /* Release prerolled file */
+    player_ctx.arena_sealed = false;
+    preroll_free();
+    
+    /* Deinit video decoder */
+    video_decoder_deinit();
+    
+    /* Storage and buffers of the arena are kept for the next play */
+    if (video_arena_used()) {
+        if (player_ctx.file.sub_src) {
+            media_src_storage_disconnect(&player_ctx.file);
+        }
+        lvgl_port_lock(0);
+        lv_canvas_set_buffer(player_ctx.canvas, NULL, 0, 0, LV_COLOR_FORMAT_RGB565);
+        lvgl_port_unlock();
+        frame_index_free(&player_ctx.index);
+        dirty_tiles_deinit(&player_ctx.tiles);
+        video_mem_update();
+        ESP_LOGI(TAG, "Player resources released.");
+        return;
+    }
+    
+    /* Close storage */
+    if (player_ctx.file.sub_src) {
+        media_src_storage_close(&player_ctx.file);
+        player_ctx.file.sub_src = NULL;
+    }
+    
+    if (player_ctx.in_buff) {
+        heap_caps_free(player_ctx.in_buff);
+        player_ctx.in_buff = NULL;
+    }
+    lvgl_port_lock(0);
+    lv_canvas_set_buffer(player_ctx.canvas, NULL, 0, 0, LV_COLOR_FORMAT_RGB565);
+    for (int i = 0; i < FRAME_MAILBOX_SLOTS; i++) {
+        if (player_ctx.frames[i].buff) {
+            heap_caps_free(player_ctx.frames[i].buff);
+        }
+        player_ctx.frames[i].buff = NULL;
+        player_ctx.frames[i].buff_size = 0;
+    }
+    lvgl_port_unlock();
+    frame_index_free(&player_ctx.index);
+    dirty_tiles_deinit(&player_ctx.tiles);
+    video_mem_update();
+    ESP_LOGI(TAG, "Player resources released.");
+}
+
+/* Move behind the frame which was read */
+static void video_advance(int frame_size)
+{
+    if (player_ctx.frame_exact) {
+        frame_index_add(&player_ctx.index, player_ctx.frame, player_ctx.position, frame_size);
+    }
+    if (player_ctx.speed == 1 && !player_ctx.container) {
+        player_ctx.position += frame_size;
+        player_ctx.frame++;
+    } else {
+        video_step();
+    }
+    media_src_storage_seek(&player_ctx.file, player_ctx.position);
+}
+
+/* Skip decoding of the frame, presentation time moves as if it was shown */
+static void video_skip(int frame_size)
+{
+    PLAYER_TRACE_INSTANT("skipped frame");
+    player_ctx.stats.skipped++;
+    if (player_ctx.fps && player_ctx.present_time) {
+        player_ctx.present_time += 1000000 / player_ctx.fps;
+    }
+    video_advance(frame_size);
+}
+
+/* Compare fingerprint of the read frame with the shown one, it is the shown one after this call */
+static bool video_repeated(int frame_size)
+{
+    /* Frames of the cache are decoded only once, frame in pause is decoded to be shown */
+    if (!player_ctx.skip_repeated || player_ctx.cache.frames || player_ctx.state != PLAYER_STATE_PLAYING) {
+        player_ctx.repeat_valid = false;
+        return false;
+    }
+    
+    /* Encoded frame is hashed before the viewport crop changes it */
+    PLAYER_TRACE_BEGIN("hash");
+    const uint64_t hash = frame_hash(player_ctx.in_buff, frame_size);
+    PLAYER_TRACE_END("hash");
+    
+    /* Frame with another caption is different */
+    int cue = -1;
+    if (player_ctx.overlay_lock) {
+        xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+        cue = video_caption_cue(player_ctx.frame, NULL);
+        xSemaphoreGive(player_ctx.overlay_lock);
+    }
+    
+    const bool repeated = (player_ctx.repeat_valid && player_ctx.repeat_hash == hash && player_ctx.repeat_size == frame_size &&
+                           player_ctx.repeat_cue == cue);
+    player_ctx.repeat_hash = hash;
+    player_ctx.repeat_size = frame_size;
+    player_ctx.repeat_cue = cue;
+    player_ctx.repeat_valid = true;
+    return repeated;
+}
+
+/* Frame is not decoded and not handed over to LVGL, it waits for its presentation time as if it was shown */
+static void video_repeat(int frame_size)
+{
+    PLAYER_TRACE_INSTANT("repeated frame");
+    player_ctx.stats.repeated++;
+    player_ctx.decoded_frame = player_ctx.frame;
+    video_advance(frame_size);
+    video_wait_present();
+}
+
+/* Hand the decoded frame over to LVGL task at its presentation time */
+static void video_publish(player_frame_t *frame)
+{
+    /* Find changed parts of the frame */
+    frame->areas_count = -1;
+    if (player_ctx.dirty_regions && player_ctx.tiles.signatures) {
+        if (player_ctx.tiles.width != frame->width || player_ctx.tiles.height != frame->height) {
+            /* Viewport changed, tiles are prepared for the shown area */
+            dirty_tiles_init(&player_ctx.tiles, frame->width, frame->height);
+        }
+        if (player_ctx.tiles.width == frame->width && player_ctx.tiles.height == frame->height) {
+            frame->areas_count = dirty_tiles_update(&player_ctx.tiles, frame->data + frame->offset, frame->stride, frame->areas);
+        }
+    }
+    frame->progress = ((float)player_ctx.position/(float)player_ctx.filesize)*1000;
+    frame->seq = ++player_ctx.frame_seq;
+    
+    /* Every displayed frame has the same presentation time, also in trick-play */
+    int64_t wait_start = esp_timer_get_time();
+    PLAYER_TRACE_BEGIN("wait present");
+    video_wait_present();
+    PLAYER_TRACE_END("wait present");
+    frame->publish_time = esp_timer_get_time();
+    player_stats_add(&player_ctx.stats, PLAYER_STAT_WAIT, frame->publish_time - wait_start);
+    
+    /* Hand the frame over to LVGL task, LVGL lock is not needed */
+    frame_mailbox_publish(&player_ctx.mailbox);
+    PLAYER_TRACE_INSTANT("publish");
+}
+
+static void video_play(void)
+{
+    esp_err_t ret = ESP_OK;
+    int frame_size = 0;
+    int processed = 0;
+    player_frame_t *frame;
+    jpeg_roi_rect_t region;
+    uint32_t decode_size;
+    int64_t work_start = 0;
+    bool show_frame = false;
+    bool first_frame = true;
+    
+    ESP_GOTO_ON_ERROR(video_open(), err, TAG, "Open video failed");
+    
+    lvgl_port_lock(0);
+	/* Set buffer to LVGL canvas, it has the true width of the video and the stride of the decoder */
+    video_canvas_init(player_ctx.frames[frame_mailbox_front(&player_ctx.mailbox)].buff, player_ctx.video_width, player_ctx.video_height, video_stride(player_ctx.video_width));
     
     if (player_ctx.auto_width || player_ctx.auto_height) {
-        uint32_t h = (player_ctx.auto_height ? (height+120) : lv_obj_get_height(player_ctx.main));
-        uint32_t w = (player_ctx.auto_width ? width : lv_obj_get_width(player_ctx.main));
+        uint32_t h = (player_ctx.auto_height ? (player_ctx.video_height+120) : lv_obj_get_height(player_ctx.main));
+        uint32_t w = (player_ctx.auto_width ? player_ctx.video_width : lv_obj_get_width(player_ctx.main));
         lv_obj_set_size(player_ctx.main, w, h);
     }
     
@@ -344,28 +2179,121 @@ static void show_video_task(void *arg)
     lv_slider_set_range(player_ctx.slider, 0, 1000);
     lvgl_port_unlock();
 
+    /* First frame, container files do not start with it */
+    video_seek_target(PLAYER_SEEK_FRAME, 0);
+    player_stats_reset(&player_ctx.stats);
+    frame_skip_reset(&player_ctx.skip);
+    player_ctx.skip_run = 0;
+    player_ctx.repeat_valid = false;
+    player_ctx.seek_pending = false;
+    player_ctx.present_time = 0;
     player_ctx.state = PLAYER_STATE_PLAYING;
     
     ESP_LOGI(TAG, "Video player initialized");
    
-    media_src_storage_seek(&player_ctx.file, 0);
+    media_src_storage_seek(&player_ctx.file, player_ctx.position);
+    
+    /* Next file of the playlist is prepared in background */
+    preroll_start();
+    
     while(player_ctx.state != PLAYER_STATE_STOPPED)
     {
-        if (player_ctx.state == PLAYER_STATE_PAUSED) {		 
+        /* Seek is processed before reading, so rapid requests are coalesced into the latest one */
+        if (video_process_seek()) {
+            show_frame = true;
+            player_ctx.present_time = 0;
+            work_start = 0;
+            dirty_tiles_reset(&player_ctx.tiles);
+            player_ctx.repeat_valid = false;
+        }
+        
+        /* Viewport change is shown also in pause, the last frame is decoded again */
+        if (video_process_viewport() && player_ctx.state == PLAYER_STATE_PAUSED && !show_frame && player_ctx.frame_exact) {
+            video_seek_target(PLAYER_SEEK_FRAME, player_ctx.decoded_frame);
+            media_src_storage_seek(&player_ctx.file, player_ctx.position);
+            show_frame = true;
+        }
+        
+        if (player_ctx.state == PLAYER_STATE_PAUSED && !show_frame) {
             lvgl_port_lock(0);
             lv_obj_remove_flag(player_ctx.img_pause, LV_OBJ_FLAG_HIDDEN);
             lvgl_port_unlock();
-            vTaskDelay(pdMS_TO_TICKS(500));
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+            player_ctx.present_time = 0;
+            work_start = 0;
             continue;
         }
+        show_frame = false;
         
-        read_size = media_src_storage_read(&player_ctx.file, player_ctx.in_buff, player_ctx.in_buff_size);
-        if (read_size <= 0) {
+        /* Overlays and captions are blended into cached frames, they are decoded again after change */
+        if (player_ctx.cache_flush) {
+            player_ctx.cache_flush = false;
+            player_ctx.repeat_valid = false;
+            if (player_ctx.cache.frames) {
+                video_cache_free();
+                video_cache_create();
+            }
+        }
+        
+        /* Cached frame is only handed over to LVGL, reading and decoding are skipped */
+        frame = video_back_frame();
+        frame->data = (player_ctx.frame_exact ? frame_cache_get(&player_ctx.cache, player_ctx.frame) : NULL);
+        region.x = 0;
+        region.y = 0;
+        region.width = player_ctx.video_width;
+        region.height = player_ctx.video_height;
+        if (frame->data) {
+            PLAYER_TRACE_INSTANT("cached frame");
+            player_ctx.stats.cached++;
+            video_frame_area(frame, &region);
+            video_frame_span(frame, 0);
+            player_ctx.decoded_frame = player_ctx.frame;
+            video_step();
+            media_src_storage_seek(&player_ctx.file, player_ctx.position);
+            video_publish(frame);
+            work_start = 0;
+            if (player_ctx.fps == 0) {
+                /* Nothing blocks without frame rate, other tasks get at least one tick */
+                vTaskDelay(1);
+            }
+            continue;
+        }
+        frame->data = frame->buff;
+        if (work_start == 0) {
+            work_start = esp_timer_get_time();
+        }
+        
+        /* Under load only every skip step frame is decoded, skipped frames keep the speed of the video */
+        bool skip = (player_ctx.state == PLAYER_STATE_PLAYING && ++player_ctx.skip_run < frame_skip_step(&player_ctx.skip));
+        if (skip && player_ctx.container && player_ctx.frame < player_ctx.index.count) {
+            /* Span of the frame is in the container index, so the frame is not even read */
+            video_skip(0);
+            continue;
+        }
+        
+        PLAYER_TRACE_BEGIN("read frame");
+        frame_size = video_read_frame();
+        PLAYER_TRACE_END("read frame");
+        if (frame_size <= 0) {
             ESP_LOGI(TAG, "Playing finished.");
+            /* Fixed index of the arena can be full before the end */
+            if (player_ctx.frame_exact && player_ctx.frame == player_ctx.index.count) {
+                player_ctx.index.complete = true;
+            }
+            /* All frames of the video are in the frame cache now */
+            video_mem_update();
             if (player_ctx.loop) {
                 ESP_LOGI(TAG, "Playing loop enabled. Play again...");
-                media_src_storage_seek(&player_ctx.file, 0);
-                all_size = 0;
+                video_seek_target(PLAYER_SEEK_FRAME, 0);
+                media_src_storage_seek(&player_ctx.file, player_ctx.position);
+                continue;
+            } else if (player_ctx.preroll.started) {
+                video_cache_free();
+                if (preroll_switch() != ESP_OK) {
+                    esp_lvgl_simple_player_stop();
+                }
+                frame_skip_reset(&player_ctx.skip);
+                work_start = 0;
                 continue;
             } else {
                 esp_lvgl_simple_player_stop();
@@ -373,29 +2301,116 @@ static void show_video_task(void *arg)
             }
         }
         
-        /* Decode one frame */
-        processed = video_decoder_decode();
+        if (skip) {
+            video_skip(frame_size);
+            continue;
+        }
+        player_ctx.skip_run = 0;
+        
+        /* Frame identical to the shown one keeps its presentation time, LVGL keeps the shown frame */
+        if (video_repeated(frame_size)) {
+            video_repeat(frame_size);
+            work_start = esp_timer_get_time();
+            continue;
+        }
+        
+        /* Decode one frame, frames of short videos are decoded directly to the cache */
+        frame->data = video_cache_slot();
+        uint32_t data_size = player_ctx.cache.frame_size;
+        if (frame->data == NULL) {
+            frame->data = frame->buff;
+            data_size = frame->buff_size;
+        }
+        int64_t decode_start = esp_timer_get_time();
+        PLAYER_TRACE_BEGIN("decode");
+        
+        /* Only restart intervals covering the viewport are decoded, frames of the cache are decoded whole */
+        jpeg_roi_rect_t view;
+        decode_size = frame_size;
+        if (frame->data == frame->buff && video_viewport(&view) &&
+            jpeg_roi_crop(player_ctx.in_buff, frame_size, &view, &region, &decode_size) != ESP_OK) {
+            /* No suitable restart markers, whole frame is decoded and only its part is shown */
+            region.x = 0;
+            region.y = 0;
+            region.width = player_ctx.video_width;
+            region.height = player_ctx.video_height;
+            decode_size = frame_size;
+        }
+        video_frame_area(frame, &region);
+        processed = video_decoder_decode(decode_size, frame->data, data_size);
+        PLAYER_TRACE_END("decode");
+        if (processed <= 0 && frame->data != frame->buff) {
+            frame_cache_drop(&player_ctx.cache, player_ctx.frame);
+            frame->data = frame->buff;
+        }
+        if (processed == 0) {
+            /* Decoding started too late, the frame is dropped like a skipped one */
+            PLAYER_TRACE_INSTANT("late frame");
+            player_ctx.stats.skipped++;
+            if (player_ctx.fps) {
+                player_ctx.present_time += 1000000 / player_ctx.fps;
+            }
+        }
+        if (processed <= 0) {
+            /* Previous frame stays shown */
+            player_ctx.repeat_valid = false;
+        }
+        if (processed > 0) {
+            player_stats_add(&player_ctx.stats, PLAYER_STAT_DECODE, esp_timer_get_time() - decode_start);
+            player_stats_add(&player_ctx.stats, PLAYER_STAT_FRAME_SIZE, frame_size);
+            player_ctx.stats.decoded++;
+        }
         
         /* Move in video file */
-        if(processed > 0)
-        {  
-            all_size += processed;
-            media_src_storage_seek(&player_ctx.file, all_size);
+        player_ctx.decoded_frame = player_ctx.frame;
+        video_frame_span(frame, frame_size);
+        video_advance(frame_size);
+        
+        if (processed <= 0) {
+            continue;
         }
+        video_overlays_blend(frame->data, frame->stride, &region, frame->number);
         
-        lvgl_port_lock(0);
-        /* Refresh video canvas object */
-        lv_obj_invalidate(player_ctx.canvas);
-        /* Set slider */
-        lv_slider_set_value(player_ctx.slider, ((float)all_size/(float)player_ctx.filesize)*1000, LV_ANIM_ON);
-        lvgl_port_unlock();
+        /* Time of the frame from the end of the previous one, incl. reading of skipped frames and preemption by LVGL */
+        if (player_ctx.adaptive_skip && player_ctx.fps > 0 &&
+            frame_skip_update(&player_ctx.skip, esp_timer_get_time() - work_start, 1000000 / player_ctx.fps)) {
+            ESP_LOGI(TAG, "Decoding every %ld. frame", frame_skip_step(&player_ctx.skip));
+            player_ctx.stats.skip_changes++;
+        }
+        player_ctx.stats.skip_step = frame_skip_step(&player_ctx.skip);
+        video_publish(frame);
+        work_start = esp_timer_get_time();
+        
+        if (first_frame) {
+            first_frame = false;
+            player_ctx.first_frame_time = (uint32_t)(esp_timer_get_time() - player_ctx.play_time);
+            ESP_LOGI(TAG, "Time to first frame: %ld us", player_ctx.first_frame_time);
+        }
     }
     
 
 err:    
+    if (ret != ESP_OK) {
+        esp_lvgl_simple_player_stop();
+    }
+    
+    /* Cached frames are kept only while playing */
+    video_cache_free();
+    
+    /* Stop preroll, prerolled file is opened again with the next play */
+    if (preroll_wait() == ESP_OK) {
+        media_src_storage_disconnect(&player_ctx.preroll.file);
+    }
+    
     lvgl_port_lock(0);
-    /* Show black on screen */
-    memset(player_ctx.out_buff, 0, player_ctx.out_buff_size);
+    /* Drop not shown frame and show black on screen */
+    frame_mailbox_reset(&player_ctx.mailbox, frame_mailbox_front(&player_ctx.mailbox));
+    player_ctx.shown_seq = player_ctx.frame_seq;
+    frame = &player_ctx.frames[frame_mailbox_front(&player_ctx.mailbox)];
+    if (frame->buff) {
+        memset(frame->buff, 0, frame->buff_size);
+    }
+    frame->file = NULL;
     if (player_ctx.auto_height) {
         lv_obj_set_height(player_ctx.main, 320);
     }
@@ -404,23 +2419,63 @@ err:
     lv_slider_set_value(player_ctx.slider, 0, LV_ANIM_ON);
     lvgl_port_unlock();
     
-    /* Close storage */
-    media_src_storage_disconnect(&player_ctx.file);
-    media_src_storage_close(&player_ctx.file);
-    
-    /* Deinit video decoder */
-    video_decoder_deinit();
-    
-    if (player_ctx.in_buff) {
-        heap_caps_free(player_ctx.in_buff);
-        player_ctx.in_buff = NULL;
+    /* Close file, storage is kept for the next play */
+    if (player_ctx.file.sub_src) {
+        media_src_storage_disconnect(&player_ctx.file);
+    }
+}
+
+/* Memory pressure policy, resources are released after stop when free memory is low */
+static bool video_release_needed(void)
+{
+    /* Memory of the arena is kept for the next play */
+    if (player_ctx.release_free_mem == 0 || video_arena_used()) {
+        return false;
     }
-    if (player_ctx.out_buff) {
-        heap_caps_free(player_ctx.out_buff);
-        player_ctx.out_buff = NULL;
-        player_ctx.out_buff_size = 0;
+    return (heap_caps_get_free_size(MALLOC_CAP_8BIT) < player_ctx.release_free_mem);
+}
+
+/* Wake up video task, returns false when it does not run */
+static bool video_task_notify(void)
+{
+    xSemaphoreTake(player_ctx.task_lock, portMAX_DELAY);
+    const bool running = (player_ctx.task != NULL);
+    if (running) {
+        xTaskNotifyGive(player_ctx.task);
     }
+    xSemaphoreGive(player_ctx.task_lock);
+    return running;
+}
 
+static void show_video_task(void *arg)
+{
+    while (true) {
+        /* Released task exits, unless play was requested during release */
+        if (player_ctx.release_request) {
+            video_release();
+            xSemaphoreTake(player_ctx.task_lock, portMAX_DELAY);
+            player_ctx.release_request = false;
+            if (!player_ctx.play_request) {
+                player_ctx.task = NULL;
+                xSemaphoreGive(player_ctx.task_lock);
+                break;
+            }
+            xSemaphoreGive(player_ctx.task_lock);
+        }
+        if (!player_ctx.play_request) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        player_ctx.play_request = false;
+    
+        video_play();
+    
+        if (video_release_needed()) {
+            ESP_LOGI(TAG, "Low memory, releasing player resources.");
+            video_release();
+        }
+    }
+    
     /* Close task */
     vTaskDelete( NULL );
 }
@@ -432,7 +2487,7 @@ lv_obj_t * esp_lvgl_simple_player_create(esp_lvgl_simple_player_cfg_t * params)
     ESP_RETURN_ON_FALSE(params->buff_size, NULL, TAG, "Size of the video frame buffer must be filled");
     ESP_RETURN_ON_FALSE(params->screen_width > 0 && params->screen_height > 0, NULL, TAG, "Object size must be filled");
     
-    player_ctx.file_path = params->file;
+    player_ctx.single_file = params->file;
     player_ctx.in_buff_size = params->buff_size;
     player_ctx.screen_width = params->screen_width;
     player_ctx.screen_height = params->screen_height;
@@ -441,9 +2496,50 @@ lv_obj_t * esp_lvgl_simple_player_create(esp_lvgl_simple_player_cfg_t * params)
     player_ctx.hide_status = params->flags.hide_status;
     player_ctx.auto_width = params->flags.auto_width;
     player_ctx.auto_height = params->flags.auto_height;
+    player_ctx.seek_enabled = params->flags.seek_enabled;
+    player_ctx.scrub_preview = params->flags.scrub_preview;
+    player_ctx.dirty_regions = params->flags.dirty_regions;
+    player_ctx.adaptive_skip = params->flags.adaptive_skip;
+    player_ctx.skip_repeated = params->flags.skip_repeated;
+    player_ctx.cfg_fps = params->fps;
+    player_ctx.fps = params->fps;
+    player_ctx.speed = 1;
+    player_ctx.release_free_mem = params->release_free_mem;
+    player_ctx.cache_budget = params->frame_cache_size;
+    player_ctx.placement[PLAYER_MEM_CLASS_STORAGE] = params->placement.storage;
+    player_ctx.placement[PLAYER_MEM_CLASS_ENCODED] = params->placement.encoded;
+    player_ctx.placement[PLAYER_MEM_CLASS_DECODED] = params->placement.decoded;
+    
+    /* All buffers for videos up to the maximum size are reserved now, playing does not use heap */
+    if (params->arena.max_width > 0 && params->arena.max_height > 0) {
+        player_ctx.arena_width = params->arena.max_width;
+        player_ctx.arena_height = params->arena.max_height;
+        player_ctx.arena_frames = (params->arena.max_frames ? params->arena.max_frames : PLAYER_ARENA_FRAMES);
+        if (params->arena.caption_font) {
+            /* Default width of captions, lines of the font */
+            player_ctx.caption_width = params->arena.max_width * 9 / 10;
+            player_ctx.caption_height = PLAYER_CAPTION_LINES * lv_font_get_line_height(params->arena.caption_font) + 2 * PLAYER_CAPTION_PAD;
+        }
+        for (int i = 0; i < PLAYER_MEM_CLASS_MAX; i++) {
+            player_arena_set_placement(&player_ctx.arena, i, &player_ctx.placement[i]);
+        }
+        video_arena_layout();
+        ESP_RETURN_ON_FALSE(player_arena_reserve(&player_ctx.arena) == ESP_OK, NULL, TAG, "Not enough memory for player arena");
+        video_arena_layout();
+        ESP_LOGI(TAG, "Player memory reserved: %ld bytes", player_arena_size(&player_ctx.arena));
+    }
+    player_ctx.task_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(player_ctx.task_lock, NULL, TAG, "Create mutex failed");
+    player_ctx.overlay_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(player_ctx.overlay_lock, NULL, TAG, "Create mutex failed");
+    for (int i = 0; i < PLAYER_CAPTIONS; i++) {
+        player_ctx.captions[i].cue = -1;
+    }
+    player_ctx.decode_priority = (params->flags.background ? JPEG_DEC_PRIORITY_BACKGROUND : JPEG_DEC_PRIORITY_FOREGROUND);
     
     /* Create LVGL objects */
     lv_obj_t * player_screen = create_lvgl_objects(params->screen);
+    esp_lvgl_simple_player_show_stats(params->flags.show_stats);
     
     /* Default player state */
     esp_lvgl_simple_player_stop();
@@ -470,15 +2566,26 @@ void esp_lvgl_simple_player_change_file(char *file)
     if (player_ctx.state != PLAYER_STATE_STOPPED) {
         ESP_LOGW(TAG, "Playing file can be changed only when video is stopped.");
     }
-    player_ctx.file_path = file;
+    player_ctx.single_file = file;
 }
 
 void esp_lvgl_simple_player_play(void)
 {
     if (player_ctx.state == PLAYER_STATE_STOPPED) {
         ESP_LOGI(TAG, "Player starting playing.");
-        /* Create video task */
-        xTaskCreate(show_video_task, "video task", 4096, NULL, 4, NULL);
+        player_ctx.play_time = esp_timer_get_time();
+        player_ctx.play_request = true;
+        xSemaphoreTake(player_ctx.task_lock, portMAX_DELAY);
+        if (player_ctx.task == NULL) {
+            /* Create video task */
+            if (xTaskCreate(show_video_task, "video task", 4096, NULL, 4, &player_ctx.task) != pdPASS) {
+                ESP_LOGE(TAG, "Create video task failed");
+                player_ctx.play_request = false;
+            }
+        } else {
+            xTaskNotifyGive(player_ctx.task);
+        }
+        xSemaphoreGive(player_ctx.task_lock);
     } else if(player_ctx.state == PLAYER_STATE_PAUSED) {
         esp_lvgl_simple_player_pause();
     }
@@ -523,4 +2630,381 @@ void esp_lvgl_simple_player_repeat(bool repeat)
 {
     ESP_LOGI(TAG, "Player repeat %s.", (repeat ? "enabled" : "disabled"));
     player_ctx.loop = repeat;
-}
\ No newline at end of file
+}
+
+esp_err_t esp_lvgl_simple_player_seek(player_seek_t mode, uint32_t value)
+{
+    ESP_RETURN_ON_FALSE(player_ctx.state != PLAYER_STATE_STOPPED, ESP_ERR_INVALID_STATE, TAG, "Seek is possible only when playing or paused");
+    ESP_RETURN_ON_FALSE(mode != PLAYER_SEEK_TIME_MS || player_ctx.fps > 0, ESP_ERR_NOT_SUPPORTED, TAG, "Seek by time needs known frame rate");
+    
+    portENTER_CRITICAL(&player_ctx.seek_lock);
+    player_ctx.seek_mode = mode;
+    player_ctx.seek_value = value;
+    player_ctx.seek_pending = true;
+    portEXIT_CRITICAL(&player_ctx.seek_lock);
+    
+    /* Wake up paused video task, it can exit after the end of video */
+    ESP_RETURN_ON_FALSE(video_task_notify(), ESP_ERR_INVALID_STATE, TAG, "Seek is possible only when playing or paused");
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_set_speed(int speed)
+{
+    ESP_RETURN_ON_FALSE(speed != 0 && speed >= -PLAYER_SPEED_MAX && speed <= PLAYER_SPEED_MAX, ESP_ERR_INVALID_ARG, TAG, "Invalid speed");
+    
+    ESP_LOGI(TAG, "Player speed %dx.", speed);
+    player_ctx.speed = speed;
+    return ESP_OK;
+}
+
+int esp_lvgl_simple_player_get_speed(void)
+{
+    return player_ctx.speed;
+}
+
+esp_err_t esp_lvgl_simple_player_playlist_add(const char *file)
+{
+    ESP_RETURN_ON_FALSE(file, ESP_ERR_INVALID_ARG, TAG, "File path must be filled");
+    ESP_RETURN_ON_FALSE(player_ctx.state == PLAYER_STATE_STOPPED, ESP_ERR_INVALID_STATE, TAG, "Playlist can be changed only when video is stopped");
+    
+    char **playlist = realloc(player_ctx.playlist, (player_ctx.playlist_count + 1) * sizeof(char *));
+    ESP_RETURN_ON_FALSE(playlist, ESP_ERR_NO_MEM, TAG, "Allocation playlist failed");
+    player_ctx.playlist = playlist;
+    player_ctx.playlist[player_ctx.playlist_count] = strdup(file);
+    ESP_RETURN_ON_FALSE(player_ctx.playlist[player_ctx.playlist_count], ESP_ERR_NO_MEM, TAG, "Allocation playlist failed");
+    player_ctx.playlist_count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_playlist_clear(void)
+{
+    ESP_RETURN_ON_FALSE(player_ctx.state == PLAYER_STATE_STOPPED, ESP_ERR_INVALID_STATE, TAG, "Playlist can be changed only when video is stopped");
+    
+    for (uint32_t i = 0; i < player_ctx.playlist_count; i++) {
+        free(player_ctx.playlist[i]);
+    }
+    free(player_ctx.playlist);
+    player_ctx.playlist = NULL;
+    player_ctx.playlist_count = 0;
+    player_ctx.playlist_current = 0;
+    return ESP_OK;
+}
+
+void esp_lvgl_simple_player_playlist_loop(bool loop)
+{
+    ESP_LOGI(TAG, "Playlist loop %s.", (loop ? "enabled" : "disabled"));
+    player_ctx.playlist_loop = loop;
+}
+
+void esp_lvgl_simple_player_playlist_shuffle(bool shuffle)
+{
+    ESP_LOGI(TAG, "Playlist shuffle %s.", (shuffle ? "enabled" : "disabled"));
+    player_ctx.playlist_shuffle = shuffle;
+}
+
+esp_err_t esp_lvgl_simple_player_get_stats(esp_lvgl_simple_player_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    player_stats_get(&player_ctx.stats, stats);
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_snapshot(const esp_lvgl_simple_player_snapshot_cfg_t *cfg, esp_lvgl_simple_player_snapshot_t *snapshot)
+{
+    esp_err_t ret = ESP_OK;
+    char path[PLAYER_PATH_MAX] = {0};
+    uint8_t *raw = NULL;
+    uint8_t *jpeg = NULL;
+    esp_lvgl_simple_player_snapshot_t info = {0};
+    uint32_t jpeg_offset = 0;
+    FILE *f = NULL;
+    media_src_t src = {0};
+    bool snapshot_storage = false;
+    ESP_RETURN_ON_FALSE(cfg, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(!video_arena_used() || ((cfg->jpeg_file == NULL || cfg->jpeg_buff) && (cfg->raw_file == NULL || cfg->raw_buff)),
+                        ESP_ERR_INVALID_ARG, TAG, "Files of arena player are written from buffers of the caller");
+    
+    /* Shown frame does not change while LVGL is locked */
+    lvgl_port_lock(0);
+    const player_frame_t *frame = &player_ctx.frames[frame_mailbox_front(&player_ctx.mailbox)];
+    if (player_ctx.state == PLAYER_STATE_STOPPED || frame->file == NULL) {
+        lvgl_port_unlock();
+        ESP_LOGW(TAG, "No frame is shown");
+        return ESP_ERR_INVALID_STATE;
+    }
+    snprintf(path, sizeof(path), "%s", frame->file);
+    info.frame = frame->number;
+    info.jpeg_size = frame->jpeg_size;
+    info.width = frame->width;
+    info.height = frame->height;
+    jpeg_offset = frame->jpeg_offset;
+    const uint32_t raw_size = info.width * info.height * 2;
+    if (cfg->raw_buff && cfg->raw_buff_size >= raw_size) {
+        raw = cfg->raw_buff;
+    } else if (cfg->raw_file && cfg->raw_buff == NULL) {
+        PLAYER_HEAP_CHECK();
+        raw = heap_caps_malloc(raw_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (raw == NULL) {
+            raw = heap_caps_malloc(raw_size, MALLOC_CAP_8BIT);
+        }
+    }
+    if (raw) {
+        for (uint32_t y = 0; y < info.height; y++) {
+            memcpy(raw + y * info.width * 2, frame->data + frame->offset + y * frame->stride, info.width * 2);
+        }
+    }
+    lvgl_port_unlock();
+    ESP_GOTO_ON_FALSE(cfg->raw_buff == NULL || raw, ESP_ERR_INVALID_SIZE, err, TAG, "Raw buffer is too small (%ld bytes needed)", raw_size);
+    ESP_GOTO_ON_FALSE(cfg->raw_file == NULL || raw, ESP_ERR_NO_MEM, err, TAG, "Not enough memory for raw frame");
+    
+    /* Original JPEG is read from the file by its own storage, position of the video is not changed */
+    if (cfg->jpeg_buff || cfg->jpeg_file) {
+        ESP_GOTO_ON_FALSE(cfg->jpeg_buff == NULL || cfg->jpeg_buff_size >= info.jpeg_size, ESP_ERR_INVALID_SIZE, err, TAG,
+                          "JPEG buffer is too small (%ld bytes needed)", info.jpeg_size);
+        if (video_arena_used()) {
+            /* Storage of the arena, one snapshot reads at a time */
+            portENTER_CRITICAL(&player_ctx.seek_lock);
+            snapshot_storage = !player_ctx.snapshot_busy;
+            player_ctx.snapshot_busy = true;
+            portEXIT_CRITICAL(&player_ctx.seek_lock);
+            ESP_GOTO_ON_FALSE(snapshot_storage, ESP_ERR_INVALID_STATE, err, TAG, "Other snapshot is taken");
+            jpeg = cfg->jpeg_buff;
+            media_src_storage_open_static(&src, player_ctx.snapshot_storage);
+        } else {
+            PLAYER_HEAP_CHECK();
+            jpeg = (cfg->jpeg_buff ? cfg->jpeg_buff : malloc(info.jpeg_size));
+            ESP_GOTO_ON_FALSE(jpeg, ESP_ERR_NO_MEM, err, TAG, "Not enough memory for JPEG frame");
+            ESP_GOTO_ON_FALSE(media_src_storage_open(&src) == 0, ESP_ERR_NO_MEM, err, TAG, "Storage open failed");
+        }
+        ESP_GOTO_ON_FALSE(media_src_storage_connect(&src, path) == 0, ESP_FAIL, err, TAG, "Open of %s failed", path);
+        ESP_GOTO_ON_FALSE(media_src_storage_read_at(&src, jpeg_offset, jpeg, info.jpeg_size) == (int)info.jpeg_size, ESP_FAIL, err, TAG,
+                          "Read of JPEG frame failed");
+    }
+    if (cfg->jpeg_file) {
+        f = fopen(cfg->jpeg_file, "wb");
+        ESP_GOTO_ON_FALSE(f, ESP_FAIL, err, TAG, "Cannot create file %s", cfg->jpeg_file);
+        ESP_GOTO_ON_FALSE(fwrite(jpeg, 1, info.jpeg_size, f) == info.jpeg_size, ESP_FAIL, err, TAG, "Writing file %s failed", cfg->jpeg_file);
+        fclose(f);
+        f = NULL;
+    }
+    if (cfg->raw_file) {
+        f = fopen(cfg->raw_file, "wb");
+        ESP_GOTO_ON_FALSE(f, ESP_FAIL, err, TAG, "Cannot create file %s", cfg->raw_file);
+        ESP_GOTO_ON_FALSE(fwrite(raw, 1, raw_size, f) == raw_size, ESP_FAIL, err, TAG, "Writing file %s failed", cfg->raw_file);
+        fclose(f);
+        f = NULL;
+    }
+    ESP_LOGI(TAG, "Snapshot of frame %ld of %s (JPEG %ld bytes, %ld x %ld)", info.frame, path, info.jpeg_size, info.width, info.height);
+    if (snapshot) {
+        *snapshot = info;
+    }
+    
+err:
+    if (f) {
+        fclose(f);
+    }
+    if (src.sub_src) {
+        media_src_storage_close(&src);
+    }
+    if (snapshot_storage) {
+        portENTER_CRITICAL(&player_ctx.seek_lock);
+        player_ctx.snapshot_busy = false;
+        portEXIT_CRITICAL(&player_ctx.seek_lock);
+    }
+    if (jpeg && jpeg != cfg->jpeg_buff) {
+        free(jpeg);
+    }
+    if (raw && raw != cfg->raw_buff) {
+        heap_caps_free(raw);
+    }
+    return ret;
+}
+
+void esp_lvgl_simple_player_get_mem_report(esp_lvgl_simple_player_mem_report_t *report)
+{
+    portENTER_CRITICAL(&player_ctx.mem_lock);
+    *report = player_ctx.mem_report;
+    portEXIT_CRITICAL(&player_ctx.mem_lock);
+}
+
+void esp_lvgl_simple_player_reset_stats(void)
+{
+    player_stats_reset(&player_ctx.stats);
+}
+
+void esp_lvgl_simple_player_show_stats(bool show)
+{
+    lvgl_port_lock(0);
+    if (show) {
+        lv_obj_remove_flag(player_ctx.label_stats, LV_OBJ_FLAG_HIDDEN);
+        player_ctx.stats_time = 0;
+        lv_timer_resume(player_ctx.stats_timer);
+    } else {
+        lv_obj_add_flag(player_ctx.label_stats, LV_OBJ_FLAG_HIDDEN);
+        lv_timer_pause(player_ctx.stats_timer);
+    }
+    lvgl_port_unlock();
+}
+
+esp_err_t esp_lvgl_simple_player_overlay_add(const esp_lvgl_simple_player_overlay_cfg_t *cfg, int *id)
+{
+    overlay_layer_t layer;
+    int free_id = -1;
+    
+    ESP_RETURN_ON_FALSE(cfg && cfg->image, ESP_ERR_INVALID_ARG, TAG, "Overlay image must be filled");
+    ESP_RETURN_ON_FALSE(player_ctx.overlay_lock, ESP_ERR_INVALID_STATE, TAG, "Player is not created");
+    
+    /* Pre-composition takes time, it is done without lock */
+    ESP_RETURN_ON_ERROR(overlay_layer_init(&layer, cfg->image), TAG, "Overlay image preparation failed (RGB565, RGB565A8 or ARGB8888 is supported)");
+    
+    xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+    for (int i = 0; i < PLAYER_OVERLAYS_MAX; i++) {
+        if (!player_ctx.overlays[i].used) {
+            player_overlay_t *overlay = &player_ctx.overlays[i];
+            overlay->layer = layer;
+            overlay->align = cfg->align;
+            overlay->x_ofs = cfg->x_ofs;
+            overlay->y_ofs = cfg->y_ofs;
+            overlay->visible = true;
+            overlay->used = true;
+            free_id = i;
+            break;
+        }
+    }
+    xSemaphoreGive(player_ctx.overlay_lock);
+    
+    player_ctx.cache_flush = true;
+    if (free_id < 0) {
+        overlay_layer_deinit(&layer);
+        ESP_LOGE(TAG, "Maximum number of overlays is %d", PLAYER_OVERLAYS_MAX);
+        return ESP_ERR_NO_MEM;
+    }
+    if (id) {
+        *id = free_id;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_overlay_show(int id, bool show)
+{
+    ESP_RETURN_ON_FALSE(id >= 0 && id < PLAYER_OVERLAYS_MAX && player_ctx.overlays[id].used, ESP_ERR_INVALID_ARG, TAG, "Wrong overlay");
+    if (player_ctx.overlays[id].visible != show) {
+        player_ctx.overlays[id].visible = show;
+        player_ctx.cache_flush = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_overlay_remove(int id)
+{
+    ESP_RETURN_ON_FALSE(id >= 0 && id < PLAYER_OVERLAYS_MAX && player_ctx.overlays[id].used, ESP_ERR_INVALID_ARG, TAG, "Wrong overlay");
+    
+    xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+    overlay_layer_deinit(&player_ctx.overlays[id].layer);
+    memset(&player_ctx.overlays[id], 0, sizeof(player_overlay_t));
+    xSemaphoreGive(player_ctx.overlay_lock);
+    player_ctx.cache_flush = true;
+    return ESP_OK;
+}
+
+/* Replace subtitle track, captions of the old one are freed */
+static void subtitles_set(subtitle_track_t *track, const esp_lvgl_simple_player_subtitles_cfg_t *cfg)
+{
+    player_caption_t captions[PLAYER_CAPTIONS];
+    
+    /* Track is used in LVGL task and video task */
+    lvgl_port_lock(0);
+    xSemaphoreTake(player_ctx.overlay_lock, portMAX_DELAY);
+    subtitle_track_t old = player_ctx.subtitles;
+    player_ctx.subtitles = *track;
+    if (cfg) {
+        player_ctx.subtitles_cfg = *cfg;
+        player_ctx.subtitles_cfg.file = NULL;
+    }
+    memcpy(captions, player_ctx.captions, sizeof(captions));
+    for (int i = 0; i < PLAYER_CAPTIONS; i++) {
+        memset(&player_ctx.captions[i], 0, sizeof(player_caption_t));
+        player_ctx.captions[i].cue = -1;
+    }
+    xSemaphoreGive(player_ctx.overlay_lock);
+    if (player_ctx.subtitles.count) {
+        lv_timer_resume(player_ctx.caption_timer);
+    } else {
+        lv_timer_pause(player_ctx.caption_timer);
+    }
+    lvgl_port_unlock();
+    
+    player_ctx.cache_flush = true;
+    for (int i = 0; i < PLAYER_CAPTIONS; i++) {
+        if (captions[i].overlay.used) {
+            overlay_layer_deinit(&captions[i].overlay.layer);
+        }
+    }
+    subtitle_srt_free(&old);
+}
+
+esp_err_t esp_lvgl_simple_player_subtitles_load(const esp_lvgl_simple_player_subtitles_cfg_t *cfg)
+{
+    subtitle_track_t track;
+    
+    ESP_RETURN_ON_FALSE(cfg && cfg->file, ESP_ERR_INVALID_ARG, TAG, "Subtitles file must be filled");
+    ESP_RETURN_ON_FALSE(player_ctx.overlay_lock, ESP_ERR_INVALID_STATE, TAG, "Player is not created");
+    /* Captions would be allocated while playing */
+    ESP_RETURN_ON_FALSE(!video_arena_used() || player_ctx.caption_mem, ESP_ERR_NOT_SUPPORTED, TAG, "Arena has no memory for captions (arena.caption_font)");
+    
+    /* Parsing is done without lock */
+    ESP_RETURN_ON_ERROR(subtitle_srt_load(&track, cfg->file), TAG, "Loading subtitles %s failed", cfg->file);
+    ESP_LOGI(TAG, "Subtitles loaded: %ld cues", track.count);
+    subtitles_set(&track, cfg);
+    return ESP_OK;
+}
+
+void esp_lvgl_simple_player_subtitles_clear(void)
+{
+    subtitle_track_t track = {0};
+    
+    if (player_ctx.overlay_lock) {
+        subtitles_set(&track, NULL);
+    }
+}
+
+lv_obj_t * esp_lvgl_simple_player_get_video_obj(void)
+{
+    return player_ctx.canvas;
+}
+
+esp_err_t esp_lvgl_simple_player_set_viewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    ESP_RETURN_ON_FALSE((width == 0) == (height == 0), ESP_ERR_INVALID_ARG, TAG, "Invalid viewport");
+    
+    portENTER_CRITICAL(&player_ctx.viewport_lock);
+    player_ctx.viewport_request.x = (width ? x : 0);
+    player_ctx.viewport_request.y = (width ? y : 0);
+    player_ctx.viewport_request.width = width;
+    player_ctx.viewport_request.height = height;
+    player_ctx.viewport_pending = true;
+    portEXIT_CRITICAL(&player_ctx.viewport_lock);
+    
+    /* Wake up paused video task */
+    video_task_notify();
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_release(void)
+{
+    ESP_RETURN_ON_FALSE(player_ctx.state == PLAYER_STATE_STOPPED, ESP_ERR_INVALID_STATE, TAG, "Player resources can be released only when video is stopped");
+    
+    /* Video task releases resources under LVGL lock, so it is not waited for (caller can hold the lock) */
+    xSemaphoreTake(player_ctx.task_lock, portMAX_DELAY);
+    if (player_ctx.task) {
+        player_ctx.release_request = true;
+        xTaskNotifyGive(player_ctx.task);
+    }
+    xSemaphoreGive(player_ctx.task_lock);
+    return ESP_OK;
+}
+
+uint32_t esp_lvgl_simple_player_get_first_frame_time(void)
+{
+    return player_ctx.first_frame_time;
+}
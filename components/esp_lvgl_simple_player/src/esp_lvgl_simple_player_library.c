@@ -0,0 +1,585 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/jpeg_decode.h"
+#include "media_src_storage.h"
+#include "mjpeg_parser.h"
+#include "frame_index.h"
+#include "avi_demux.h"
+#include "slv_demux.h"
+#include "esp_lvgl_simple_player.h"
+
+#define LIBRARY_DB_MAGIC        (0x42444c4d)    /* "MLDB" */
+#define LIBRARY_DB_VERSION      (2)
+#define LIBRARY_EXTENSIONS      ".mjpeg;.avi;.slv"
+#define LIBRARY_EXT_MAX         (16)
+#define LIBRARY_WORK_BUFF_SIZE  (32 * 1024)     /* Start of the file, AVI headers must fit into it */
+#define LIBRARY_TASK_STACK      (4096)
+#define LIBRARY_TASK_PRIORITY   (1)
+#define LIBRARY_DEFAULT_FPS     (30)            /* Frame rate of raw M-JPEG files, when it is not configured */
+
+static const char *TAG = "PLAYER_LIBRARY";
+
+typedef struct {
+    char        *path;
+    uint64_t    file_size;
+    uint32_t    mtime;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    fps;
+    uint32_t    frames;
+    uint32_t    max_frame_size;
+    esp_err_t   error;      /* Result of parsing (metadata are valid with ESP_OK) */
+} library_entry_t;
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    count;
+} library_db_header_t;
+
+/* Record of the database, followed by path (without terminating zero) */
+typedef struct __attribute__((packed)) {
+    uint64_t    file_size;
+    uint32_t    mtime;
+    uint16_t    width;
+    uint16_t    height;
+    uint32_t    fps;
+    uint32_t    frames;
+    uint32_t    max_frame_size;
+    int32_t     error;
+    uint16_t    path_len;
+} library_db_record_t;
+
+/* Entries of one scan */
+typedef struct {
+    library_entry_t *entries;
+    uint32_t        count;
+    uint32_t        capacity;
+    uint32_t        parsed;     /* New or changed files */
+    uint32_t        kept;       /* Files taken from the previous scan */
+} library_list_t;
+
+typedef struct {
+    esp_lvgl_simple_player_library_cfg_t cfg;
+    char                *root;
+    char                *db_file;
+    char                *extensions;
+
+    library_entry_t     *entries;   /* Sorted by path */
+    uint32_t            count;
+    SemaphoreHandle_t   lock;
+
+    TaskHandle_t        task;
+    SemaphoreHandle_t   task_exited;
+    volatile bool       stop;
+    volatile bool       scanning;
+    char                path[PLAYER_PATH_MAX];  /* Path of the scanned directory */
+    uint8_t             *buff;
+} library_ctx_t;
+
+static library_ctx_t *library;
+
+static int library_entry_cmp(const void *a, const void *b)
+{
+    return strcmp(((const library_entry_t *)a)->path, ((const library_entry_t *)b)->path);
+}
+
+static void library_entries_free(library_entry_t *entries, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        free(entries[i].path);
+    }
+    free(entries);
+}
+
+static esp_err_t library_list_add(library_list_t *list, const library_entry_t *entry)
+{
+    if (list->count == list->capacity) {
+        uint32_t capacity = MAX(64, list->capacity * 2);
+        library_entry_t *entries = realloc(list->entries, capacity * sizeof(library_entry_t));
+        ESP_RETURN_ON_FALSE(entries, ESP_ERR_NO_MEM, TAG, "Allocation of library failed");
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+    list->entries[list->count++] = *entry;
+    return ESP_OK;
+}
+
+/* Load database, entries are sorted by path */
+static esp_err_t library_db_load(library_ctx_t *lib)
+{
+    library_db_header_t header;
+    library_list_t list = {0};
+    esp_err_t ret = ESP_OK;
+    uint8_t *data = NULL;
+    struct stat st;
+
+    if (lib->db_file == NULL || stat(lib->db_file, &st) != 0 || st.st_size < sizeof(header)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    FILE *f = fopen(lib->db_file, "rb");
+    ESP_RETURN_ON_FALSE(f, ESP_ERR_NOT_FOUND, TAG, "Cannot open database %s", lib->db_file);
+
+    /* Whole database is read at once */
+    data = malloc(st.st_size);
+    ESP_GOTO_ON_FALSE(data, ESP_ERR_NO_MEM, err, TAG, "Allocation of database failed");
+    ESP_GOTO_ON_FALSE(fread(data, 1, st.st_size, f) == st.st_size, ESP_ERR_INVALID_SIZE, err, TAG, "Read database failed");
+    memcpy(&header, data, sizeof(header));
+    ESP_GOTO_ON_FALSE(header.magic == LIBRARY_DB_MAGIC && header.version == LIBRARY_DB_VERSION, ESP_ERR_NOT_SUPPORTED, err, TAG, "Wrong database version");
+
+    uint32_t pos = sizeof(header);
+    for (uint32_t i = 0; i < header.count; i++) {
+        library_db_record_t record;
+        ESP_GOTO_ON_FALSE(pos + sizeof(record) <= st.st_size, ESP_ERR_INVALID_SIZE, err, TAG, "Truncated database");
+        memcpy(&record, data + pos, sizeof(record));
+        pos += sizeof(record);
+        ESP_GOTO_ON_FALSE(pos + record.path_len <= st.st_size && record.path_len < PLAYER_PATH_MAX, ESP_ERR_INVALID_SIZE, err, TAG, "Truncated database");
+
+        library_entry_t entry = {
+            .path = strndup((const char *)data + pos, record.path_len),
+            .file_size = record.file_size,
+            .mtime = record.mtime,
+            .width = record.width,
+            .height = record.height,
+            .fps = record.fps,
+            .frames = record.frames,
+            .max_frame_size = record.max_frame_size,
+            .error = record.error,
+        };
+        pos += record.path_len;
+        ESP_GOTO_ON_FALSE(entry.path, ESP_ERR_NO_MEM, err, TAG, "Allocation of library failed");
+        if (library_list_add(&list, &entry) != ESP_OK) {
+            free(entry.path);
+            ret = ESP_ERR_NO_MEM;
+            goto err;
+        }
+    }
+    qsort(list.entries, list.count, sizeof(library_entry_t), library_entry_cmp);
+    lib->entries = list.entries;
+    lib->count = list.count;
+    list.entries = NULL;
+    list.count = 0;
+
+err:
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Database %s is not used, all files will be parsed", lib->db_file);
+    }
+    library_entries_free(list.entries, list.count);
+    free(data);
+    fclose(f);
+    return ret;
+}
+
+/* Database is written to temporary file and renamed, so interrupted write does not destroy the previous one */
+static esp_err_t library_db_store(const library_ctx_t *lib, const library_entry_t *entries, uint32_t count)
+{
+    char tmp[PLAYER_PATH_MAX];
+    esp_err_t ret = ESP_OK;
+
+    if (lib->db_file == NULL) {
+        return ESP_OK;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.tmp", lib->db_file);
+    FILE *f = fopen(tmp, "wb");
+    ESP_RETURN_ON_FALSE(f, ESP_FAIL, TAG, "Cannot create database %s", tmp);
+
+    const library_db_header_t header = {
+        .magic = LIBRARY_DB_MAGIC,
+        .version = LIBRARY_DB_VERSION,
+        .count = count,
+    };
+    ESP_GOTO_ON_FALSE(fwrite(&header, sizeof(header), 1, f) == 1, ESP_FAIL, err, TAG, "Write database failed");
+    for (uint32_t i = 0; i < count; i++) {
+        const library_entry_t *entry = &entries[i];
+        const library_db_record_t record = {
+            .file_size = entry->file_size,
+            .mtime = entry->mtime,
+            .width = entry->width,
+            .height = entry->height,
+            .fps = entry->fps,
+            .frames = entry->frames,
+            .max_frame_size = entry->max_frame_size,
+            .error = entry->error,
+            .path_len = strlen(entry->path),
+        };
+        ESP_GOTO_ON_FALSE(fwrite(&record, sizeof(record), 1, f) == 1 && fwrite(entry->path, 1, record.path_len, f) == record.path_len,
+                          ESP_FAIL, err, TAG, "Write database failed");
+    }
+
+err:
+    if (fclose(f) != 0) {
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK) {
+        /* FAT cannot rename over existing file */
+        remove(lib->db_file);
+        ret = (rename(tmp, lib->db_file) == 0 ? ESP_OK : ESP_FAIL);
+    }
+    if (ret != ESP_OK) {
+        remove(tmp);
+    }
+    return ret;
+}
+
+/* Count frames of raw M-JPEG, the whole file is read (frames can be bigger than the work buffer) */
+static esp_err_t library_count_frames(library_ctx_t *lib, media_src_t *src, library_entry_t *entry)
+{
+    uint64_t pos = 0;
+    uint64_t frame_start = 0;
+    bool in_frame = false;
+
+    while (!lib->stop) {
+        int size = media_src_storage_read_at(src, pos, lib->buff, LIBRARY_WORK_BUFF_SIZE);
+        ESP_RETURN_ON_FALSE(size >= 0, ESP_FAIL, TAG, "Read failed");
+        int used = 0;
+        while (true) {
+            if (!in_frame) {
+                int start = mjpeg_find_frame_start(lib->buff + used, size - used);
+                if (start < 0) {
+                    break;
+                }
+                frame_start = pos + used + start;
+                in_frame = true;
+                used += start + 2;
+            } else {
+                int end = mjpeg_find_frame_end(lib->buff + used, size - used);
+                if (end < 0) {
+                    break;
+                }
+                entry->frames++;
+                entry->max_frame_size = MAX(entry->max_frame_size, (uint32_t)(pos + used + end - frame_start));
+                in_frame = false;
+                used += end;
+            }
+        }
+        if (size < LIBRARY_WORK_BUFF_SIZE) {
+            /* End of file, truncated last frame is not counted */
+            return ESP_OK;
+        }
+        /* Markers can be split between reads, last bytes are searched again */
+        pos += MAX(used, size - 2);
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+/* Metadata from headers: SLV header, AVI headers and index or the first frame and frames of raw M-JPEG */
+static esp_err_t library_parse(library_ctx_t *lib, const char *path, library_entry_t *entry)
+{
+    esp_err_t ret = ESP_OK;
+    media_src_t src = {0};
+    frame_index_t index = {0};
+
+    ESP_RETURN_ON_FALSE(media_src_storage_open(&src) == 0, ESP_ERR_NO_MEM, TAG, "Storage open failed");
+    ESP_GOTO_ON_FALSE(media_src_storage_connect(&src, (char *)path) == 0, ESP_ERR_NOT_FOUND, err, TAG, "Storage connect failed");
+    int size = media_src_storage_read(&src, lib->buff, LIBRARY_WORK_BUFF_SIZE);
+    ESP_GOTO_ON_FALSE(size >= 0, ESP_FAIL, err, TAG, "Read of %s failed", path);
+    ESP_GOTO_ON_FALSE(size > 0, ESP_ERR_INVALID_SIZE, err, TAG, "File %s is empty", path);
+
+    if (slv_demux_probe(lib->buff, size)) {
+        /* Header is enough, frame table is not read */
+        slv_header_t header;
+        memcpy(&header, lib->buff, sizeof(header));
+        entry->width = header.width;
+        entry->height = header.height;
+        entry->fps = (header.fps_den ? (header.fps_num + header.fps_den / 2) / header.fps_den : 0);
+        entry->frames = header.frame_count;
+        entry->max_frame_size = header.max_frame_size;
+    } else if (avi_demux_probe(lib->buff, size)) {
+        avi_demux_info_t info;
+        ESP_GOTO_ON_ERROR(avi_demux_open(&src, lib->buff, LIBRARY_WORK_BUFF_SIZE, &info, &index), err, TAG, "AVI file %s parsing failed", path);
+        entry->width = info.width;
+        entry->height = info.height;
+        entry->fps = info.fps;
+        entry->frames = index.count;
+        entry->max_frame_size = info.max_frame_size;
+    } else {
+        /* Raw M-JPEG has no frame rate, video size is taken from the first frame */
+        jpeg_decode_picture_info_t header;
+        int start = mjpeg_find_frame_start(lib->buff, size);
+        ESP_GOTO_ON_FALSE(start >= 0, ESP_ERR_NOT_SUPPORTED, err, TAG, "No frame in %s", path);
+        ESP_GOTO_ON_ERROR(jpeg_decoder_get_info(lib->buff + start, size - start, &header), err, TAG, "Frame of %s parsing failed", path);
+        entry->width = header.width;
+        entry->height = header.height;
+        ESP_GOTO_ON_ERROR(library_count_frames(lib, &src, entry), err, TAG, "Frames of %s not counted", path);
+    }
+
+err:
+    frame_index_free(&index);
+    media_src_storage_disconnect(&src);
+    media_src_storage_close(&src);
+    return ret;
+}
+
+/* Failure of the storage or memory can pass with the next scan, failure of the same file content cannot */
+static bool library_error_is_transient(esp_err_t error)
+{
+    return (error == ESP_FAIL || error == ESP_ERR_NO_MEM || error == ESP_ERR_NOT_FOUND || error == ESP_ERR_INVALID_STATE);
+}
+
+static bool library_is_video(const library_ctx_t *lib, const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (ext == NULL) {
+        return false;
+    }
+    const size_t len = strlen(ext);
+    for (const char *p = lib->extensions; *p; ) {
+        const char *end = strchr(p, ';');
+        const size_t ext_len = (end ? (size_t)(end - p) : strlen(p));
+        if (ext_len == len && strncasecmp(p, ext, len) == 0) {
+            return true;
+        }
+        p += ext_len + (end ? 1 : 0);
+    }
+    return false;
+}
+
+/* Add video file, unchanged files (same path, size and time of modification) take metadata from the previous scan,
+ * files which failed to parse are parsed again only when they changed or the failure was not caused by their content */
+static void library_scan_file(library_ctx_t *lib, library_list_t *list, const struct stat *st)
+{
+    library_entry_t key = {
+        .path = lib->path,
+    };
+    library_entry_t entry = {
+        .file_size = st->st_size,
+        .mtime = (uint32_t)st->st_mtime,
+    };
+
+    const library_entry_t *prev = bsearch(&key, lib->entries, lib->count, sizeof(library_entry_t), library_entry_cmp);
+    const bool unchanged = (prev && prev->file_size == entry.file_size && prev->mtime == entry.mtime);
+    if (unchanged && !library_error_is_transient(prev->error)) {
+        entry = *prev;
+        list->kept++;
+    } else {
+        entry.error = library_parse(lib, lib->path, &entry);
+        if (entry.error != ESP_OK) {
+            ESP_LOGW(TAG, "Metadata of %s not available", lib->path);
+            /* Only the failure is stored, partly parsed metadata are not used */
+            entry = (library_entry_t) {
+                .file_size = entry.file_size,
+                .mtime = entry.mtime,
+                .error = entry.error,
+            };
+        }
+        if (unchanged && entry.error == prev->error) {
+            /* Still the same failure, database is not rewritten */
+            list->kept++;
+        } else {
+            list->parsed++;
+        }
+    }
+    entry.path = strdup(lib->path);
+    if (entry.path == NULL || library_list_add(list, &entry) != ESP_OK) {
+        free(entry.path);
+    }
+}
+
+/* Scan directory in lib->path, subdirectories are scanned up to max depth */
+static void library_scan_dir(library_ctx_t *lib, library_list_t *list, uint32_t depth)
+{
+    struct stat st;
+    struct dirent *de;
+    const size_t len = strlen(lib->path);
+
+    DIR *dir = opendir(lib->path);
+    if (dir == NULL) {
+        ESP_LOGW(TAG, "Cannot open directory %s", lib->path);
+        return;
+    }
+    while (!lib->stop && (de = readdir(dir)) != NULL) {
+        /* Hidden files and directories (e.g. thumbnail cache) are skipped */
+        if (de->d_name[0] == '.') {
+            continue;
+        }
+        if (de->d_type != DT_DIR && !library_is_video(lib, de->d_name)) {
+            continue;
+        }
+        if (snprintf(lib->path + len, sizeof(lib->path) - len, "/%s", de->d_name) >= sizeof(lib->path) - len) {
+            ESP_LOGW(TAG, "Path too long %s/%s", lib->path, de->d_name);
+            lib->path[len] = '\0';
+            continue;
+        }
+        if (de->d_type == DT_DIR) {
+            if (depth < lib->cfg.max_depth) {
+                library_scan_dir(lib, list, depth + 1);
+            }
+        } else if (stat(lib->path, &st) == 0) {
+            library_scan_file(lib, list, &st);
+        }
+        lib->path[len] = '\0';
+    }
+    closedir(dir);
+}
+
+static void library_scan(library_ctx_t *lib)
+{
+    library_list_t list = {0};
+
+    const int64_t start = esp_timer_get_time();
+    snprintf(lib->path, sizeof(lib->path), "%s", lib->root);
+    library_scan_dir(lib, &list, 0);
+    if (lib->stop) {
+        library_entries_free(list.entries, list.count);
+        return;
+    }
+    qsort(list.entries, list.count, sizeof(library_entry_t), library_entry_cmp);
+
+    const bool changed = (list.parsed > 0 || list.kept != lib->count);
+    ESP_LOGI(TAG, "Library scanned in %lld ms: %ld files, %ld new or changed", (esp_timer_get_time() - start) / 1000,
+             list.count, list.parsed);
+    if (!changed) {
+        library_entries_free(list.entries, list.count);
+        return;
+    }
+
+    xSemaphoreTake(lib->lock, portMAX_DELAY);
+    library_entry_t *old = lib->entries;
+    const uint32_t old_count = lib->count;
+    lib->entries = list.entries;
+    lib->count = list.count;
+    xSemaphoreGive(lib->lock);
+    library_entries_free(old, old_count);
+
+    if (library_db_store(lib, lib->entries, lib->count) != ESP_OK) {
+        ESP_LOGW(TAG, "Database %s not stored", lib->db_file);
+    }
+    if (lib->cfg.changed_cb) {
+        lib->cfg.changed_cb(lib->cfg.user_ctx);
+    }
+}
+
+static void library_task(void *arg)
+{
+    library_ctx_t *lib = arg;
+
+    while (!lib->stop) {
+        lib->scanning = true;
+        library_scan(lib);
+        lib->scanning = false;
+        /* Wait for rescan request */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    xSemaphoreGive(lib->task_exited);
+    vTaskDelete(NULL);
+}
+
+static void library_free(library_ctx_t *lib)
+{
+    if (lib->lock) {
+        vSemaphoreDelete(lib->lock);
+    }
+    if (lib->task_exited) {
+        vSemaphoreDelete(lib->task_exited);
+    }
+    library_entries_free(lib->entries, lib->count);
+    free(lib->buff);
+    free(lib->root);
+    free(lib->db_file);
+    free(lib->extensions);
+    free(lib);
+}
+
+esp_err_t esp_lvgl_simple_player_library_open(const esp_lvgl_simple_player_library_cfg_t *cfg)
+{
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(cfg && cfg->root, ESP_ERR_INVALID_ARG, TAG, "Root directory must be filled");
+    ESP_RETURN_ON_FALSE(library == NULL, ESP_ERR_INVALID_STATE, TAG, "Library is already open");
+
+    library_ctx_t *lib = calloc(1, sizeof(library_ctx_t));
+    ESP_RETURN_ON_FALSE(lib, ESP_ERR_NO_MEM, TAG, "Allocation of library failed");
+    lib->cfg = *cfg;
+    lib->root = strdup(cfg->root);
+    lib->db_file = (cfg->db_file ? strdup(cfg->db_file) : NULL);
+    lib->extensions = strdup(cfg->extensions ? cfg->extensions : LIBRARY_EXTENSIONS);
+    lib->buff = malloc(LIBRARY_WORK_BUFF_SIZE);
+    lib->lock = xSemaphoreCreateMutex();
+    lib->task_exited = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(lib->root && lib->extensions && lib->buff && (lib->db_file || !cfg->db_file), ESP_ERR_NO_MEM, err, TAG, "Allocation of library failed");
+    ESP_GOTO_ON_FALSE(lib->lock && lib->task_exited, ESP_ERR_NO_MEM, err, TAG, "Create semaphore failed");
+
+    /* Files from the last scan are available immediately, changes are found in background */
+    if (library_db_load(lib) == ESP_OK) {
+        ESP_LOGI(TAG, "Library loaded from %s: %ld files", lib->db_file, lib->count);
+    }
+    ESP_GOTO_ON_FALSE(xTaskCreate(library_task, "library task", LIBRARY_TASK_STACK, lib, LIBRARY_TASK_PRIORITY, &lib->task) == pdPASS,
+                      ESP_ERR_NO_MEM, err, TAG, "Create library task failed");
+    library = lib;
+    return ESP_OK;
+
+err:
+    library_free(lib);
+    return ret;
+}
+
+esp_err_t esp_lvgl_simple_player_library_rescan(void)
+{
+    ESP_RETURN_ON_FALSE(library, ESP_ERR_INVALID_STATE, TAG, "Library is not open");
+    xTaskNotifyGive(library->task);
+    return ESP_OK;
+}
+
+bool esp_lvgl_simple_player_library_is_scanning(void)
+{
+    return (library && library->scanning);
+}
+
+uint32_t esp_lvgl_simple_player_library_count(void)
+{
+    return (library ? library->count : 0);
+}
+
+esp_err_t esp_lvgl_simple_player_library_get(uint32_t index, esp_lvgl_simple_player_media_info_t *info)
+{
+    esp_err_t ret = ESP_OK;
+    ESP_RETURN_ON_FALSE(info, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(library, ESP_ERR_INVALID_STATE, TAG, "Library is not open");
+
+    xSemaphoreTake(library->lock, portMAX_DELAY);
+    if (index < library->count) {
+        const library_entry_t *entry = &library->entries[index];
+        snprintf(info->path, sizeof(info->path), "%s", entry->path);
+        info->file_size = entry->file_size;
+        info->width = entry->width;
+        info->height = entry->height;
+        /* Raw M-JPEG has no frame rate, the configured one is used for it */
+        info->fps = (entry->fps || entry->frames == 0 ? entry->fps : (library->cfg.fps ? library->cfg.fps : LIBRARY_DEFAULT_FPS));
+        info->frames = entry->frames;
+        info->duration_ms = (info->fps ? (uint32_t)(((uint64_t)entry->frames * 1000) / info->fps) : 0);
+        info->max_frame_size = entry->max_frame_size;
+    } else {
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    xSemaphoreGive(library->lock);
+    return ret;
+}
+
+void esp_lvgl_simple_player_library_close(void)
+{
+    if (library == NULL) {
+        return;
+    }
+    library->stop = true;
+    xTaskNotifyGive(library->task);
+    xSemaphoreTake(library->task_exited, portMAX_DELAY);
+    library_free(library);
+    library = NULL;
+}
@@ -0,0 +1,405 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/jpeg_decode.h"
+#include "esp_lvgl_port.h"
+#include "media_src_storage.h"
+#include "jpeg_dec_service.h"
+#include "mjpeg_parser.h"
+#include "frame_index.h"
+#include "avi_demux.h"
+#include "slv_demux.h"
+#include "esp_lvgl_simple_player.h"
+
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+
+#define THUMB_POSITION_STEPS    (50)            /* Positions are rounded to steps, so near requests share cache entries */
+#define THUMB_MAGIC             (0x424d4854)    /* "THMB" */
+#define THUMB_PATH_MAX          (128)
+#define THUMB_TASK_STACK        (4096)
+#define THUMB_TASK_PRIORITY     (3)         /* Lower than video task */
+
+static const char *TAG = "PLAYER_THUMB";
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    position;
+    uint32_t    file_size;
+    uint32_t    file_mtime;
+} thumb_header_t;
+
+/* Thumbnail request of the worker */
+typedef struct {
+    esp_lvgl_simple_player_thumb_cfg_t cfg;
+    char                    file[PLAYER_PATH_MAX];
+    esp_lvgl_simple_player_thumb_cb_t cb;
+    void                    *user_ctx;
+    esp_err_t               ret;
+    uint8_t                 *data;      /* Thumbnail generated by worker, it is copied to buffer of the caller in LVGL task */
+} thumb_request_t;
+
+static char *thumb_cache_dir;
+
+/* Worker, only the latest request is pending */
+static TaskHandle_t thumb_task;
+static thumb_request_t thumb_pending;
+static bool thumb_pending_valid;
+static portMUX_TYPE thumb_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t thumb_api_mutex;
+static StaticSemaphore_t thumb_api_mutex_buf;
+
+static const jpeg_decode_cfg_t thumb_decode_cfg = {
+    .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
+    .rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR,
+};
+
+/* FNV-1a */
+static uint32_t thumb_hash(const void *data, size_t len, uint32_t hash)
+{
+    const uint8_t *p = data;
+    while (len--) {
+        hash ^= *p++;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+static void thumb_cache_path(const thumb_header_t *header, const char *file, char *path, size_t size)
+{
+    uint32_t key = thumb_hash(file, strlen(file), 2166136261);
+    key = thumb_hash(header, sizeof(thumb_header_t), key);
+    snprintf(path, size, "%s/%08lx.thm", thumb_cache_dir, (unsigned long)key);
+}
+
+static esp_err_t thumb_cache_load(const thumb_header_t *header, const char *path, uint8_t *buff)
+{
+    thumb_header_t stored;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    const size_t size = header->width * header->height * 2;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (fread(&stored, 1, sizeof(stored), f) == sizeof(stored) && memcmp(&stored, header, sizeof(stored)) == 0) {
+        if (fread(buff, 1, size, f) == size) {
+            ret = ESP_OK;
+        }
+    }
+    fclose(f);
+    return ret;
+}
+
+static void thumb_cache_store(const thumb_header_t *header, const char *path, const uint8_t *buff)
+{
+    const size_t size = header->width * header->height * 2;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Cannot create thumbnail cache file %s", path);
+        return;
+    }
+    if (fwrite(header, 1, sizeof(thumb_header_t), f) != sizeof(thumb_header_t) || fwrite(buff, 1, size, f) != size) {
+        ESP_LOGW(TAG, "Writing thumbnail cache file %s failed", path);
+        fclose(f);
+        remove(path);
+        return;
+    }
+    fclose(f);
+}
+
+/* Read the first complete frame of raw M-JPEG from byte position, returns size of the frame */
+static int thumb_read_raw_frame(media_src_t *src, uint64_t position, uint8_t *buff, uint32_t buff_size)
+{
+    media_src_storage_seek(src, position);
+    int size = media_src_storage_read(src, buff, buff_size);
+    if (size <= 0) {
+        return -1;
+    }
+    int start = mjpeg_find_frame_start(buff, size);
+    if (start < 0) {
+        return -1;
+    }
+    if (start > 0) {
+        /* Resync to SOI, so the whole frame is in the buffer */
+        media_src_storage_seek(src, position + start);
+        size = media_src_storage_read(src, buff, buff_size);
+        if (size <= 0) {
+            return -1;
+        }
+    }
+    return mjpeg_find_frame_end(buff, size);
+}
+
+/* Read frame of the container by its index, size bytes of the file start are in buff, returns size of the frame */
+static int thumb_read_container_frame(media_src_t *src, uint32_t position, uint8_t *buff, int size, uint32_t buff_size)
+{
+    frame_index_t index = {0};
+    frame_index_entry_t entry;
+    esp_err_t err;
+
+    if (slv_demux_probe(buff, size)) {
+        slv_demux_info_t slv;
+        err = slv_demux_open(src, buff, size, &slv, &index);
+    } else {
+        avi_demux_info_t avi;
+        err = avi_demux_open(src, buff, buff_size, &avi, &index);
+    }
+
+    int frame_size = -1;
+    if (err == ESP_OK && frame_index_get(&index, MIN((uint64_t)index.count * position / 1000, index.count - 1), &entry) && entry.size <= buff_size) {
+        if (media_src_storage_read_at(src, entry.offset, buff, entry.size) == (int)entry.size) {
+            frame_size = entry.size;
+        }
+    }
+    frame_index_free(&index);
+    return frame_size;
+}
+
+/* Read frame at position in per mille of the file */
+static int thumb_read_frame(media_src_t *src, uint32_t position, uint64_t file_size, uint8_t *buff, uint32_t buff_size)
+{
+    int size = media_src_storage_read(src, buff, buff_size);
+    if (size <= 0) {
+        return -1;
+    }
+    if (slv_demux_probe(buff, size) || avi_demux_probe(buff, size)) {
+        return thumb_read_container_frame(src, position, buff, size, buff_size);
+    }
+
+    int frame_size = thumb_read_raw_frame(src, (file_size * position) / 1000, buff, buff_size);
+    if (frame_size < 0 && position > 0) {
+        /* Position in the last frame, take the first one */
+        frame_size = thumb_read_raw_frame(src, 0, buff, buff_size);
+    }
+    return frame_size;
+}
+
+/* Nearest neighbour downscale of RGB565 picture */
+static void thumb_scale(const uint16_t *src, uint32_t src_w, uint32_t src_h, uint32_t src_stride,
+                        uint16_t *dst, uint32_t dst_w, uint32_t dst_h)
+{
+    for (uint32_t y = 0; y < dst_h; y++) {
+        const uint16_t *src_line = src + ((y * src_h) / dst_h) * src_stride;
+        for (uint32_t x = 0; x < dst_w; x++) {
+            *dst++ = src_line[(x * src_w) / dst_w];
+        }
+    }
+}
+
+static esp_err_t thumb_decode(const esp_lvgl_simple_player_thumb_cfg_t *cfg, uint32_t position, uint64_t file_size)
+{
+    esp_err_t ret = ESP_OK;
+    media_src_t src = {0};
+    uint8_t *in_buff = NULL;
+    uint8_t *out_buff = NULL;
+    jpeg_dec_client_handle_t jpeg = NULL;
+    size_t in_buff_size = 0;
+    size_t out_buff_size = 0;
+    jpeg_decode_picture_info_t info;
+
+    ESP_RETURN_ON_FALSE(media_src_storage_open(&src) == 0, ESP_ERR_NO_MEM, TAG, "Storage open failed");
+    ESP_GOTO_ON_FALSE(media_src_storage_connect(&src, (char *)cfg->file) == 0, ESP_ERR_NOT_FOUND, err, TAG, "Storage connect failed");
+
+    jpeg_decode_memory_alloc_cfg_t in_mem_cfg = {
+        .buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER,
+    };
+    in_buff = jpeg_alloc_decoder_mem(cfg->buff_size, &in_mem_cfg, &in_buff_size);
+    ESP_GOTO_ON_FALSE(in_buff, ESP_ERR_NO_MEM, err, TAG, "Allocation in_buff failed");
+
+    int frame_size = thumb_read_frame(&src, position, file_size, in_buff, in_buff_size);
+    ESP_GOTO_ON_FALSE(frame_size > 0, ESP_ERR_NOT_FOUND, err, TAG, "No frame found in %s", cfg->file);
+    ESP_GOTO_ON_ERROR(jpeg_decoder_get_info(in_buff, frame_size, &info), err, TAG, "Get frame info failed");
+
+    jpeg_decode_memory_alloc_cfg_t out_mem_cfg = {
+        .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
+    };
+    const uint32_t stride = ALIGN_UP(info.width, 16);
+    out_buff = jpeg_alloc_decoder_mem(stride * ALIGN_UP(info.height, 16) * 2, &out_mem_cfg, &out_buff_size);
+    ESP_GOTO_ON_FALSE(out_buff, ESP_ERR_NO_MEM, err, TAG, "Allocation out_buff failed");
+
+    ESP_GOTO_ON_ERROR(jpeg_dec_service_client_new(JPEG_DEC_PRIORITY_BACKGROUND, &jpeg), err, TAG, "JPEG decoder not available");
+    uint32_t decode_size = MIN(ALIGN_UP((uint32_t)frame_size, 16), in_buff_size);
+    int64_t deadline = esp_timer_get_time() + JPEG_DEC_DEADLINE_RELAXED_US;
+    ESP_GOTO_ON_ERROR(jpeg_dec_service_decode(jpeg, &thumb_decode_cfg, in_buff, decode_size, out_buff, out_buff_size, deadline, NULL), err, TAG, "Decode failed");
+
+    thumb_scale((uint16_t *)out_buff, info.width, info.height, stride, (uint16_t *)cfg->buff, cfg->width, cfg->height);
+
+err:
+    if (jpeg) {
+        jpeg_dec_service_client_del(jpeg);
+    }
+    if (out_buff) {
+        heap_caps_free(out_buff);
+    }
+    if (in_buff) {
+        heap_caps_free(in_buff);
+    }
+    media_src_storage_disconnect(&src);
+    media_src_storage_close(&src);
+    return ret;
+}
+
+esp_err_t esp_lvgl_simple_player_get_thumbnail(const esp_lvgl_simple_player_thumb_cfg_t *cfg)
+{
+    struct stat st;
+    char path[THUMB_PATH_MAX];
+    ESP_RETURN_ON_FALSE(cfg && cfg->file && cfg->buff && cfg->buff_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(cfg->width > 0 && cfg->height > 0, ESP_ERR_INVALID_ARG, TAG, "Thumbnail size must be filled");
+    ESP_RETURN_ON_FALSE(stat(cfg->file, &st) == 0, ESP_ERR_NOT_FOUND, TAG, "File %s not found", cfg->file);
+
+    /* Round position to step */
+    const uint32_t step = 1000 / THUMB_POSITION_STEPS;
+    const uint32_t position = ((MIN(cfg->position, 1000) + step / 2) / step) * step;
+
+    thumb_header_t header = {
+        .magic = THUMB_MAGIC,
+        .width = cfg->width,
+        .height = cfg->height,
+        .position = position,
+        .file_size = (uint32_t)st.st_size,
+        .file_mtime = (uint32_t)st.st_mtime,
+    };
+
+    if (thumb_cache_dir) {
+        thumb_cache_path(&header, cfg->file, path, sizeof(path));
+        if (thumb_cache_load(&header, path, cfg->buff) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+
+    ESP_RETURN_ON_ERROR(thumb_decode(cfg, position, st.st_size), TAG, "Thumbnail decode failed");
+
+    if (thumb_cache_dir) {
+        thumb_cache_store(&header, path, cfg->buff);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lvgl_simple_player_thumbnail_cache(const char *dir)
+{
+    free(thumb_cache_dir);
+    thumb_cache_dir = NULL;
+    if (dir == NULL) {
+        return ESP_OK;
+    }
+
+    struct stat st;
+    if (stat(dir, &st) != 0) {
+        ESP_RETURN_ON_FALSE(mkdir(dir, 0755) == 0, ESP_FAIL, TAG, "Cannot create thumbnail cache directory %s", dir);
+    }
+    thumb_cache_dir = strdup(dir);
+    ESP_RETURN_ON_FALSE(thumb_cache_dir, ESP_ERR_NO_MEM, TAG, "Allocation failed");
+    return ESP_OK;
+}
+
+/* Called in LVGL task, buffer of the caller is not drawn now */
+static void thumb_async_done(void *arg)
+{
+    thumb_request_t *req = arg;
+
+    if (req->ret == ESP_OK) {
+        memcpy(req->cfg.buff, req->data, req->cfg.width * req->cfg.height * 2);
+    }
+    req->cb(req->ret, &req->cfg, req->user_ctx);
+    free(req->data);
+    free(req);
+}
+
+static void thumb_worker_task(void *arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        thumb_request_t *req = malloc(sizeof(thumb_request_t));
+        if (req == NULL) {
+            ESP_LOGE(TAG, "Allocation of thumbnail request failed");
+            continue;
+        }
+        portENTER_CRITICAL(&thumb_lock);
+        const bool valid = thumb_pending_valid;
+        *req = thumb_pending;
+        thumb_pending_valid = false;
+        portEXIT_CRITICAL(&thumb_lock);
+        if (!valid) {
+            free(req);
+            continue;
+        }
+
+        /* Thumbnail is generated into own memory, the caller buffer may be shown by LVGL now */
+        req->cfg.file = req->file;
+        req->data = malloc(req->cfg.width * req->cfg.height * 2);
+        req->ret = ESP_ERR_NO_MEM;
+        if (req->data) {
+            uint8_t *buff = req->cfg.buff;
+            req->cfg.buff = req->data;
+            req->ret = esp_lvgl_simple_player_get_thumbnail(&req->cfg);
+            req->cfg.buff = buff;
+        }
+
+        lvgl_port_lock(0);
+        lv_result_t res = lv_async_call(thumb_async_done, req);
+        lvgl_port_unlock();
+        if (res != LV_RESULT_OK) {
+            free(req->data);
+            free(req);
+        }
+    }
+}
+
+/* Serializes creation of the worker */
+static SemaphoreHandle_t thumb_api_lock(void)
+{
+    portENTER_CRITICAL(&thumb_lock);
+    if (thumb_api_mutex == NULL) {
+        thumb_api_mutex = xSemaphoreCreateMutexStatic(&thumb_api_mutex_buf);
+    }
+    portEXIT_CRITICAL(&thumb_lock);
+    return thumb_api_mutex;
+}
+
+esp_err_t esp_lvgl_simple_player_get_thumbnail_async(const esp_lvgl_simple_player_thumb_cfg_t *cfg, esp_lvgl_simple_player_thumb_cb_t cb, void *user_ctx)
+{
+    esp_err_t ret = ESP_OK;
+    ESP_RETURN_ON_FALSE(cfg && cfg->file && cfg->buff && cfg->buff_size && cb, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(cfg->width > 0 && cfg->height > 0, ESP_ERR_INVALID_ARG, TAG, "Thumbnail size must be filled");
+    ESP_RETURN_ON_FALSE(strlen(cfg->file) < PLAYER_PATH_MAX, ESP_ERR_INVALID_ARG, TAG, "Path is too long");
+
+    SemaphoreHandle_t lock = thumb_api_lock();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (thumb_task == NULL) {
+        ESP_GOTO_ON_FALSE(xTaskCreate(thumb_worker_task, "thumb task", THUMB_TASK_STACK, NULL, THUMB_TASK_PRIORITY, &thumb_task) == pdPASS,
+                          ESP_ERR_NO_MEM, err, TAG, "Create thumbnail task failed");
+    }
+
+    /* Pending request is replaced, so only the latest one is generated */
+    portENTER_CRITICAL(&thumb_lock);
+    thumb_pending.cfg = *cfg;
+    strcpy(thumb_pending.file, cfg->file);
+    thumb_pending.cb = cb;
+    thumb_pending.user_ctx = user_ctx;
+    thumb_pending_valid = true;
+    portEXIT_CRITICAL(&thumb_lock);
+    xTaskNotifyGive(thumb_task);
+
+err:
+    xSemaphoreGive(lock);
+    return ret;
+}
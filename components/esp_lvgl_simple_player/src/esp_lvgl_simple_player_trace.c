@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_lvgl_port.h"
+#include "player_trace.h"
+#include "esp_lvgl_simple_player.h"
+
+#define TRACE_TASKS_MAX         (16)
+#define TRACE_TASK_NAME_LEN     (16)
+
+static const char *TAG = "PLAYER_TRACE";
+
+typedef struct {
+    int64_t     time;       /* esp_timer time (us) */
+    const char  *name;
+    char        phase;
+    uint8_t     core;
+    uint8_t     task;       /* Index to task table */
+} trace_event_t;
+
+typedef struct {
+    trace_event_t   *events;
+    uint32_t        size;
+    uint32_t        count;
+    uint32_t        lost;       /* Events not recorded, because buffer was full */
+    TaskHandle_t    tasks[TRACE_TASKS_MAX];
+    char            task_names[TRACE_TASKS_MAX][TRACE_TASK_NAME_LEN];
+    uint32_t        tasks_count;
+    lv_display_t    *display;
+} player_trace_t;
+
+volatile bool player_trace_on;
+
+static player_trace_t trace;
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Index of task in the table, new tasks are added (must be called in critical section) */
+static uint8_t trace_task_index(TaskHandle_t task)
+{
+    for (uint32_t i = 0; i < trace.tasks_count; i++) {
+        if (trace.tasks[i] == task) {
+            return i;
+        }
+    }
+    if (trace.tasks_count == TRACE_TASKS_MAX) {
+        /* Events of other tasks are merged to the last one */
+        return TRACE_TASKS_MAX - 1;
+    }
+    /* Name is copied, task can be deleted before dump */
+    trace.tasks[trace.tasks_count] = task;
+    strncpy(trace.task_names[trace.tasks_count], pcTaskGetName(task), TRACE_TASK_NAME_LEN - 1);
+    return trace.tasks_count++;
+}
+
+void player_trace_event(const char *name, char phase)
+{
+    int64_t now = esp_timer_get_time();
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    portENTER_CRITICAL(&trace_lock);
+    if (player_trace_on && trace.count < trace.size) {
+        trace_event_t *event = &trace.events[trace.count++];
+        event->time = now;
+        event->name = name;
+        event->phase = phase;
+        event->core = esp_cpu_get_core_id();
+        event->task = trace_task_index(task);
+    } else if (player_trace_on) {
+        trace.lost++;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+/* LVGL display phases, called in LVGL task */
+static void trace_display_event_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_REFR_START:
+        player_trace_event("lvgl refresh", 'B');
+        break;
+    case LV_EVENT_REFR_READY:
+        player_trace_event("lvgl refresh", 'E');
+        break;
+    case LV_EVENT_RENDER_START:
+        player_trace_event("lvgl render", 'B');
+        break;
+    case LV_EVENT_RENDER_READY:
+        player_trace_event("lvgl render", 'E');
+        break;
+#if LV_VERSION_CHECK(9, 2, 0)
+    case LV_EVENT_FLUSH_START:
+        player_trace_event("lvgl flush", 'B');
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+        player_trace_event("lvgl flush", 'E');
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+/* Stop recording and free the buffer, event on other core may be just writing to it */
+static void trace_free(void)
+{
+    if (trace.display) {
+        lvgl_port_lock(0);
+        lv_display_remove_event_cb_with_user_data(trace.display, trace_display_event_cb, NULL);
+        lvgl_port_unlock();
+    }
+
+    portENTER_CRITICAL(&trace_lock);
+    player_trace_on = false;
+    trace_event_t *events = trace.events;
+    memset(&trace, 0, sizeof(trace));
+    portEXIT_CRITICAL(&trace_lock);
+
+    if (events) {
+        heap_caps_free(events);
+    }
+}
+
+esp_err_t esp_lvgl_simple_player_trace_start(uint32_t max_events)
+{
+    ESP_RETURN_ON_FALSE(max_events > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    trace_free();
+
+    /* Big buffer is preferred in PSRAM */
+    const size_t size = max_events * sizeof(trace_event_t);
+    trace_event_t *events = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (events == NULL) {
+        events = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    ESP_RETURN_ON_FALSE(events, ESP_ERR_NO_MEM, TAG, "Allocation of %ld trace events failed", max_events);
+
+    lvgl_port_lock(0);
+    trace.display = lv_display_get_default();
+    if (trace.display) {
+        lv_display_add_event_cb(trace.display, trace_display_event_cb, LV_EVENT_ALL, NULL);
+    }
+    lvgl_port_unlock();
+
+    portENTER_CRITICAL(&trace_lock);
+    trace.events = events;
+    trace.size = max_events;
+    player_trace_on = true;
+    portEXIT_CRITICAL(&trace_lock);
+    ESP_LOGI(TAG, "Trace started (%ld events)", max_events);
+    return ESP_OK;
+}
+
+void esp_lvgl_simple_player_trace_stop(void)
+{
+    portENTER_CRITICAL(&trace_lock);
+    player_trace_on = false;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+esp_err_t esp_lvgl_simple_player_trace_dump(const char *path)
+{
+    ESP_RETURN_ON_FALSE(trace.events, ESP_ERR_INVALID_STATE, TAG, "Trace was not started");
+
+    /* No new events are added while writing */
+    portENTER_CRITICAL(&trace_lock);
+    player_trace_on = false;
+    portEXIT_CRITICAL(&trace_lock);
+
+    FILE *f = (path ? fopen(path, "w") : stdout);
+    ESP_RETURN_ON_FALSE(f, ESP_FAIL, TAG, "Cannot create trace file %s", path);
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"player\"}}");
+    for (uint32_t i = 0; i < trace.tasks_count; i++) {
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                (unsigned long)i, trace.task_names[i]);
+    }
+    for (uint32_t i = 0; i < trace.count; i++) {
+        const trace_event_t *event = &trace.events[i];
+        fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u,%s\"args\":{\"core\":%u}}",
+                event->name, event->phase, (long long)event->time, event->task,
+                (event->phase == 'i' ? "\"s\":\"t\"," : ""), event->core);
+    }
+    fprintf(f, "\n]}\n");
+
+    if (path) {
+        fclose(f);
+        ESP_LOGI(TAG, "Trace saved to %s (%ld events, %ld lost)", path, trace.count, trace.lost);
+    }
+    trace_free();
+    return ESP_OK;
+}
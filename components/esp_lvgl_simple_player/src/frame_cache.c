@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "frame_cache.h"
+#include "player_mem.h"
+
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+
+esp_err_t frame_cache_init(frame_cache_t *cache, uint32_t budget, uint32_t frame_size, const esp_lvgl_simple_player_mem_cfg_t *placement)
+{
+    memset(cache, 0, sizeof(frame_cache_t));
+    if (frame_size == 0 || budget < frame_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (placement) {
+        cache->placement = *placement;
+    }
+    cache->capacity = budget / frame_size;
+    cache->frame_size = frame_size;
+    cache->frames = calloc(cache->capacity, sizeof(uint8_t *));
+    if (cache->frames == NULL) {
+        cache->capacity = 0;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t frame_cache_init_static(frame_cache_t *cache, uint8_t *mem, uint32_t size, uint32_t frame_size)
+{
+    memset(cache, 0, sizeof(frame_cache_t));
+    frame_size = ALIGN_UP(frame_size, FRAME_CACHE_ALIGN);
+    uint32_t capacity = size / (frame_size + sizeof(uint8_t *));
+    while (capacity > 0 && ALIGN_UP(capacity * sizeof(uint8_t *), FRAME_CACHE_ALIGN) + capacity * frame_size > size) {
+        capacity--;
+    }
+    if (capacity == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    cache->capacity = capacity;
+    cache->frame_size = frame_size;
+    cache->mem = mem;
+    cache->frames = (uint8_t **)mem;
+    memset(cache->frames, 0, capacity * sizeof(uint8_t *));
+    return ESP_OK;
+}
+
+void frame_cache_deinit(frame_cache_t *cache)
+{
+    if (cache->mem) {
+        memset(cache, 0, sizeof(frame_cache_t));
+        return;
+    }
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        if (cache->frames[i]) {
+            heap_caps_free(cache->frames[i]);
+        }
+    }
+    free(cache->frames);
+    memset(cache, 0, sizeof(frame_cache_t));
+}
+
+uint8_t *frame_cache_get(const frame_cache_t *cache, uint32_t frame)
+{
+    return (frame < cache->capacity ? cache->frames[frame] : NULL);
+}
+
+uint8_t *frame_cache_alloc(frame_cache_t *cache, uint32_t frame)
+{
+    if (frame >= cache->capacity) {
+        return NULL;
+    }
+    if (cache->frames[frame] == NULL && cache->mem) {
+        /* Place of the frame behind the table */
+        cache->frames[frame] = cache->mem + ALIGN_UP(cache->capacity * sizeof(uint8_t *), FRAME_CACHE_ALIGN) + frame * cache->frame_size;
+        cache->count++;
+    } else if (cache->frames[frame] == NULL) {
+        /* Frames are decoded directly to the cache, so they are allocated as decoder output */
+        cache->frames[frame] = player_mem_alloc(&cache->placement, PLAYER_MEM_CLASS_DECODED, cache->frame_size, NULL);
+        if (cache->frames[frame] == NULL) {
+            return NULL;
+        }
+        cache->count++;
+    }
+    return cache->frames[frame];
+}
+
+void frame_cache_drop(frame_cache_t *cache, uint32_t frame)
+{
+    if (frame < cache->capacity && cache->frames[frame]) {
+        if (cache->mem == NULL) {
+            heap_caps_free(cache->frames[frame]);
+        }
+        cache->frames[frame] = NULL;
+        cache->count--;
+    }
+}
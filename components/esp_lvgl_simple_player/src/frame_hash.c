@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "frame_hash.h"
+
+#define FRAME_HASH_PRIME_A  (16777619u)
+#define FRAME_HASH_PRIME_B  (0x5bd1e995u)
+
+static inline uint32_t frame_hash_step(uint32_t hash, uint32_t word, uint32_t prime)
+{
+    hash ^= word;
+    return ((hash << 5) | (hash >> 27)) * prime;
+}
+
+uint64_t frame_hash(const uint8_t *data, uint32_t len)
+{
+    uint32_t a = 2166136261u;
+    uint32_t b = 0x9e3779b9u ^ len;
+    uint32_t i = 0;
+
+    /* Two independent lanes, so the loop is not limited by multiply latency */
+    for (; i + 8 <= len; i += 8) {
+        uint32_t w[2];
+        memcpy(w, data + i, sizeof(w));
+        a = frame_hash_step(a, w[0], FRAME_HASH_PRIME_A);
+        b = frame_hash_step(b, w[1], FRAME_HASH_PRIME_B);
+    }
+    for (; i < len; i++) {
+        a = frame_hash_step(a, data[i], FRAME_HASH_PRIME_A);
+    }
+    return ((uint64_t)a << 32) | b;
+}
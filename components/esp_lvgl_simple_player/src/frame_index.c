@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "frame_index.h"
+
+#define FRAME_INDEX_GROW    (1024)
+
+esp_err_t frame_index_add(frame_index_t *index, uint32_t frame, uint32_t offset, uint32_t size)
+{
+    if (frame != index->count) {
+        return ESP_OK;
+    }
+    if (index->count == index->capacity) {
+        if (index->fixed) {
+            return ESP_ERR_NO_MEM;
+        }
+        frame_index_entry_t *entries = realloc(index->entries, (index->capacity + FRAME_INDEX_GROW) * sizeof(frame_index_entry_t));
+        if (entries == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        index->entries = entries;
+        index->capacity += FRAME_INDEX_GROW;
+    }
+    index->entries[index->count].offset = offset;
+    index->entries[index->count].size = size;
+    index->count++;
+    return ESP_OK;
+}
+
+esp_err_t frame_index_reserve(frame_index_t *index, uint32_t frames)
+{
+    if (frames <= index->capacity) {
+        return ESP_OK;
+    }
+    if (index->fixed) {
+        return ESP_ERR_NO_MEM;
+    }
+    frame_index_entry_t *entries = realloc(index->entries, frames * sizeof(frame_index_entry_t));
+    if (entries == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    index->entries = entries;
+    index->capacity = frames;
+    return ESP_OK;
+}
+
+bool frame_index_get(const frame_index_t *index, uint32_t frame, frame_index_entry_t *entry)
+{
+    if (frame >= index->count) {
+        return false;
+    }
+    *entry = index->entries[frame];
+    return true;
+}
+
+bool frame_index_find(const frame_index_t *index, uint32_t offset, uint32_t *frame)
+{
+    if (index->count == 0) {
+        return false;
+    }
+    const frame_index_entry_t *last = &index->entries[index->count - 1];
+    if (offset < index->entries[0].offset || offset >= last->offset + last->size) {
+        return false;
+    }
+
+    /* Binary search for the last frame starting at or before offset */
+    uint32_t lo = 0;
+    uint32_t hi = index->count - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (index->entries[mid].offset <= offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    *frame = lo;
+    return true;
+}
+
+uint32_t frame_index_avg_size(const frame_index_t *index)
+{
+    if (index->count == 0) {
+        return 0;
+    }
+    const frame_index_entry_t *last = &index->entries[index->count - 1];
+    return (last->offset + last->size - index->entries[0].offset) / index->count;
+}
+
+void frame_index_clear(frame_index_t *index)
+{
+    index->count = 0;
+    index->complete = false;
+}
+
+void frame_index_init_static(frame_index_t *index, frame_index_entry_t *entries, uint32_t capacity)
+{
+    index->entries = entries;
+    index->count = 0;
+    index->capacity = capacity;
+    index->complete = false;
+    index->fixed = true;
+}
+
+void frame_index_free(frame_index_t *index)
+{
+    index->count = 0;
+    index->complete = false;
+    if (index->fixed) {
+        return;
+    }
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+}
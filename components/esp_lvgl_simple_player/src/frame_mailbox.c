@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "frame_mailbox.h"
+
+#define FRAME_MAILBOX_FRESH     (0x80)
+#define FRAME_MAILBOX_INDEX     (0x7f)
+
+void frame_mailbox_reset(frame_mailbox_t *mailbox, uint8_t front)
+{
+    mailbox->front = front;
+    mailbox->back = (front + 1) % FRAME_MAILBOX_SLOTS;
+    atomic_store(&mailbox->shared, (front + 2) % FRAME_MAILBOX_SLOTS);
+}
+
+uint8_t frame_mailbox_back(const frame_mailbox_t *mailbox)
+{
+    return mailbox->back;
+}
+
+void frame_mailbox_publish(frame_mailbox_t *mailbox)
+{
+    /* Frame data written before are visible to consumer which takes the slot */
+    unsigned int prev = atomic_exchange_explicit(&mailbox->shared, mailbox->back | FRAME_MAILBOX_FRESH, memory_order_acq_rel);
+    mailbox->back = prev & FRAME_MAILBOX_INDEX;
+}
+
+bool frame_mailbox_take(frame_mailbox_t *mailbox)
+{
+    if ((atomic_load_explicit(&mailbox->shared, memory_order_relaxed) & FRAME_MAILBOX_FRESH) == 0) {
+        return false;
+    }
+    /* Only consumer clears the fresh flag, so the exchange always gets a published frame */
+    unsigned int prev = atomic_exchange_explicit(&mailbox->shared, mailbox->front, memory_order_acq_rel);
+    mailbox->front = prev & FRAME_MAILBOX_INDEX;
+    return true;
+}
+
+uint8_t frame_mailbox_front(const frame_mailbox_t *mailbox)
+{
+    return mailbox->front;
+}
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "frame_skip.h"
+
+void frame_skip_reset(frame_skip_t *skip)
+{
+    memset(skip, 0, sizeof(frame_skip_t));
+}
+
+bool frame_skip_update(frame_skip_t *skip, uint32_t frame_time, uint32_t budget)
+{
+    skip->sum += frame_time;
+    if (++skip->samples < FRAME_SKIP_WINDOW) {
+        return false;
+    }
+
+    /* Load in percent of the time available for decoded frames of the window */
+    const uint64_t available = (uint64_t)budget * frame_skip_step(skip) * skip->samples;
+    const uint32_t load = (available ? (skip->sum * 100) / available : 0);
+    skip->samples = 0;
+    skip->sum = 0;
+
+    if (load > FRAME_SKIP_HIGH_LOAD) {
+        skip->recovery = 0;
+        if (++skip->overload >= FRAME_SKIP_OVERLOAD && skip->level + 1 < FRAME_SKIP_LEVELS) {
+            skip->overload = 0;
+            skip->level++;
+            return true;
+        }
+    } else if (load < FRAME_SKIP_LOW_LOAD && skip->level > 0) {
+        skip->overload = 0;
+        if (++skip->recovery >= FRAME_SKIP_RECOVERY) {
+            skip->recovery = 0;
+            skip->level--;
+            return true;
+        }
+    } else {
+        skip->overload = 0;
+        skip->recovery = 0;
+    }
+    return false;
+}
@@ -0,0 +1,277 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "jpeg_dec_service.h"
+#include "player_trace.h"
+
+#define JPEG_DEC_SERVICE_TASK_PRIO      (5)
+#define JPEG_DEC_SERVICE_TASK_STACK     (3072)
+#define JPEG_DEC_SERVICE_TIMEOUT_MS     (50)
+
+static const char *TAG = "JPEG_SRV";
+
+typedef enum {
+    JOB_IDLE,
+    JOB_PENDING,
+    JOB_RUNNING,
+} job_state_t;
+
+struct jpeg_dec_client_s {
+    uint8_t                 priority;
+    SemaphoreHandle_t       done;
+
+    /* Job (one outstanding job per client) */
+    job_state_t             state;
+    uint32_t                seq;
+    const jpeg_decode_cfg_t *cfg;
+    const uint8_t           *in;
+    uint32_t                in_size;
+    uint8_t                 *out;
+    uint32_t                out_size;
+    int64_t                 deadline_us;
+    uint32_t                ret_size;
+    esp_err_t               ret;
+};
+
+typedef struct {
+    SemaphoreHandle_t       api_lock;   /* Serializes client new/del */
+    StaticSemaphore_t       api_lock_buf;
+    jpeg_decoder_handle_t   engine;
+    TaskHandle_t            task;
+    SemaphoreHandle_t       task_exited;
+    bool                    task_exit;
+
+    jpeg_dec_client_handle_t clients[JPEG_DEC_SERVICE_MAX_CLIENTS];
+    uint32_t                clients_num;
+    uint32_t                seq;
+} jpeg_dec_service_t;
+
+static jpeg_dec_service_t service;
+static portMUX_TYPE service_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+static SemaphoreHandle_t jpeg_dec_service_api_lock(void)
+{
+    portENTER_CRITICAL(&service_spinlock);
+    if (service.api_lock == NULL) {
+        service.api_lock = xSemaphoreCreateMutexStatic(&service.api_lock_buf);
+    }
+    portEXIT_CRITICAL(&service_spinlock);
+    return service.api_lock;
+}
+
+/* Returns the best pending job: highest priority, then earliest deadline, then FIFO */
+static jpeg_dec_client_handle_t jpeg_dec_service_next_job(void)
+{
+    jpeg_dec_client_handle_t best = NULL;
+
+    portENTER_CRITICAL(&service_spinlock);
+    for (int i = 0; i < JPEG_DEC_SERVICE_MAX_CLIENTS; i++) {
+        jpeg_dec_client_handle_t c = service.clients[i];
+        if (c == NULL || c->state != JOB_PENDING) {
+            continue;
+        }
+        if (best == NULL || c->priority > best->priority) {
+            best = c;
+            continue;
+        }
+        if (c->priority < best->priority) {
+            continue;
+        }
+        int64_t c_deadline = (c->deadline_us ? c->deadline_us : INT64_MAX);
+        int64_t best_deadline = (best->deadline_us ? best->deadline_us : INT64_MAX);
+        if (c_deadline < best_deadline || (c_deadline == best_deadline && (int32_t)(c->seq - best->seq) < 0)) {
+            best = c;
+        }
+    }
+    if (best) {
+        best->state = JOB_RUNNING;
+    }
+    portEXIT_CRITICAL(&service_spinlock);
+
+    return best;
+}
+
+static void jpeg_dec_service_task(void *arg)
+{
+    while (!service.task_exit) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /* Run all queued jobs back-to-back to keep the engine busy */
+        jpeg_dec_client_handle_t job;
+        while ((job = jpeg_dec_service_next_job()) != NULL) {
+            if (job->deadline_us && esp_timer_get_time() > job->deadline_us) {
+                job->ret = JPEG_DEC_ERR_LATE;
+                job->ret_size = 0;
+            } else {
+                job->ret_size = job->out_size;
+                PLAYER_TRACE_BEGIN("jpeg engine");
+                job->ret = jpeg_decoder_process(service.engine, job->cfg, job->in, job->in_size, job->out, job->out_size, &job->ret_size);
+                PLAYER_TRACE_END("jpeg engine");
+            }
+            portENTER_CRITICAL(&service_spinlock);
+            job->state = JOB_IDLE;
+            portEXIT_CRITICAL(&service_spinlock);
+            xSemaphoreGive(job->done);
+        }
+    }
+
+    xSemaphoreGive(service.task_exited);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t jpeg_dec_service_start(void)
+{
+    esp_err_t ret = ESP_OK;
+    jpeg_decode_engine_cfg_t engine_cfg = {
+        .intr_priority = 0,
+        .timeout_ms = JPEG_DEC_SERVICE_TIMEOUT_MS,
+    };
+    ESP_RETURN_ON_ERROR(jpeg_new_decoder_engine(&engine_cfg, &service.engine), TAG, "Create JPEG decoder engine failed");
+
+    service.task_exit = false;
+    service.task_exited = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(service.task_exited, ESP_ERR_NO_MEM, err, TAG, "Create semaphore failed");
+    BaseType_t res = xTaskCreate(jpeg_dec_service_task, "jpeg service", JPEG_DEC_SERVICE_TASK_STACK, NULL, JPEG_DEC_SERVICE_TASK_PRIO, &service.task);
+    ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "Create JPEG service task failed");
+
+    ESP_LOGI(TAG, "JPEG decoder service started");
+    return ESP_OK;
+
+err:
+    if (service.task_exited) {
+        vSemaphoreDelete(service.task_exited);
+        service.task_exited = NULL;
+    }
+    jpeg_del_decoder_engine(service.engine);
+    service.engine = NULL;
+    return ret;
+}
+
+static void jpeg_dec_service_stop(void)
+{
+    service.task_exit = true;
+    xTaskNotifyGive(service.task);
+    xSemaphoreTake(service.task_exited, portMAX_DELAY);
+    vSemaphoreDelete(service.task_exited);
+    service.task_exited = NULL;
+    service.task = NULL;
+
+    jpeg_del_decoder_engine(service.engine);
+    service.engine = NULL;
+    ESP_LOGI(TAG, "JPEG decoder service stopped");
+}
+
+esp_err_t jpeg_dec_service_client_new(uint8_t priority, jpeg_dec_client_handle_t *ret_client)
+{
+    esp_err_t ret = ESP_OK;
+    int slot = -1;
+    ESP_RETURN_ON_FALSE(ret_client, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    jpeg_dec_client_handle_t client = calloc(1, sizeof(struct jpeg_dec_client_s));
+    ESP_RETURN_ON_FALSE(client, ESP_ERR_NO_MEM, TAG, "Allocation client failed");
+    client->priority = priority;
+    client->done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(client->done, ESP_ERR_NO_MEM, err, TAG, "Create semaphore failed");
+
+    SemaphoreHandle_t lock = jpeg_dec_service_api_lock();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (service.clients_num == 0) {
+        ret = jpeg_dec_service_start();
+    }
+    if (ret == ESP_OK) {
+        portENTER_CRITICAL(&service_spinlock);
+        for (int i = 0; i < JPEG_DEC_SERVICE_MAX_CLIENTS; i++) {
+            if (service.clients[i] == NULL) {
+                service.clients[i] = client;
+                service.clients_num++;
+                slot = i;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&service_spinlock);
+    }
+    xSemaphoreGive(lock);
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "Start JPEG decoder service failed");
+    ESP_GOTO_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, err, TAG, "No free client slot in JPEG decoder service");
+
+    *ret_client = client;
+    return ESP_OK;
+
+err:
+    if (client->done) {
+        vSemaphoreDelete(client->done);
+    }
+    free(client);
+    return ret;
+}
+
+esp_err_t jpeg_dec_service_client_del(jpeg_dec_client_handle_t client)
+{
+    ESP_RETURN_ON_FALSE(client, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    SemaphoreHandle_t lock = jpeg_dec_service_api_lock();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    portENTER_CRITICAL(&service_spinlock);
+    for (int i = 0; i < JPEG_DEC_SERVICE_MAX_CLIENTS; i++) {
+        if (service.clients[i] == client) {
+            service.clients[i] = NULL;
+            service.clients_num--;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&service_spinlock);
+    if (service.clients_num == 0) {
+        jpeg_dec_service_stop();
+    }
+    xSemaphoreGive(lock);
+
+    vSemaphoreDelete(client->done);
+    free(client);
+    return ESP_OK;
+}
+
+void jpeg_dec_service_client_set_priority(jpeg_dec_client_handle_t client, uint8_t priority)
+{
+    assert(client);
+    portENTER_CRITICAL(&service_spinlock);
+    client->priority = priority;
+    portEXIT_CRITICAL(&service_spinlock);
+}
+
+esp_err_t jpeg_dec_service_decode(jpeg_dec_client_handle_t client, const jpeg_decode_cfg_t *cfg,
+                                  const uint8_t *in, uint32_t in_size, uint8_t *out, uint32_t out_size,
+                                  int64_t deadline_us, uint32_t *ret_size)
+{
+    ESP_RETURN_ON_FALSE(client && cfg && in && out, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    assert(client->state == JOB_IDLE);
+
+    client->cfg = cfg;
+    client->in = in;
+    client->in_size = in_size;
+    client->out = out;
+    client->out_size = out_size;
+    client->deadline_us = deadline_us;
+
+    portENTER_CRITICAL(&service_spinlock);
+    client->seq = service.seq++;
+    client->state = JOB_PENDING;
+    portEXIT_CRITICAL(&service_spinlock);
+
+    xTaskNotifyGive(service.task);
+    xSemaphoreTake(client->done, portMAX_DELAY);
+
+    if (ret_size) {
+        *ret_size = client->ret_size;
+    }
+    return client->ret;
+}
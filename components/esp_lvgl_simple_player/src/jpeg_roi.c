@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <sys/param.h>
+#include "jpeg_roi.h"
+
+#define JPEG_MARKER_SOF0    (0xc0)
+#define JPEG_MARKER_SOF1    (0xc1)
+#define JPEG_MARKER_RST0    (0xd0)
+#define JPEG_MARKER_RST7    (0xd7)
+#define JPEG_MARKER_SOI     (0xd8)
+#define JPEG_MARKER_EOI     (0xd9)
+#define JPEG_MARKER_SOS     (0xda)
+#define JPEG_MARKER_DRI     (0xdd)
+
+typedef struct {
+    uint32_t    sof;            /* Offset of SOF segment */
+    uint32_t    scan;           /* Offset of entropy coded data */
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    mcu_width;
+    uint32_t    mcu_height;
+    uint32_t    restart;        /* Restart interval in MCUs (0 = no restart markers) */
+} jpeg_roi_info_t;
+
+static uint16_t jpeg_roi_u16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static void jpeg_roi_put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xff;
+}
+
+/* Parse markers up to the start of entropy coded data */
+static esp_err_t jpeg_roi_parse(const uint8_t *data, uint32_t len, jpeg_roi_info_t *info)
+{
+    uint32_t components = 0;
+    uint32_t pos = 2;
+
+    memset(info, 0, sizeof(jpeg_roi_info_t));
+    if (len < 4 || data[0] != 0xff || data[1] != JPEG_MARKER_SOI) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    while (pos + 4 <= len) {
+        if (data[pos] != 0xff) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        const uint8_t marker = data[pos + 1];
+        if (marker == 0xff) {
+            /* Fill byte */
+            pos++;
+            continue;
+        }
+        const uint32_t seg_len = jpeg_roi_u16(data + pos + 2);
+        const uint8_t *body = data + pos + 4;
+        if (seg_len < 2 || pos + 2 + seg_len > len) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (marker == JPEG_MARKER_SOF0 || marker == JPEG_MARKER_SOF1) {
+            if (seg_len < 8 || seg_len < 8 + 3 * body[5]) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            info->sof = pos;
+            info->height = jpeg_roi_u16(body + 1);
+            info->width = jpeg_roi_u16(body + 3);
+            components = body[5];
+            uint32_t h_max = 1;
+            uint32_t v_max = 1;
+            for (uint32_t i = 0; i < components; i++) {
+                h_max = MAX(h_max, body[7 + 3 * i] >> 4);
+                v_max = MAX(v_max, body[7 + 3 * i] & 0x0f);
+            }
+            /* Scan with one component is not interleaved, its MCU is one block */
+            info->mcu_width = (components == 1 ? 8 : 8 * h_max);
+            info->mcu_height = (components == 1 ? 8 : 8 * v_max);
+        } else if (marker >= 0xc2 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            /* Progressive, lossless or arithmetic coding */
+            return ESP_ERR_NOT_SUPPORTED;
+        } else if (marker == JPEG_MARKER_DRI) {
+            info->restart = jpeg_roi_u16(body);
+        } else if (marker == JPEG_MARKER_SOS) {
+            /* Only one scan with all components */
+            if (info->sof == 0 || body[0] != components) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            info->scan = pos + 2 + seg_len;
+            return (info->width && info->height ? ESP_OK : ESP_ERR_INVALID_SIZE);
+        }
+        pos += 2 + seg_len;
+    }
+    return ESP_ERR_INVALID_SIZE;
+}
+
+/* End of restart interval starting at pos (position of the next marker) */
+static uint32_t jpeg_roi_interval_end(const uint8_t *data, uint32_t pos, uint32_t len)
+{
+    while (pos + 1 < len) {
+        const uint8_t *ff = memchr(data + pos, 0xff, len - pos - 1);
+        if (ff == NULL) {
+            break;
+        }
+        pos = ff - data;
+        const uint8_t next = data[pos + 1];
+        if (next == 0x00 || next == 0xff) {
+            /* Stuffed byte or fill byte before marker */
+            pos++;
+            continue;
+        }
+        return pos;
+    }
+    return len;
+}
+
+esp_err_t jpeg_roi_crop(uint8_t *data, uint32_t len, const jpeg_roi_rect_t *roi, jpeg_roi_rect_t *crop, uint32_t *out_len)
+{
+    jpeg_roi_info_t info;
+    esp_err_t ret = jpeg_roi_parse(data, len, &info);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (roi->width == 0 || roi->height == 0 || roi->x + roi->width > info.width || roi->y + roi->height > info.height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (info.restart == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    /* Intervals in MCU rows and columns of the picture */
+    const uint32_t cols = (info.width + info.mcu_width - 1) / info.mcu_width;
+    const uint32_t rows = (info.height + info.mcu_height - 1) / info.mcu_height;
+    uint32_t interval_cols;     /* Restart intervals in MCU row */
+    uint32_t interval_rows;     /* MCU rows in restart interval */
+    if (cols % info.restart == 0) {
+        interval_cols = cols / info.restart;
+        interval_rows = 1;
+    } else if (info.restart % cols == 0) {
+        interval_cols = 1;
+        interval_rows = info.restart / cols;
+    } else {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const uint32_t interval_width = (interval_cols > 1 ? info.restart * info.mcu_width : info.width);
+    const uint32_t interval_height = interval_rows * info.mcu_height;
+
+    /* Intervals covering the region */
+    const uint32_t c1 = roi->x / interval_width;
+    const uint32_t c2 = (roi->x + roi->width - 1) / interval_width;
+    const uint32_t r1 = roi->y / interval_height;
+    const uint32_t r2 = (roi->y + roi->height - 1) / interval_height;
+    const uint32_t total = interval_cols * ((rows + interval_rows - 1) / interval_rows);
+    crop->x = c1 * interval_width;
+    crop->y = r1 * interval_height;
+    crop->width = MIN((c2 + 1) * interval_width, info.width) - crop->x;
+    crop->height = MIN((r2 + 1) * interval_height, info.height) - crop->y;
+
+    /* Picture is changed in place, so all needed intervals are checked first */
+    const uint32_t last = r2 * interval_cols + c2;
+    uint32_t in = info.scan;
+    for (uint32_t i = 0; i <= last; i++) {
+        const uint32_t end = jpeg_roi_interval_end(data, in, len);
+        if (end + 2 > len) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        /* Restart marker must follow, otherwise intervals do not match the picture */
+        if (i + 1 < total && (data[end + 1] < JPEG_MARKER_RST0 || data[end + 1] > JPEG_MARKER_RST7)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        in = end + 2;
+    }
+
+    /* Headers are kept, only size in SOF is changed */
+    jpeg_roi_put_u16(data + info.sof + 5, crop->height);
+    jpeg_roi_put_u16(data + info.sof + 7, crop->width);
+
+    /* Kept intervals are moved to front (output never overtakes input), restart markers are numbered again */
+    uint32_t out = info.scan;
+    uint32_t kept = 0;
+    in = info.scan;
+    for (uint32_t i = 0; i <= last; i++) {
+        const uint32_t end = jpeg_roi_interval_end(data, in, len);
+        if (i / interval_cols >= r1 && i % interval_cols >= c1 && i % interval_cols <= c2) {
+            if (kept > 0) {
+                data[out++] = 0xff;
+                data[out++] = JPEG_MARKER_RST0 + ((kept - 1) & 7);
+            }
+            memmove(data + out, data + in, end - in);
+            out += end - in;
+            kept++;
+        }
+        in = end + 2;
+    }
+    data[out++] = 0xff;
+    data[out++] = JPEG_MARKER_EOI;
+    *out_len = out;
+    return ESP_OK;
+}
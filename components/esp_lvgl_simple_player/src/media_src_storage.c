@@ -3,10 +3,13 @@
 #include <stdbool.h>
 #include <string.h>
 #include <sys/unistd.h>
+#include <sys/stat.h>
 #include "esp_heap_caps.h"
 #include "media_src_storage.h"
+#include "player_trace.h"
 
 #define CACHE_SIZE (16*1024)
+#define STORAGE_SECTOR_SIZE (512)
 
 #define USE_ALIGN_CACHE
 
@@ -21,6 +24,7 @@ typedef struct {
     int      buffer_pos;
 #endif
     FILE*    fp;
+    bool     static_mem;    /* Memory of the caller */
 } storage_src_t;
 
 #define ALIGN_TO(pos, align) (pos & (~((align)-1)))
@@ -66,7 +70,9 @@ static int cache_data(storage_src_t* m, void *data, int n) {
         m->readed = m->filled = 0;
     }
     if (m->filled == 0) {
+        PLAYER_TRACE_BEGIN("fs read");
         int n = read(fileno(m->fp), m->align_buffer, CACHE_SIZE);
+        PLAYER_TRACE_END("fs read");
         //int n = fread(m->align_buffer, 1, CACHE_SIZE, m->fp);
         if (n < 0) {
             return n;
@@ -100,21 +106,80 @@ static int read_from_cache(storage_src_t* m, void *data, size_t len) {
 
 int media_src_storage_open(media_src_t *src)
 {
-    storage_src_t* m = calloc(1, sizeof(storage_src_t));
-    if (m == NULL) {
+    void *cache = NULL;
+#ifdef USE_ALIGN_CACHE
+    cache = heap_caps_aligned_alloc(64, CACHE_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (cache == NULL) {
+        return -1;
+    }
+#endif
+    if (media_src_storage_open_cache(src, cache) != 0) {
+        free(cache);
         return -1;
     }
+    return 0;
+}
+
+size_t media_src_storage_cache_size(void)
+{
 #ifdef USE_ALIGN_CACHE
-    m->align_buffer = heap_caps_aligned_alloc(64, CACHE_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-    if (m->align_buffer == NULL) {
-        free(m);
+    return CACHE_SIZE;
+#else
+    return 0;
+#endif
+}
+
+int media_src_storage_open_cache(media_src_t *src, void *cache)
+{
+    storage_src_t* m = calloc(1, sizeof(storage_src_t));
+    if (m == NULL) {
         return -1;
     }
+#ifdef USE_ALIGN_CACHE
+    m->align_buffer = cache;
+#else
+    free(cache);
 #endif
     src->sub_src = m;
     return 0;
 }
 
+const void *media_src_storage_get_cache(media_src_t *src)
+{
+#ifdef USE_ALIGN_CACHE
+    storage_src_t* m = (storage_src_t*)src->sub_src;
+    return (m ? m->align_buffer : NULL);
+#else
+    return NULL;
+#endif
+}
+
+size_t media_src_storage_mem_size(void)
+{
+#ifdef USE_ALIGN_CACHE
+    return CACHE_SIZE + sizeof(storage_src_t);
+#else
+    return sizeof(storage_src_t);
+#endif
+}
+
+int media_src_storage_open_static(media_src_t *src, void *mem)
+{
+    storage_src_t* m;
+#ifdef USE_ALIGN_CACHE
+    /* Cache first, it keeps alignment of the memory */
+    m = (storage_src_t*)((uint8_t *)mem + CACHE_SIZE);
+    memset(m, 0, sizeof(storage_src_t));
+    m->align_buffer = mem;
+#else
+    m = mem;
+    memset(m, 0, sizeof(storage_src_t));
+#endif
+    m->static_mem = true;
+    src->sub_src = m;
+    return 0;
+}
+
 int media_src_storage_connect(media_src_t *src, char *uri)
 {
     storage_src_t* m = (storage_src_t*)src->sub_src;
@@ -172,16 +237,56 @@ int media_src_storage_seek(media_src_t *src, uint64_t position)
         m->buffer_pos = m->align_pos;
         position = m->align_pos;
 #endif
-        return fseek(m->fp, position, SEEK_SET);
+        PLAYER_TRACE_BEGIN("fs seek");
+#ifdef USE_ALIGN_CACHE
+        /* Cache reads the file descriptor directly, stdio seek can move it (seek optimization reads into stdio buffer) */
+        int ret = (lseek(fileno(m->fp), position, SEEK_SET) < 0 ? -1 : 0);
+#else
+        int ret = fseek(m->fp, position, SEEK_SET);
+#endif
+        PLAYER_TRACE_END("fs seek");
+        return ret;
     }
     return -1;
 }
 
+int media_src_storage_read_at(media_src_t *src, uint64_t position, void *data, size_t len)
+{
+    storage_src_t* m = (storage_src_t*)src->sub_src;
+    if (m->fp == NULL) {
+        return -1;
+    }
+#ifdef USE_ALIGN_CACHE
+    if ((position % STORAGE_SECTOR_SIZE) == 0 && (len % STORAGE_SECTOR_SIZE) == 0) {
+        /* Whole sectors are read to data directly, without copy through the cache */
+        media_src_storage_flush(m);
+        PLAYER_TRACE_BEGIN("fs read");
+        int n = -1;
+        if (lseek(fileno(m->fp), position, SEEK_SET) >= 0) {
+            n = read(fileno(m->fp), data, len);
+        }
+        PLAYER_TRACE_END("fs read");
+        /* Cache continues behind the read data */
+        m->buffer_pos = m->align_pos = m->seek_pos = (int)(position + (n > 0 ? n : 0));
+        return n;
+    }
+#endif
+    if (media_src_storage_seek(src, position) != 0) {
+        return -1;
+    }
+    return media_src_storage_read(src, data, len);
+}
+
 int media_src_storage_get_position(media_src_t *src, uint64_t *position)
 {
     storage_src_t* m = (storage_src_t*)src->sub_src;
     if (m->fp) {
+#ifdef USE_ALIGN_CACHE
+        /* Reads go to the file descriptor ahead of the data taken from the cache, stdio position is not used */
+        *position = (m->align_pos < m->seek_pos ? m->seek_pos : m->buffer_pos + m->readed);
+#else
         *position = ftell(m->fp);
+#endif
         return 0;
     }
     return -1;
@@ -191,11 +296,12 @@ int media_src_storage_get_size(media_src_t *src, uint64_t *size)
 {
     storage_src_t* m = (storage_src_t*)src->sub_src;
     if (m->fp) {
-        uint32_t old = ftell(m->fp);
-        fseek(m->fp, 0, 2);
-        long end = ftell(m->fp);
-        fseek(m->fp, old, 0);
-        *size = (end <= 0 ? 0 : (uint32_t) end);
+        /* File position is not changed */
+        struct stat st;
+        if (fstat(fileno(m->fp), &st) != 0) {
+            return -1;
+        }
+        *size = (st.st_size <= 0 ? 0 : (uint64_t) st.st_size);
         return 0;
     }
     return -1;
@@ -208,6 +314,9 @@ int media_src_storage_close(media_src_t *src)
         fclose((FILE *) m->fp);
         m->fp = NULL;
     }
+    if (m->static_mem) {
+        return 0;
+    }
 #ifdef USE_ALIGN_CACHE
     if (m->align_buffer) {
         free(m->align_buffer);
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "mjpeg_parser.h"
+
+static const uint8_t SOI[] = {0xff, 0xd8, 0xff}; /* Start of image + first marker */
+static const uint8_t EOI[] = {0xff, 0xd9};       /* End of image */
+
+int mjpeg_find_frame_start(const uint8_t *data, size_t len)
+{
+    const uint8_t *match = memmem(data, len, SOI, sizeof(SOI));
+    return (match ? (int)(match - data) : -1);
+}
+
+int mjpeg_find_frame_end(const uint8_t *data, size_t len)
+{
+    const uint8_t *match = memmem(data, len, EOI, sizeof(EOI));
+    return (match ? (int)((match + sizeof(EOI)) - data) : -1);
+}
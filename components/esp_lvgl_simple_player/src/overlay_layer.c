@@ -0,0 +1,221 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "overlay_layer.h"
+
+/* RGB565 with green moved to upper half word, so all channels can be multiplied by 5-bit alpha at once */
+#define RGB565_SPREAD_MASK  (0x07E0F81F)
+
+static inline uint32_t overlay_spread(uint16_t color)
+{
+    return (color | ((uint32_t)color << 16)) & RGB565_SPREAD_MASK;
+}
+
+static inline uint16_t overlay_pack(uint32_t spread)
+{
+    return (uint16_t)(spread | (spread >> 16));
+}
+
+/* Color multiplied by alpha (0 - 32), channels are rounded down, so premultiplied color and scaled background never overflow */
+static inline uint16_t overlay_scale(uint16_t color, uint32_t alpha)
+{
+    return overlay_pack(((overlay_spread(color) * alpha) >> 5) & RGB565_SPREAD_MASK);
+}
+
+/* Source pixel of the image in RGB565 and 8-bit alpha */
+static void overlay_image_pixel(const lv_image_dsc_t *image, uint32_t stride, uint32_t x, uint32_t y, uint16_t *color, uint8_t *alpha)
+{
+    const uint8_t *data = image->data;
+
+    switch (image->header.cf) {
+    case LV_COLOR_FORMAT_RGB565:
+        *color = ((const uint16_t *)(data + y * stride))[x];
+        *alpha = 0xff;
+        break;
+    case LV_COLOR_FORMAT_RGB565A8:
+        /* Alpha plane follows color plane, with half stride */
+        *color = ((const uint16_t *)(data + y * stride))[x];
+        *alpha = data[stride * image->header.h + y * (stride / 2) + x];
+        break;
+    default: {
+        /* ARGB8888, bytes are B, G, R, A */
+        const uint8_t *px = data + y * stride + x * 4;
+        *color = ((px[2] & 0xf8) << 8) | ((px[1] & 0xfc) << 3) | (px[0] >> 3);
+        *alpha = px[3];
+        break;
+    }
+    }
+}
+
+/* Check format of the image and set size of the layer */
+static esp_err_t overlay_layer_size(overlay_layer_t *layer, const lv_image_dsc_t *image)
+{
+    const uint32_t width = image->header.w;
+    const uint32_t height = image->header.h;
+
+    switch (image->header.cf) {
+    case LV_COLOR_FORMAT_RGB565:
+    case LV_COLOR_FORMAT_RGB565A8:
+    case LV_COLOR_FORMAT_ARGB8888:
+        break;
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (width == 0 || height == 0 || image->data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(layer, 0, sizeof(overlay_layer_t));
+    layer->width = width;
+    layer->height = height;
+    layer->cols = (width + OVERLAY_TILE_SIZE - 1) / OVERLAY_TILE_SIZE;
+    layer->rows = (height + OVERLAY_TILE_SIZE - 1) / OVERLAY_TILE_SIZE;
+    return ESP_OK;
+}
+
+/* Pre-composite the image into memory of the layer */
+static void overlay_layer_fill(overlay_layer_t *layer, const lv_image_dsc_t *image)
+{
+    const uint32_t width = layer->width;
+    const uint32_t height = layer->height;
+    const uint32_t bpp = (image->header.cf == LV_COLOR_FORMAT_ARGB8888 ? 4 : 2);
+    const uint32_t stride = (image->header.stride ? image->header.stride : width * bpp);
+
+    /* Premultiplied colors and inverse alpha */
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint16_t color;
+            uint8_t alpha;
+            overlay_image_pixel(image, stride, x, y, &color, &alpha);
+            const uint32_t a = MIN((alpha + 4) >> 3, 32);
+            layer->color[y * width + x] = overlay_scale(color, a);
+            layer->alpha[y * width + x] = 32 - a;
+        }
+    }
+
+    /* Tiles, which are whole opaque or transparent, are not blended */
+    for (uint32_t r = 0; r < layer->rows; r++) {
+        for (uint32_t c = 0; c < layer->cols; c++) {
+            bool opaque = true;
+            bool transparent = true;
+            for (uint32_t y = r * OVERLAY_TILE_SIZE; y < MIN((r + 1) * OVERLAY_TILE_SIZE, height); y++) {
+                for (uint32_t x = c * OVERLAY_TILE_SIZE; x < MIN((c + 1) * OVERLAY_TILE_SIZE, width); x++) {
+                    const uint8_t ia = layer->alpha[y * width + x];
+                    opaque &= (ia == 0);
+                    transparent &= (ia == 32);
+                }
+            }
+            layer->tiles[r * layer->cols + c] = (opaque ? OVERLAY_TILE_OPAQUE : (transparent ? OVERLAY_TILE_TRANSPARENT : OVERLAY_TILE_BLEND));
+        }
+    }
+}
+
+esp_err_t overlay_layer_init(overlay_layer_t *layer, const lv_image_dsc_t *image)
+{
+    esp_err_t ret = overlay_layer_size(layer, image);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    layer->color = malloc(layer->width * layer->height * sizeof(uint16_t));
+    layer->alpha = malloc(layer->width * layer->height);
+    layer->tiles = malloc(layer->cols * layer->rows);
+    if (layer->color == NULL || layer->alpha == NULL || layer->tiles == NULL) {
+        overlay_layer_deinit(layer);
+        return ESP_ERR_NO_MEM;
+    }
+    overlay_layer_fill(layer, image);
+    return ESP_OK;
+}
+
+uint32_t overlay_layer_mem_size(uint32_t width, uint32_t height)
+{
+    const uint32_t tiles = ((width + OVERLAY_TILE_SIZE - 1) / OVERLAY_TILE_SIZE) * ((height + OVERLAY_TILE_SIZE - 1) / OVERLAY_TILE_SIZE);
+    return width * height * (sizeof(uint16_t) + 1) + tiles;
+}
+
+esp_err_t overlay_layer_init_static(overlay_layer_t *layer, const lv_image_dsc_t *image, void *mem, uint32_t mem_size)
+{
+    esp_err_t ret = overlay_layer_size(layer, image);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (overlay_layer_mem_size(layer->width, layer->height) > mem_size) {
+        memset(layer, 0, sizeof(overlay_layer_t));
+        return ESP_ERR_INVALID_SIZE;
+    }
+    /* Colors first, so they keep alignment of the memory */
+    layer->color = mem;
+    layer->alpha = (uint8_t *)mem + layer->width * layer->height * sizeof(uint16_t);
+    layer->tiles = layer->alpha + layer->width * layer->height;
+    layer->fixed = true;
+    overlay_layer_fill(layer, image);
+    return ESP_OK;
+}
+
+void overlay_layer_deinit(overlay_layer_t *layer)
+{
+    if (layer->fixed) {
+        memset(layer, 0, sizeof(overlay_layer_t));
+        return;
+    }
+    free(layer->color);
+    free(layer->alpha);
+    free(layer->tiles);
+    memset(layer, 0, sizeof(overlay_layer_t));
+}
+
+/* dst = src + dst * ia, one multiply for all channels of the pixel */
+static void overlay_blend_span(uint16_t *dst, const uint16_t *src, const uint8_t *ia, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        dst[i] = overlay_scale(dst[i], ia[i]) + src[i];
+    }
+}
+
+void overlay_layer_blend(const overlay_layer_t *layer, int32_t x, int32_t y, uint8_t *frame, uint32_t stride, uint32_t width, uint32_t height)
+{
+    /* Visible part of the layer in layer coordinates */
+    const int32_t lx1 = MAX(0, -x);
+    const int32_t ly1 = MAX(0, -y);
+    const int32_t lx2 = MIN((int32_t)layer->width, (int32_t)width - x);
+    const int32_t ly2 = MIN((int32_t)layer->height, (int32_t)height - y);
+    if (lx1 >= lx2 || ly1 >= ly2) {
+        return;
+    }
+
+    /* Frame is processed line by line, spans of tiles in the line are copied, blended or skipped */
+    for (int32_t ly = ly1; ly < ly2; ly++) {
+        const uint8_t *tiles = &layer->tiles[(ly / OVERLAY_TILE_SIZE) * layer->cols];
+        const uint16_t *src = &layer->color[ly * layer->width];
+        const uint8_t *ia = &layer->alpha[ly * layer->width];
+        uint16_t *dst = (uint16_t *)(frame + (ly + y) * stride) + x;
+
+        for (int32_t c = lx1 / OVERLAY_TILE_SIZE; c * OVERLAY_TILE_SIZE < lx2; c++) {
+            const int32_t sx1 = MAX(c * OVERLAY_TILE_SIZE, lx1);
+            const int32_t sx2 = MIN((c + 1) * OVERLAY_TILE_SIZE, lx2);
+            switch (tiles[c]) {
+            case OVERLAY_TILE_OPAQUE: {
+                /* Join following opaque tiles into one copy */
+                int32_t end = sx2;
+                while (end < lx2 && tiles[c + 1] == OVERLAY_TILE_OPAQUE) {
+                    c++;
+                    end = MIN((c + 1) * OVERLAY_TILE_SIZE, lx2);
+                }
+                memcpy(dst + sx1, src + sx1, (end - sx1) * sizeof(uint16_t));
+                break;
+            }
+            case OVERLAY_TILE_BLEND:
+                overlay_blend_span(dst + sx1, src + sx1, ia + sx1, sx2 - sx1);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
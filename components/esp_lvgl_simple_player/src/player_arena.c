@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp_heap_caps.h"
+#include "player_arena.h"
+
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+
+void player_arena_set_placement(player_arena_t *arena, player_arena_mem_t mem, const esp_lvgl_simple_player_mem_cfg_t *placement)
+{
+    if (mem < PLAYER_ARENA_ANY) {
+        arena->placement[mem] = *placement;
+    }
+}
+
+void *player_arena_take(player_arena_t *arena, player_arena_mem_t mem, uint32_t size)
+{
+    /* Parts keep alignment of the placement */
+    const uint32_t align = (mem < PLAYER_ARENA_ANY ? MAX(PLAYER_ARENA_ALIGN, arena->placement[mem].align) : PLAYER_ARENA_ALIGN);
+    const uint32_t offset = arena->used[mem];
+    arena->used[mem] += ALIGN_UP(size, align);
+    if (arena->base[mem] == NULL || arena->used[mem] > arena->size[mem]) {
+        return NULL;
+    }
+    return arena->base[mem] + offset;
+}
+
+esp_err_t player_arena_reserve(player_arena_t *arena)
+{
+    for (int i = 0; i < PLAYER_ARENA_MEM_MAX; i++) {
+        if (arena->used[i] == 0) {
+            continue;
+        }
+        if (i < PLAYER_MEM_CLASS_MAX) {
+            arena->base[i] = player_mem_alloc(&arena->placement[i], i, arena->used[i], NULL);
+        } else {
+            arena->base[i] = heap_caps_aligned_alloc(PLAYER_ARENA_ALIGN, arena->used[i], MALLOC_CAP_8BIT);
+        }
+        if (arena->base[i] == NULL) {
+            player_arena_free(arena);
+            return ESP_ERR_NO_MEM;
+        }
+        arena->size[i] = arena->used[i];
+        arena->used[i] = 0;
+    }
+    return ESP_OK;
+}
+
+uint32_t player_arena_size(const player_arena_t *arena)
+{
+    uint32_t size = 0;
+    for (int i = 0; i < PLAYER_ARENA_MEM_MAX; i++) {
+        size += arena->size[i];
+    }
+    return size;
+}
+
+void player_arena_free(player_arena_t *arena)
+{
+    for (int i = 0; i < PLAYER_ARENA_MEM_MAX; i++) {
+        if (arena->base[i]) {
+            heap_caps_free(arena->base[i]);
+        }
+    }
+    memset(arena, 0, sizeof(player_arena_t));
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "driver/jpeg_decode.h"
+#include "player_mem.h"
+
+#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
+
+static const char *TAG = "PLAYER_MEM";
+
+/* Default memory of the class */
+static void *player_mem_alloc_default(player_mem_class_t mem_class, uint32_t size, uint32_t *out_size)
+{
+    const jpeg_decode_memory_alloc_cfg_t mem_cfg = {
+        .buffer_direction = (mem_class == PLAYER_MEM_CLASS_ENCODED ? JPEG_DEC_ALLOC_INPUT_BUFFER : JPEG_DEC_ALLOC_OUTPUT_BUFFER),
+    };
+    size_t allocated = 0;
+    void *buff;
+
+    if (mem_class == PLAYER_MEM_CLASS_STORAGE) {
+        allocated = ALIGN_UP(size, PLAYER_MEM_STORAGE_ALIGN);
+        buff = heap_caps_aligned_alloc(PLAYER_MEM_STORAGE_ALIGN, allocated, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    } else {
+        buff = jpeg_alloc_decoder_mem(size, &mem_cfg, &allocated);
+    }
+    if (buff && out_size) {
+        *out_size = allocated;
+    }
+    return buff;
+}
+
+void *player_mem_alloc(const esp_lvgl_simple_player_mem_cfg_t *placement, player_mem_class_t mem_class, uint32_t size, uint32_t *out_size)
+{
+    if (placement == NULL || (placement->mem == PLAYER_MEM_DEFAULT && placement->align == 0)) {
+        return player_mem_alloc_default(mem_class, size, out_size);
+    }
+
+    /* Alignment is never lower than needed by DMA of the buffer */
+    uint32_t align = (mem_class == PLAYER_MEM_CLASS_STORAGE ? PLAYER_MEM_STORAGE_ALIGN : PLAYER_MEM_DECODER_ALIGN);
+    align = MAX(align, placement->align);
+    uint32_t caps = MALLOC_CAP_8BIT;
+    if (placement->mem == PLAYER_MEM_INTERNAL) {
+        caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+    } else if (placement->mem == PLAYER_MEM_PSRAM) {
+        caps |= MALLOC_CAP_SPIRAM;
+    } else {
+        caps |= (mem_class == PLAYER_MEM_CLASS_STORAGE ? MALLOC_CAP_INTERNAL : MALLOC_CAP_SPIRAM);
+    }
+    size = ALIGN_UP(size, align);
+    void *buff = heap_caps_aligned_alloc(align, size, caps);
+    if (buff == NULL) {
+        ESP_LOGW(TAG, "Requested memory for %ld bytes is full, default memory is used", size);
+        return player_mem_alloc_default(mem_class, size, out_size);
+    }
+    if (out_size) {
+        *out_size = size;
+    }
+    return buff;
+}
+
+player_mem_t player_mem_of(const void *buff)
+{
+    return (esp_ptr_external_ram(buff) ? PLAYER_MEM_PSRAM : PLAYER_MEM_INTERNAL);
+}
+
+void player_mem_count(esp_lvgl_simple_player_mem_usage_t *usage, const esp_lvgl_simple_player_mem_cfg_t *placement, const void *buff, uint32_t size)
+{
+    if (buff == NULL) {
+        return;
+    }
+    usage->buffers++;
+    /* Fallback to default memory is seen by the buffer itself */
+    if (placement && ((placement->mem != PLAYER_MEM_DEFAULT && player_mem_of(buff) != placement->mem) ||
+                      (placement->align && ((uintptr_t)buff & (placement->align - 1))))) {
+        usage->misplaced++;
+    }
+    if (player_mem_of(buff) == PLAYER_MEM_PSRAM) {
+        usage->psram += size;
+    } else {
+        usage->internal += size;
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "player_stats.h"
+
+void player_stats_reset(player_stats_t *stats)
+{
+    portENTER_CRITICAL(&stats->lock);
+    memset(stats->head, 0, sizeof(stats->head));
+    memset(stats->count, 0, sizeof(stats->count));
+    stats->decoded = 0;
+    stats->displayed = 0;
+    stats->dropped = 0;
+    stats->cached = 0;
+    stats->skipped = 0;
+    stats->repeated = 0;
+    stats->skip_changes = 0;
+    stats->skip_step = 1;
+    portEXIT_CRITICAL(&stats->lock);
+}
+
+void player_stats_add(player_stats_t *stats, player_stat_t stage, uint32_t value)
+{
+    portENTER_CRITICAL(&stats->lock);
+    stats->samples[stage][stats->head[stage]] = value;
+    stats->head[stage] = (stats->head[stage] + 1) % PLAYER_STATS_WINDOW;
+    if (stats->count[stage] < PLAYER_STATS_WINDOW) {
+        stats->count[stage]++;
+    }
+    portEXIT_CRITICAL(&stats->lock);
+}
+
+static int player_stats_cmp(const void *a, const void *b)
+{
+    uint32_t va = *(const uint32_t *)a;
+    uint32_t vb = *(const uint32_t *)b;
+    return (va > vb) - (va < vb);
+}
+
+void player_stats_get(player_stats_t *stats, esp_lvgl_simple_player_stats_t *out)
+{
+    uint32_t sorted[PLAYER_STATS_WINDOW];
+
+    memset(out, 0, sizeof(esp_lvgl_simple_player_stats_t));
+    out->frames_decoded = stats->decoded;
+    out->frames_displayed = stats->displayed;
+    out->frames_dropped = stats->dropped;
+    out->frames_cached = stats->cached;
+    out->frames_skipped = stats->skipped;
+    out->frames_repeated = stats->repeated;
+    out->skip_changes = stats->skip_changes;
+    out->decode_step = stats->skip_step;
+
+    for (int i = 0; i < PLAYER_STAT_MAX; i++) {
+        /* Copy under lock, sorting is done outside of critical section */
+        portENTER_CRITICAL(&stats->lock);
+        uint32_t count = stats->count[i];
+        memcpy(sorted, stats->samples[i], count * sizeof(uint32_t));
+        portEXIT_CRITICAL(&stats->lock);
+
+        if (i == PLAYER_STAT_DECODE) {
+            out->samples = count;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        qsort(sorted, count, sizeof(uint32_t), player_stats_cmp);
+        uint64_t sum = 0;
+        for (uint32_t j = 0; j < count; j++) {
+            sum += sorted[j];
+        }
+        player_stat_value_t *value = &out->stage[i];
+        value->min = sorted[0];
+        value->max = sorted[count - 1];
+        value->avg = sum / count;
+        value->p95 = sorted[((count - 1) * 95) / 100];
+    }
+}
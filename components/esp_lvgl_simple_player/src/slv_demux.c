@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "slv_demux.h"
+
+static const char *TAG = "SLV_DEMUX";
+
+/* Frame table is read directly to the index (both little endian) */
+_Static_assert(sizeof(slv_frame_t) == sizeof(frame_index_entry_t), "SLV frame table entry must match frame index entry");
+_Static_assert(sizeof(slv_header_t) == 64, "SLV header size");
+
+bool slv_demux_probe(const uint8_t *data, size_t len)
+{
+    return (len >= sizeof(slv_header_t) && memcmp(data, SLV_MAGIC, 4) == 0);
+}
+
+esp_err_t slv_demux_open(media_src_t *src, const uint8_t *data, size_t len, slv_demux_info_t *info, frame_index_t *index)
+{
+    slv_header_t header;
+    uint64_t file_size = 0;
+
+    memset(info, 0, sizeof(slv_demux_info_t));
+    frame_index_clear(index);
+    ESP_RETURN_ON_FALSE(slv_demux_probe(data, len), ESP_ERR_NOT_SUPPORTED, TAG, "Not SLV file");
+    memcpy(&header, data, sizeof(header));
+    ESP_RETURN_ON_FALSE(header.version == SLV_VERSION && header.header_size >= sizeof(header), ESP_ERR_INVALID_VERSION, TAG, "Unsupported SLV version %d", header.version);
+    ESP_RETURN_ON_FALSE(header.frame_count > 0 && header.width > 0 && header.height > 0, ESP_ERR_INVALID_SIZE, TAG, "Empty video");
+    ESP_RETURN_ON_FALSE(header.align > 0 && (header.align & (header.align - 1)) == 0, ESP_ERR_INVALID_SIZE, TAG, "Wrong frame alignment");
+    ESP_RETURN_ON_FALSE(media_src_storage_get_size(src, &file_size) == 0, ESP_ERR_INVALID_SIZE, TAG, "Get file size failed");
+
+    const uint64_t table_size = (uint64_t)header.frame_count * sizeof(slv_frame_t);
+    ESP_RETURN_ON_FALSE(header.table_offset + table_size <= file_size, ESP_ERR_INVALID_SIZE, TAG, "Truncated frame table");
+    ESP_RETURN_ON_ERROR(frame_index_reserve(index, header.frame_count), TAG, "Not enough memory for %ld frames", header.frame_count);
+    ESP_RETURN_ON_FALSE(media_src_storage_seek(src, header.table_offset) == 0, ESP_ERR_INVALID_SIZE, TAG, "Seek to frame table failed");
+    ESP_RETURN_ON_FALSE(media_src_storage_read(src, index->entries, table_size) == (int)table_size, ESP_ERR_INVALID_SIZE, TAG, "Read frame table failed");
+
+    /* Frames behind the end of the file (truncated copy) are not played */
+    uint32_t count = 0;
+    while (count < header.frame_count) {
+        const frame_index_entry_t *entry = &index->entries[count];
+        if ((uint64_t)entry->offset + entry->size > file_size || entry->size > header.max_frame_size) {
+            break;
+        }
+        count++;
+    }
+    ESP_RETURN_ON_FALSE(count > 0, ESP_ERR_INVALID_SIZE, TAG, "No frame in the file");
+    if (count < header.frame_count) {
+        ESP_LOGW(TAG, "Truncated file, %ld of %ld frames", count, header.frame_count);
+    }
+    index->count = count;
+    index->complete = true;
+
+    info->width = header.width;
+    info->height = header.height;
+    info->fps = (header.fps_den ? (header.fps_num + header.fps_den / 2) / header.fps_den : 0);
+    info->max_frame_size = header.max_frame_size;
+    info->align = header.align;
+    info->sampling = header.sampling;
+
+    ESP_LOGI(TAG, "SLV video %ld x %ld, %ld fps, %ld frames, max frame %ld bytes", info->width, info->height, info->fps, count, info->max_frame_size);
+    return ESP_OK;
+}
@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include "subtitle_srt.h"
+
+/* Parse time "HH:MM:SS,mmm" (dot is accepted as well) */
+static bool subtitle_srt_time(const char *text, uint32_t *time_ms)
+{
+    unsigned int h, m, s, ms;
+    char sep;
+
+    if (sscanf(text, " %u:%u:%u%c%u", &h, &m, &s, &sep, &ms) != 5 || (sep != ',' && sep != '.') || m > 59 || s > 59 || ms > 999) {
+        return false;
+    }
+    *time_ms = ((h * 60 + m) * 60 + s) * 1000 + ms;
+    return true;
+}
+
+/* Copy line without formatting tags (<i>, {\an8}) and carriage return, output never overtakes input */
+static char *subtitle_srt_copy_line(char *out, const char *line)
+{
+    char end = 0;
+
+    for (; *line; line++) {
+        if (end) {
+            if (*line == end) {
+                end = 0;
+            }
+        } else if (*line == '<') {
+            end = '>';
+        } else if (*line == '{') {
+            end = '}';
+        } else if (*line != '\r') {
+            *out++ = *line;
+        }
+    }
+    return out;
+}
+
+/* Next line, it is terminated by zero in place */
+static char *subtitle_srt_line(char **pos, char *end)
+{
+    char *line = *pos;
+
+    if (line >= end) {
+        return NULL;
+    }
+    char *eol = memchr(line, '\n', end - line);
+    if (eol == NULL) {
+        eol = end;
+    }
+    *eol = '\0';
+    *pos = eol + 1;
+    return line;
+}
+
+static bool subtitle_srt_empty(const char *line)
+{
+    return line[strspn(line, " \t\r")] == '\0';
+}
+
+static int subtitle_srt_cue_cmp(const void *a, const void *b)
+{
+    const subtitle_cue_t *cue_a = a;
+    const subtitle_cue_t *cue_b = b;
+
+    return (cue_a->start_ms > cue_b->start_ms) - (cue_a->start_ms < cue_b->start_ms);
+}
+
+esp_err_t subtitle_srt_parse(subtitle_track_t *track, char *data, uint32_t len)
+{
+    char *end = data + len;
+    char *pos = data;
+    char *line;
+    uint32_t count = 0;
+
+    memset(track, 0, sizeof(subtitle_track_t));
+
+    /* Every cue has one timing line, so cues are allocated at once */
+    for (const char *p = strstr(data, "-->"); p; p = strstr(p + 3, "-->")) {
+        count++;
+    }
+    if (count == 0) {
+        free(data);
+        return ESP_ERR_NOT_FOUND;
+    }
+    track->cues = calloc(count, sizeof(subtitle_cue_t));
+    if (track->cues == NULL) {
+        free(data);
+        return ESP_ERR_NO_MEM;
+    }
+    track->data = data;
+
+    /* UTF-8 byte order mark */
+    if (len >= 3 && memcmp(pos, "\xef\xbb\xbf", 3) == 0) {
+        pos += 3;
+    }
+
+    /* Sequence number line is not needed, cue starts with timing line and ends with empty line */
+    while ((line = subtitle_srt_line(&pos, end)) != NULL) {
+        char *arrow = strstr(line, "-->");
+        subtitle_cue_t *cue = &track->cues[track->count];
+        if (arrow == NULL || !subtitle_srt_time(line, &cue->start_ms) || !subtitle_srt_time(arrow + 3, &cue->end_ms)) {
+            continue;
+        }
+
+        /* Lines of text are joined in place */
+        char *text = pos;
+        char *out = pos;
+        char *next = pos;
+        while ((line = subtitle_srt_line(&next, end)) != NULL && !subtitle_srt_empty(line)) {
+            if (out != text) {
+                *out++ = '\n';
+            }
+            out = subtitle_srt_copy_line(out, line);
+        }
+        pos = next;
+        *out = '\0';
+        if (out != text && cue->end_ms > cue->start_ms) {
+            cue->text = text;
+            track->count++;
+        }
+    }
+    if (track->count == 0) {
+        subtitle_srt_free(track);
+        return ESP_ERR_NOT_FOUND;
+    }
+    qsort(track->cues, track->count, sizeof(subtitle_cue_t), subtitle_srt_cue_cmp);
+    for (uint32_t i = 0; i < track->count; i++) {
+        track->max_duration_ms = MAX(track->max_duration_ms, track->cues[i].end_ms - track->cues[i].start_ms);
+    }
+    return ESP_OK;
+}
+
+esp_err_t subtitle_srt_load(subtitle_track_t *track, const char *path)
+{
+    struct stat st;
+
+    memset(track, 0, sizeof(subtitle_track_t));
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (st.st_size > SUBTITLE_SRT_MAX_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* Whole file is read at once, texts of cues stay in it */
+    char *data = malloc(st.st_size + 1);
+    if (data == NULL) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    const uint32_t len = fread(data, 1, st.st_size, f);
+    fclose(f);
+    data[len] = '\0';
+    return subtitle_srt_parse(track, data, len);
+}
+
+void subtitle_srt_free(subtitle_track_t *track)
+{
+    free(track->cues);
+    free(track->data);
+    memset(track, 0, sizeof(subtitle_track_t));
+}
+
+int subtitle_srt_find(const subtitle_track_t *track, uint32_t time_ms, int *next)
+{
+    /* The last cue starting before or in the time */
+    uint32_t low = 0;
+    uint32_t high = track->count;
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (track->cues[mid].start_ms <= time_ms) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (next) {
+        *next = (low < track->count ? (int)low : -1);
+    }
+    /* Earlier cue can be still shown, when the later one overlapping it ended */
+    for (uint32_t i = low; i > 0 && track->cues[i - 1].start_ms + track->max_duration_ms > time_ms; i--) {
+        if (time_ms < track->cues[i - 1].end_ms) {
+            return i - 1;
+        }
+    }
+    return -1;
+}
+
+int subtitle_srt_slot(const int *cues, int count, int active, int next)
+{
+    for (int i = 0; i < count; i++) {
+        if (cues[i] < 0) {
+            return i;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (cues[i] != active && cues[i] != next) {
+            return i;
+        }
+    }
+    return -1;
+}
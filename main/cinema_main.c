@@ -6,7 +6,6 @@
 
 #include <string.h>
 #include <fcntl.h>
-#include <dirent.h>
 #include "esp_log.h"
 #include "bsp/esp-bsp.h"
 #include "esp_lvgl_simple_player.h"
@@ -14,53 +13,89 @@
 static const char *TAG = "APP";
 #define APP_SUPPORT_USB_MOUSE    (1)
 #define APP_SUPPORT_USB_KEYBOARD (1)
-#define APP_SUPPORT_FILE_EXT     ".mjpeg"
+#define APP_SUPPORT_FILE_EXT     ".mjpeg;.avi;.slv"
 
 // LVGL image declare
 LV_IMG_DECLARE(breaking_news)
 
 #define APP_VIDEO_FILE "01_P4_vertical_540x960.mjpeg"
 #define APP_VIDEO_FILE_PATH BSP_SD_MOUNT_POINT"/"APP_VIDEO_FILE
+#define APP_THUMB_CACHE_DIR BSP_SD_MOUNT_POINT"/.thumbs"
+#define APP_LIBRARY_DB      BSP_SD_MOUNT_POINT"/.media.db"
+#define APP_FILES_BUFF_SIZE (2048)
+#define APP_THUMB_WIDTH     (96)
+#define APP_THUMB_HEIGHT    (54)
+#define APP_VIDEO_BUFF_SIZE (540*960)
 #define APP_BREAKING_NEWS_TEXT  "New ESP32P4 chip is here! This demo was made with ESP-BSP and LVGL port (with LVGL9). *** Demo can be downloaded here: https://github.com/espzav/Simple-LVGL-Player ***"
 
-static char file_path[50] = "";
-static lv_obj_t * img_breaking_news;
+static char file_path[PLAYER_PATH_MAX] = "";
+static char files[APP_FILES_BUFF_SIZE] = "";
+static lv_obj_t * dd_files;
+static int overlay_breaking_news = -1;
 static lv_obj_t * row_edit;
 static lv_obj_t * lbl_breaking_news;
+static lv_obj_t * canvas_thumb;
+static uint8_t thumb_buff[APP_THUMB_WIDTH * APP_THUMB_HEIGHT * 2];
 static int sel_file = 0;
 
-static char * app_get_video_files(char * buff, uint32_t size)
+/* Fill list of library files (relative to SD card) and select the current file */
+static void app_get_video_files(char * buff, uint32_t size)
 {
-    int i = 0;
+    esp_lvgl_simple_player_media_info_t info;
+    const uint32_t root_len = strlen(BSP_SD_MOUNT_POINT"/");
+    const char * current = (file_path[0] ? file_path + root_len : APP_VIDEO_FILE);
     uint32_t len = 0;
-    struct dirent *dir;
-    DIR *d;
-    char * file = NULL;
 
-    /* Open directory */
-    d = opendir(BSP_SD_MOUNT_POINT);
-    if (d != NULL) {
-        /* Show button in the list for file of directory (Note: Directories are not supported in SPIFFS) */
-        while ((dir = readdir(d)) != NULL) {
-            if (dir->d_type != DT_DIR) {
-                if (strstr(dir->d_name, APP_SUPPORT_FILE_EXT) != NULL) {
-                    file = buff+len;
-                    len += snprintf(buff+len, size-len, "%s\n", dir->d_name);
-                    if (strcmp(dir->d_name, APP_VIDEO_FILE) == 0) {
-                        sel_file = i;
-                    }
-                }
-            }
-            i++;
+    buff[0] = 0;
+    sel_file = 0;
+    for (uint32_t i = 0; esp_lvgl_simple_player_library_get(i, &info) == ESP_OK; i++) {
+        const char * name = info.path + root_len;
+        if (len + strlen(name) + 1 >= size) {
+            ESP_LOGW(TAG, "Not all files fit into the list");
+            break;
+        }
+        len += snprintf(buff+len, size-len, "%s%s", (i > 0 ? "\n" : ""), name);
+        if (strcmp(name, current) == 0) {
+            sel_file = i;
         }
-        /* Remove last new line */
-        buff[len-1] = 0;
+    }
+}
 
-        closedir(d);
+/* Called from library task, when scanning found new, changed or removed files */
+static void app_library_changed(void * user_ctx)
+{
+    lvgl_port_lock(0);
+    if (dd_files) {
+        app_get_video_files(files, sizeof(files));
+        lv_dropdown_set_options(dd_files, files);
+        lv_dropdown_set_selected(dd_files, sel_file);
+    }
+    lvgl_port_unlock();
+}
+
+/* Called from LVGL task, when the thumbnail is in the buffer */
+static void app_thumbnail_ready(esp_err_t result, const esp_lvgl_simple_player_thumb_cfg_t * cfg, void * user_ctx)
+{
+    if (result != ESP_OK) {
+        memset(thumb_buff, 0, sizeof(thumb_buff));
+    }
+    lv_obj_invalidate(canvas_thumb);
+}
+
+/* Thumbnail is decoded in background, so scrolling the file list does not block UI */
+static void app_show_thumbnail(const char * path)
+{
+    esp_lvgl_simple_player_thumb_cfg_t thumb_cfg = {
+        .file = path,
+        .position = 100,
+        .buff_size = APP_VIDEO_BUFF_SIZE,
+        .width = APP_THUMB_WIDTH,
+        .height = APP_THUMB_HEIGHT,
+        .buff = thumb_buff,
+    };
+    if (esp_lvgl_simple_player_get_thumbnail_async(&thumb_cfg, app_thumbnail_ready, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Thumbnail request failed");
     }
-    
-    /* Return last filename */
-    return file;
 }
 
 static void file_changed(lv_event_t * e)
@@ -72,6 +107,7 @@ static void file_changed(lv_event_t * e)
         lv_dropdown_get_selected_str(obj, file_path+len, sizeof(file_path)-len);
         esp_lvgl_simple_player_change_file(file_path);
         esp_lvgl_simple_player_stop();
+        app_show_thumbnail(file_path);
     }
 }
 
@@ -80,12 +116,13 @@ static void breaking_news_changed(lv_event_t * e)
     lv_event_code_t code = lv_event_get_code(e);
     lv_obj_t * obj = lv_event_get_target(e);
     if(code == LV_EVENT_VALUE_CHANGED) {
-        if (img_breaking_news) {
+        if (overlay_breaking_news >= 0) {
             const bool state = (lv_obj_get_state(obj) & LV_STATE_CHECKED);
+            esp_lvgl_simple_player_overlay_show(overlay_breaking_news, state);
             if (state) {
-                lv_obj_remove_flag(img_breaking_news, LV_OBJ_FLAG_HIDDEN);
+                lv_obj_remove_flag(lbl_breaking_news, LV_OBJ_FLAG_HIDDEN);
             } else {
-                lv_obj_add_flag(img_breaking_news, LV_OBJ_FLAG_HIDDEN);
+                lv_obj_add_flag(lbl_breaking_news, LV_OBJ_FLAG_HIDDEN);
             }
         }
     }
@@ -139,9 +176,14 @@ static void app_show_ui(void)
     lv_obj_set_style_bg_color(cont_col, lv_color_black(), 0);
     lv_obj_set_style_border_width(cont_col, 0, 0);
    
-    char files[300] = "";
-    char * filename;
-    filename = app_get_video_files(files, sizeof(files));
+    /* Files from the last scan, the list is refreshed when the library scan finds changes */
+    esp_lvgl_simple_player_media_info_t info;
+    app_get_video_files(files, sizeof(files));
+    if (esp_lvgl_simple_player_library_get(sel_file, &info) == ESP_OK) {
+        snprintf(file_path, sizeof(file_path), "%s", info.path);
+    } else {
+        snprintf(file_path, sizeof(file_path), "%s", APP_VIDEO_FILE_PATH);
+    }
     
     lv_obj_t *cont_row = lv_obj_create(cont_col);
     lv_obj_set_size(cont_row, BSP_LCD_H_RES - 20, 80);
@@ -153,12 +195,16 @@ static void app_show_ui(void)
     lv_obj_set_style_border_width(cont_row, 0, 0);
     
     /* Dropdown files */
-    lv_obj_t * dd = lv_dropdown_create(cont_row);
-    lv_obj_set_width(dd, BSP_LCD_H_RES/3);
-    lv_dropdown_set_options(dd, files);
-    lv_obj_add_event_cb(dd, file_changed, LV_EVENT_VALUE_CHANGED, NULL);
-    lv_dropdown_set_selected(dd, sel_file);
-    lv_obj_set_style_pad_top(dd, 5, 0);
+    dd_files = lv_dropdown_create(cont_row);
+    lv_obj_set_width(dd_files, BSP_LCD_H_RES/3);
+    lv_dropdown_set_options(dd_files, files);
+    lv_obj_add_event_cb(dd_files, file_changed, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_dropdown_set_selected(dd_files, sel_file);
+    lv_obj_set_style_pad_top(dd_files, 5, 0);
+
+    /* Poster frame of selected file */
+    canvas_thumb = lv_canvas_create(cont_row);
+    lv_canvas_set_buffer(canvas_thumb, thumb_buff, APP_THUMB_WIDTH, APP_THUMB_HEIGHT, LV_COLOR_FORMAT_RGB565);
     
     /* Checkbox - hide controls */
     lv_obj_t * cb = lv_checkbox_create(cont_row);
@@ -203,26 +249,32 @@ static void app_show_ui(void)
     lv_obj_add_event_cb(btn_save, save_event_cb, LV_EVENT_CLICKED, text_ta);
 
     /* Create player */
-    snprintf(file_path, sizeof(file_path), "%s/%s", BSP_SD_MOUNT_POINT, filename);
     esp_lvgl_simple_player_cfg_t player_cfg = {
         .file = file_path,
         .screen = cont_col,
         .screen_width = BSP_LCD_H_RES,
         .screen_height = (BSP_LCD_V_RES/2),
-        .buff_size = 540*960,
+        .buff_size = APP_VIDEO_BUFF_SIZE,
         .flags = {
             .auto_height = true,
+            .seek_enabled = true,
+            .scrub_preview = true,
         }
     };
     esp_lvgl_simple_player_create(&player_cfg);
+    app_show_thumbnail(file_path);
     
-    /* Breaking news image */
-    img_breaking_news = lv_img_create(lv_screen_active());
-    lv_img_set_src(img_breaking_news, &breaking_news);
-    lv_obj_align(img_breaking_news, LV_ALIGN_BOTTOM_MID, 0, 0);
+    /* Breaking news image is blended into video frames, only scrolling text is rendered by LVGL */
+    const esp_lvgl_simple_player_overlay_cfg_t overlay_cfg = {
+        .image = &breaking_news,
+        .align = LV_ALIGN_BOTTOM_MID,
+    };
+    if (esp_lvgl_simple_player_overlay_add(&overlay_cfg, &overlay_breaking_news) != ESP_OK) {
+        ESP_LOGW(TAG, "Breaking news overlay cannot be added");
+    }
     
-    lbl_breaking_news = lv_label_create(img_breaking_news);
-    lv_obj_set_width(lbl_breaking_news, BSP_LCD_H_RES - 155);
+    lbl_breaking_news = lv_label_create(esp_lvgl_simple_player_get_video_obj());
+    lv_obj_set_width(lbl_breaking_news, lv_pct(80));
     lv_label_set_text(lbl_breaking_news, APP_BREAKING_NEWS_TEXT);
     lv_obj_set_style_text_font(lbl_breaking_news, &lv_font_montserrat_16, 0);
     lv_label_set_long_mode(lbl_breaking_news, LV_LABEL_LONG_SCROLL_CIRCULAR);
@@ -238,6 +290,16 @@ void app_main(void)
 {
     /* Initialize SD card */
 	bsp_sdcard_mount();
+    esp_lvgl_simple_player_thumbnail_cache(APP_THUMB_CACHE_DIR);
+    /* Video files with metadata from the last scan */
+    const esp_lvgl_simple_player_library_cfg_t library_cfg = {
+        .root = BSP_SD_MOUNT_POINT,
+        .db_file = APP_LIBRARY_DB,
+        .extensions = APP_SUPPORT_FILE_EXT,
+        .max_depth = 2,
+        .changed_cb = app_library_changed,
+    };
+    esp_lvgl_simple_player_library_open(&library_cfg);
     /* Initialize display */
     bsp_display_cfg_t disp_cfg = {
         .lvgl_port_cfg = {